@@ -0,0 +1,104 @@
+// aho_corasick.cpp — multi-pattern matcher for pinned highlight terms
+
+#include "aho_corasick.h"
+
+namespace {
+
+static inline unsigned char ascii_lower(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c - 'A' + 'a') : c;
+}
+
+} // namespace
+
+void AhoCorasick::clear() {
+    delta_.clear();
+    out_.clear();
+    dict_.clear();
+    term_len_.clear();
+}
+
+size_t AhoCorasick::memory_bytes() const {
+    return delta_.capacity() * sizeof(int32_t) +
+           out_.capacity() * sizeof(int32_t) +
+           dict_.capacity() * sizeof(int32_t) +
+           term_len_.capacity() * sizeof(size_t);
+}
+
+void AhoCorasick::build(const std::vector<std::string>& terms, bool case_sensitive) {
+    clear();
+    fold_ = !case_sensitive;
+
+    // trie
+    delta_.assign(256, -1);
+    out_.assign(1, -1);
+
+    for (size_t id = 0; id < terms.size(); ++id) {
+        const std::string& term = terms[id];
+        term_len_.push_back(term.size());
+        if (term.empty()) continue;
+
+        int32_t state = 0;
+        for (unsigned char c : term) {
+            if (fold_) c = ascii_lower(c);
+            int32_t next = delta_[(size_t)state * 256 + c];
+            if (next < 0) {
+                next = (int32_t)out_.size();
+                out_.push_back(-1);
+                delta_.resize(delta_.size() + 256, -1);
+                delta_[(size_t)state * 256 + c] = next;
+            }
+            state = next;
+        }
+        if (out_[state] < 0) out_[state] = (int32_t)id;   // duplicates keep the first id
+    }
+
+    // failure links, folded into the transition table breadth-first
+    const size_t n = out_.size();
+    std::vector<int32_t> fail(n, 0);
+    std::vector<int32_t> order;
+    order.reserve(n);
+    dict_.assign(n, -1);
+
+    for (int c = 0; c < 256; ++c) {
+        int32_t t = delta_[c];
+        if (t < 0) delta_[c] = 0;
+        else {
+            fail[t] = 0;
+            order.push_back(t);
+        }
+    }
+
+    for (size_t head = 0; head < order.size(); ++head) {
+        const int32_t s = order[head];
+        const int32_t f = fail[s];
+        dict_[s] = out_[f] >= 0 ? f : dict_[f];
+
+        for (int c = 0; c < 256; ++c) {
+            int32_t& t = delta_[(size_t)s * 256 + c];
+            if (t < 0) {
+                t = delta_[(size_t)f * 256 + c];
+            } else {
+                fail[t] = delta_[(size_t)f * 256 + c];
+                order.push_back(t);
+            }
+        }
+    }
+}
+
+void AhoCorasick::scan(const char* data, size_t len,
+                       const std::function<void(size_t, size_t, size_t)>& cb) const {
+    if (term_len_.empty() || out_.size() < 2 || !data) return;
+
+    const unsigned char* p = (const unsigned char*)data;
+    int32_t state = 0;
+
+    for (size_t i = 0; i < len; ++i) {
+        unsigned char c = fold_ ? ascii_lower(p[i]) : p[i];
+        state = delta_[(size_t)state * 256 + c];
+
+        for (int32_t s = out_[state] >= 0 ? state : dict_[state]; s >= 0; s = dict_[s]) {
+            const size_t id = (size_t)out_[s];
+            cb(id, i + 1 - term_len_[id], i + 1);
+        }
+    }
+}
@@ -0,0 +1,35 @@
+// aho_corasick.h — multi-pattern matcher for pinned highlight terms
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Byte-level Aho-Corasick automaton compiled to a dense DFA, so one pass over
+// the text finds every occurrence of every term. ASCII letters are folded
+// when built caseless; other bytes compare exactly.
+class AhoCorasick {
+public:
+    void build(const std::vector<std::string>& terms, bool case_sensitive);
+    void clear();
+
+    bool empty() const { return term_len_.empty(); }
+    size_t term_count() const { return term_len_.size(); }
+    size_t state_count() const { return out_.size(); }
+    size_t memory_bytes() const;
+
+    // Calls cb(term, start, end) with byte offsets for every occurrence,
+    // ordered by end offset. Overlapping occurrences are all reported.
+    void scan(const char* data, size_t len,
+              const std::function<void(size_t, size_t, size_t)>& cb) const;
+
+private:
+    std::vector<int32_t> delta_;     // state * 256 + byte -> state
+    std::vector<int32_t> out_;       // longest term ending in state, or -1
+    std::vector<int32_t> dict_;      // next state on the fail chain with output, or -1
+    std::vector<size_t> term_len_;
+    bool fold_ = false;
+};
@@ -0,0 +1,490 @@
+// bracket_matcher.cpp — matching-bracket highlight that stays bounded on huge files
+
+#include "bracket_matcher.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace {
+
+// By characters, not lines: a minified file is one line, and a chunk is
+// sliced and scanned on the UI thread when the partner lies in it.
+static const int kChunkChars = 1 << 17;
+static const int kMaxJobs = 2;               // chunk summaries in flight
+static const char kOpen[] = "([{";
+static const char kClose[] = ")]}";
+
+// Kind of bracket c is, or -1.
+static int bracket_kind(gunichar c, bool* open) {
+    if (c == 0 || c > 0x7F) return -1;
+    if (const char* p = std::strchr(kOpen, (int)c)) {
+        *open = true;
+        return (int)(p - kOpen);
+    }
+    if (const char* p = std::strchr(kClose, (int)c)) {
+        *open = false;
+        return (int)(p - kClose);
+    }
+    return -1;
+}
+
+// Positions are character offsets, so line ends (\n, \r, \r\n, U+2029)
+// never need counting.
+struct Bracket {
+    int offset;
+    bool open;
+};
+
+// Brackets of one kind in text, which starts at offset.
+static void collect(const char* text, int offset, int kind, std::vector<Bracket>* out) {
+    const char open = kOpen[kind];
+    const char close = kClose[kind];
+    for (const char* p = text; *p; p = g_utf8_next_char(p), ++offset) {
+        if (*p == open || *p == close) out->push_back(Bracket{ offset, *p == open });
+    }
+}
+
+// One chunk's text, copied on the UI thread and summarised on a worker.
+struct BracketChunkJob {
+    GCancellable* cancel = nullptr;
+    guint64 gen = 0;
+    std::string text;
+    int delta[3] = { 0, 0, 0 };
+    int min_depth[3] = { 0, 0, 0 };
+
+    ~BracketChunkJob() {
+        if (cancel) g_object_unref(cancel);
+    }
+};
+
+static void summarise_chunk_thread(GTask* task, gpointer, gpointer task_data, GCancellable*) {
+    BracketChunkJob* job = static_cast<BracketChunkJob*>(task_data);
+    int depth[3] = { 0, 0, 0 };
+    for (char c : job->text) {
+        bool open = false;
+        const int k = bracket_kind((unsigned char)c, &open);
+        if (k < 0) continue;
+        depth[k] += open ? 1 : -1;
+        job->min_depth[k] = std::min(job->min_depth[k], depth[k]);
+    }
+    std::copy(depth, depth + 3, job->delta);
+    g_task_return_boolean(task, TRUE);
+}
+
+} // namespace
+
+BracketMatcher::BracketMatcher(GtkSourceView* view) : view_(view) {
+    buffer_ = gtk_text_view_get_buffer(GTK_TEXT_VIEW(view_));
+    g_object_ref(buffer_);
+
+    // same look as GtkSourceView's own matching, taken from the scheme
+    GtkSourceStyleScheme* scheme = gtk_source_buffer_get_style_scheme(GTK_SOURCE_BUFFER(buffer_));
+    const char* names[2] = { "bracket-match", "bracket-mismatch" };
+    const char* fallback_bg[2] = { "#404040", "#202020" };
+    GtkTextTag** tags[2] = { &match_tag_, &mismatch_tag_ };
+    for (int i = 0; i < 2; ++i) {
+        gchar* fg = nullptr;
+        gchar* bg = nullptr;
+        GtkSourceStyle* style = scheme ? gtk_source_style_scheme_get_style(scheme, names[i]) : nullptr;
+        if (style) g_object_get(style, "foreground", &fg, "background", &bg, nullptr);
+        *tags[i] = gtk_text_buffer_create_tag(buffer_, nullptr,
+                                              "foreground", fg ? fg : "#FFFFFF",
+                                              "background", bg ? bg : fallback_bg[i],
+                                              "weight", PANGO_WEIGHT_BOLD,
+                                              nullptr);
+        g_free(fg);
+        g_free(bg);
+    }
+
+    GtkTextIter start;
+    gtk_text_buffer_get_start_iter(buffer_, &start);
+    // right gravity: typing at a highlighted bracket pushes the mark along with it
+    shown_[0] = gtk_text_buffer_create_mark(buffer_, nullptr, &start, FALSE);
+    shown_[1] = gtk_text_buffer_create_mark(buffer_, nullptr, &start, FALSE);
+
+    Chunk first;
+    first.chars = gtk_text_buffer_get_char_count(buffer_);
+    first.gen = next_gen_++;
+    chunks_.push_back(first);
+    split_chunk(0);
+
+    g_signal_connect(buffer_, "notify::cursor-position", G_CALLBACK(BracketMatcher::s_on_cursor_notify), this);
+    g_signal_connect_after(buffer_, "insert-text", G_CALLBACK(BracketMatcher::s_on_insert_text), this);
+    g_signal_connect(buffer_, "delete-range", G_CALLBACK(BracketMatcher::s_on_before_delete), this);
+    g_signal_connect_after(buffer_, "delete-range", G_CALLBACK(BracketMatcher::s_on_after_delete), this);
+
+    cancel_ = g_cancellable_new();
+}
+
+BracketMatcher::~BracketMatcher() {
+    g_cancellable_cancel(cancel_);         // in-flight chunks are dropped on completion
+    g_object_unref(cancel_);
+    if (update_id_) g_source_remove(update_id_);
+    if (build_id_) g_source_remove(build_id_);
+
+    g_signal_handlers_disconnect_by_data(buffer_, this);
+    g_object_unref(buffer_);
+}
+
+void BracketMatcher::set_scan_chars(int chars) {
+    scan_chars_ = std::max(1, chars);
+    schedule_update();
+}
+
+void BracketMatcher::set_enabled(bool on) {
+    enabled_ = on;
+    schedule_update();
+}
+
+size_t BracketMatcher::memory_bytes() const {
+    return chunks_.capacity() * sizeof(Chunk);
+}
+
+// ───── highlight ─────
+
+void BracketMatcher::schedule_update() {
+    // ahead of the redraw, so the highlight lands in the frame the cursor moves in
+    if (!update_id_) update_id_ = g_idle_add_full(G_PRIORITY_HIGH_IDLE + 10, BracketMatcher::s_on_update, this, nullptr);
+}
+
+void BracketMatcher::update() {
+    clear_shown();
+    waiting_ = false;
+    if (!enabled_) return;
+
+    // the bracket after the cursor, else the one before it
+    GtkTextIter at;
+    gtk_text_buffer_get_iter_at_mark(buffer_, &at, gtk_text_buffer_get_insert(buffer_));
+    bool open = false;
+    int kind = bracket_kind(gtk_text_iter_get_char(&at), &open);
+    if (kind < 0) {
+        if (!gtk_text_iter_backward_char(&at)) return;
+        kind = bracket_kind(gtk_text_iter_get_char(&at), &open);
+        if (kind < 0) return;
+    }
+
+    GtkTextIter match;
+    const Result r = open ? find_forward(&at, kind, &match) : find_backward(&at, kind, &match);
+    if (r == Result::Found) show(&at, &match, true);
+    else if (r == Result::NotFound) show(&at, nullptr, false);
+    else waiting_ = true;
+}
+
+void BracketMatcher::clear_shown() {
+    if (!shown_valid_) return;
+    for (GtkTextMark* m : shown_) {
+        GtkTextIter a, b;
+        gtk_text_buffer_get_iter_at_mark(buffer_, &a, m);
+        b = a;
+        gtk_text_iter_forward_char(&b);
+        gtk_text_buffer_remove_tag(buffer_, match_tag_, &a, &b);
+        gtk_text_buffer_remove_tag(buffer_, mismatch_tag_, &a, &b);
+    }
+    shown_valid_ = false;
+}
+
+void BracketMatcher::show(const GtkTextIter* a, const GtkTextIter* b, bool found) {
+    GtkTextTag* tag = found ? match_tag_ : mismatch_tag_;
+    // syntax tags are created lazily and would otherwise win
+    GtkTextTagTable* table = gtk_text_buffer_get_tag_table(buffer_);
+    gtk_text_tag_set_priority(tag, gtk_text_tag_table_get_size(table) - 1);
+
+    const GtkTextIter* ends[2] = { a, b ? b : a };
+    for (int i = 0; i < 2; ++i) {
+        GtkTextIter e = *ends[i];
+        gtk_text_iter_forward_char(&e);
+        gtk_text_buffer_apply_tag(buffer_, tag, ends[i], &e);
+        gtk_text_buffer_move_mark(buffer_, shown_[i], ends[i]);
+    }
+    shown_valid_ = true;
+}
+
+bool BracketMatcher::in_string_or_comment(int offset) const {
+    GtkTextIter it;
+    gtk_text_buffer_get_iter_at_offset(buffer_, &it, offset);
+    GtkSourceBuffer* srcb = GTK_SOURCE_BUFFER(buffer_);
+    return gtk_source_buffer_iter_has_context_class(srcb, &it, "string") ||
+           gtk_source_buffer_iter_has_context_class(srcb, &it, "comment");
+}
+
+// ───── search ─────
+
+bool BracketMatcher::index_ready(size_t from, size_t to) const {
+    for (size_t i = from; i < to; ++i)
+        if (!chunks_[i].valid) return false;
+    return true;
+}
+
+BracketMatcher::Result BracketMatcher::find_forward(const GtkTextIter* open, int kind, GtkTextIter* match) {
+    // strings and comments are skipped near the cursor, unless the bracket is in one
+    const bool contexts = gtk_source_buffer_get_highlight_syntax(GTK_SOURCE_BUFFER(buffer_)) &&
+        !in_string_or_comment(gtk_text_iter_get_offset(open));
+
+    GtkTextIter s = *open, e;
+    gtk_text_iter_forward_char(&s);
+    e = s;
+    gtk_text_iter_forward_chars(&e, scan_chars_);
+
+    std::vector<Bracket> br;
+    gchar* text = gtk_text_buffer_get_slice(buffer_, &s, &e, TRUE);
+    collect(text, gtk_text_iter_get_offset(&s), kind, &br);
+    g_free(text);
+
+    int depth = 1;
+    auto scan = [&](bool skip_contexts) {
+        for (const Bracket& b : br) {
+            if (skip_contexts && in_string_or_comment(b.offset)) continue;
+            depth += b.open ? 1 : -1;
+            if (depth == 0) {
+                gtk_text_buffer_get_iter_at_offset(buffer_, match, b.offset);
+                return true;
+            }
+        }
+        return false;
+    };
+    if (scan(contexts)) return Result::Found;
+    if (gtk_text_iter_is_end(&e)) return Result::NotFound;
+
+    // beyond the bound: the rest of this chunk, then whole chunks
+    int first = 0;
+    const size_t c = chunk_at(gtk_text_iter_get_offset(&e), &first);
+    if (!index_ready(c + 1, chunks_.size())) {
+        want_index_ = true;
+        schedule_build();
+        return Result::Unknown;
+    }
+
+    first += chunks_[c].chars;
+    GtkTextIter next;
+    gtk_text_buffer_get_iter_at_offset(buffer_, &next, first);
+    br.clear();
+    text = gtk_text_buffer_get_slice(buffer_, &e, &next, TRUE);
+    collect(text, gtk_text_iter_get_offset(&e), kind, &br);
+    g_free(text);
+    if (scan(false)) return Result::Found;
+
+    for (size_t i = c + 1; i < chunks_.size(); ++i) {
+        const Summary& sum = chunks_[i].summary;
+        if (depth + sum.min_depth[kind] <= 0) {
+            br.clear();
+            text = chunk_text(first, chunks_[i].chars);
+            collect(text, first, kind, &br);
+            g_free(text);
+            // the summary was for this very text, so the partner is in it
+            return scan(false) ? Result::Found : Result::Unknown;
+        }
+        depth += sum.delta[kind];
+        first += chunks_[i].chars;
+    }
+    return Result::NotFound;
+}
+
+BracketMatcher::Result BracketMatcher::find_backward(const GtkTextIter* close, int kind, GtkTextIter* match) {
+    const bool contexts = gtk_source_buffer_get_highlight_syntax(GTK_SOURCE_BUFFER(buffer_)) &&
+        !in_string_or_comment(gtk_text_iter_get_offset(close));
+
+    GtkTextIter s = *close;
+    gtk_text_iter_backward_chars(&s, scan_chars_);
+
+    std::vector<Bracket> br;
+    gchar* text = gtk_text_buffer_get_slice(buffer_, &s, close, TRUE);
+    collect(text, gtk_text_iter_get_offset(&s), kind, &br);
+    g_free(text);
+
+    int depth = 1;
+    auto scan = [&](bool skip_contexts) {
+        for (auto it = br.rbegin(); it != br.rend(); ++it) {
+            if (skip_contexts && in_string_or_comment(it->offset)) continue;
+            depth += it->open ? -1 : 1;
+            if (depth == 0) {
+                gtk_text_buffer_get_iter_at_offset(buffer_, match, it->offset);
+                return true;
+            }
+        }
+        return false;
+    };
+    if (scan(contexts)) return Result::Found;
+    if (gtk_text_iter_is_start(&s)) return Result::NotFound;
+
+    int first = 0;
+    const size_t c = chunk_at(gtk_text_iter_get_offset(&s), &first);
+    if (!index_ready(0, c)) {
+        want_index_ = true;
+        schedule_build();
+        return Result::Unknown;
+    }
+
+    GtkTextIter start;
+    gtk_text_buffer_get_iter_at_offset(buffer_, &start, first);
+    br.clear();
+    text = gtk_text_buffer_get_slice(buffer_, &start, &s, TRUE);
+    collect(text, first, kind, &br);
+    g_free(text);
+    if (scan(false)) return Result::Found;
+
+    for (size_t i = c; i-- > 0;) {
+        const Summary& sum = chunks_[i].summary;
+        first -= chunks_[i].chars;
+        if (depth + sum.min_depth[kind] - sum.delta[kind] <= 0) {
+            br.clear();
+            text = chunk_text(first, chunks_[i].chars);
+            collect(text, first, kind, &br);
+            g_free(text);
+            return scan(false) ? Result::Found : Result::Unknown;
+        }
+        depth -= sum.delta[kind];
+    }
+    return Result::NotFound;
+}
+
+// ───── chunk index ─────
+
+// Index of the chunk holding offset; first is set to its first offset.
+size_t BracketMatcher::chunk_at(int offset, int* first) const {
+    int start = 0;
+    for (size_t i = 0; i + 1 < chunks_.size(); ++i) {
+        if (offset < start + chunks_[i].chars) {
+            *first = start;
+            return i;
+        }
+        start += chunks_[i].chars;
+    }
+    *first = start;
+    return chunks_.size() - 1;
+}
+
+// Cuts an over-long chunk back to kChunkChars pieces, all unsummarised.
+void BracketMatcher::split_chunk(size_t index) {
+    const int chars = chunks_[index].chars;
+    const size_t pieces = (size_t)((chars + kChunkChars - 1) / kChunkChars);
+    if (pieces <= 1) return;
+
+    std::vector<Chunk> cut(pieces);
+    for (size_t i = 0; i < pieces; ++i) {
+        cut[i].chars = std::min(kChunkChars, chars - (int)i * kChunkChars);
+        cut[i].gen = next_gen_++;
+    }
+    chunks_.erase(chunks_.begin() + (std::ptrdiff_t)index);
+    chunks_.insert(chunks_.begin() + (std::ptrdiff_t)index, cut.begin(), cut.end());
+}
+
+// Characters [offset, offset + old_chars) became [offset, offset + new_chars).
+// The chunks they overlapped become one, which is summarised again; the
+// ones after only move.
+void BracketMatcher::range_changed(int offset, int old_chars, int new_chars) {
+    int first = 0;
+    const size_t i = chunk_at(offset, &first);
+    size_t j = i;
+    int end = first + chunks_[i].chars;
+    while (end < offset + old_chars && j + 1 < chunks_.size()) end += chunks_[++j].chars;
+
+    Chunk merged;
+    merged.chars = std::max(0, end - first - old_chars + new_chars);
+    merged.gen = next_gen_++;
+    chunks_.erase(chunks_.begin() + (std::ptrdiff_t)i + 1, chunks_.begin() + (std::ptrdiff_t)j + 1);
+    chunks_[i] = merged;
+    // an emptied chunk would never be found by chunk_at again
+    if (merged.chars == 0 && chunks_.size() > 1) chunks_.erase(chunks_.begin() + (std::ptrdiff_t)i);
+    else if (merged.chars > 2 * kChunkChars) split_chunk(i);
+
+    if (want_index_) schedule_build();
+}
+
+gchar* BracketMatcher::chunk_text(int first, int chars) const {
+    GtkTextIter s, e;
+    gtk_text_buffer_get_iter_at_offset(buffer_, &s, first);
+    gtk_text_buffer_get_iter_at_offset(buffer_, &e, first + chars);
+    return gtk_text_buffer_get_slice(buffer_, &s, &e, TRUE);
+}
+
+void BracketMatcher::schedule_build() {
+    if (!build_id_) build_id_ = g_idle_add(BracketMatcher::s_on_build, this);
+}
+
+// Starts summaries for stale chunks, a few at a time. False once none are left.
+bool BracketMatcher::build_step() {
+    int first = 0;
+    bool stale = false;
+    for (size_t i = 0; i < chunks_.size(); first += chunks_[i].chars, ++i) {
+        if (chunks_[i].valid) continue;
+        stale = true;
+        if (chunks_[i].busy) continue;
+        if (jobs_ >= kMaxJobs) break;
+        request_chunk(i, first);
+    }
+    return stale;
+}
+
+void BracketMatcher::request_chunk(size_t index, int first) {
+    Chunk& chunk = chunks_[index];
+    chunk.busy = true;
+    ++jobs_;
+
+    BracketChunkJob* job = new BracketChunkJob;
+    job->cancel = G_CANCELLABLE(g_object_ref(cancel_));
+    job->gen = chunk.gen;
+    gchar* text = chunk_text(first, chunk.chars);
+    job->text = text;
+    g_free(text);
+
+    GTask* task = g_task_new(nullptr, cancel_, BracketMatcher::s_on_chunk_done, this);
+    g_task_set_task_data(task, job, [](gpointer p) { delete static_cast<BracketChunkJob*>(p); });
+    g_task_run_in_thread(task, summarise_chunk_thread);
+    g_object_unref(task);
+}
+
+// ───── signals ─────
+
+gboolean BracketMatcher::s_on_update(gpointer ud) {
+    BracketMatcher* self = static_cast<BracketMatcher*>(ud);
+    self->update_id_ = 0;
+    self->update();
+    return G_SOURCE_REMOVE;
+}
+
+gboolean BracketMatcher::s_on_build(gpointer ud) {
+    BracketMatcher* self = static_cast<BracketMatcher*>(ud);
+    self->build_id_ = 0;
+    // the index is complete: a lookup that was waiting for it can finish
+    if (!self->build_step() && self->waiting_) self->schedule_update();
+    return G_SOURCE_REMOVE;
+}
+
+void BracketMatcher::s_on_cursor_notify(GObject*, GParamSpec*, gpointer ud) {
+    static_cast<BracketMatcher*>(ud)->schedule_update();
+}
+
+void BracketMatcher::s_on_insert_text(GtkTextBuffer*, GtkTextIter* end, gchar* text, gint len, gpointer ud) {
+    const int chars = (int)g_utf8_strlen(text, len);
+    static_cast<BracketMatcher*>(ud)->range_changed(gtk_text_iter_get_offset(end) - chars, 0, chars);
+}
+
+void BracketMatcher::s_on_before_delete(GtkTextBuffer*, GtkTextIter* start, GtkTextIter* end, gpointer ud) {
+    BracketMatcher* self = static_cast<BracketMatcher*>(ud);
+    self->delete_offset_ = gtk_text_iter_get_offset(start);
+    self->delete_chars_ = gtk_text_iter_get_offset(end) - self->delete_offset_;
+}
+
+void BracketMatcher::s_on_after_delete(GtkTextBuffer*, GtkTextIter*, GtkTextIter*, gpointer ud) {
+    BracketMatcher* self = static_cast<BracketMatcher*>(ud);
+    self->range_changed(self->delete_offset_, self->delete_chars_, 0);
+}
+
+void BracketMatcher::s_on_chunk_done(GObject*, GAsyncResult* res, gpointer ud) {
+    BracketChunkJob* job = static_cast<BracketChunkJob*>(g_task_get_task_data(G_TASK(res)));
+    if (g_cancellable_is_cancelled(job->cancel)) return;   // matcher gone
+
+    BracketMatcher* self = static_cast<BracketMatcher*>(ud);
+    --self->jobs_;
+    // chunks move and merge under edits; gens are never reused
+    for (Chunk& chunk : self->chunks_) {
+        if (chunk.gen != job->gen) continue;
+        std::copy(job->delta, job->delta + kKinds, chunk.summary.delta);
+        std::copy(job->min_depth, job->min_depth + kKinds, chunk.summary.min_depth);
+        chunk.valid = true;
+        chunk.busy = false;
+        break;
+    }
+    self->schedule_build();
+}
@@ -0,0 +1,101 @@
+// bracket_matcher.h — matching-bracket highlight that stays bounded on huge files
+
+#pragma once
+
+#include <gtk/gtk.h>
+#include <gtksourceview/gtksource.h>
+#include <cstddef>
+#include <vector>
+
+// Stands in for GtkSourceView's own bracket matching. Near the cursor the
+// partner is found by scanning at most scan_chars characters, skipping
+// brackets in strings and comments as GtkSourceView does. Past that bound
+// the search walks a per-chunk index instead: for each run of characters
+// and each bracket kind, the net depth change across the chunk and the lowest
+// depth reached scanning it forwards and backwards. Chunks that cannot
+// hold the partner are stepped over whole; only the one that does is
+// scanned. Summaries are computed on worker threads, and an edit only
+// invalidates the chunk it touched, so the index is built once (the first
+// time a partner lies beyond the bound) and then kept current. Brackets
+// in strings and comments do count in the index: highlighting contexts
+// are only ever computed near the view.
+class BracketMatcher {
+public:
+    explicit BracketMatcher(GtkSourceView* view);
+    ~BracketMatcher();
+
+    BracketMatcher(const BracketMatcher&) = delete;
+    BracketMatcher& operator=(const BracketMatcher&) = delete;
+
+    // Characters scanned directly before the index is consulted.
+    void set_scan_chars(int chars);
+    void set_enabled(bool on);
+
+    size_t memory_bytes() const;
+
+private:
+    static const int kKinds = 3;             // (), [], {}
+
+    // Scanning the chunk backwards, closes up and opens down, the lowest
+    // depth is min_depth - delta, so that is not stored.
+    struct Summary {
+        int delta[kKinds];                   // opens minus closes
+        int min_depth[kKinds];               // lowest depth reached from the start, <= 0
+    };
+    struct Chunk {
+        int chars = 0;
+        guint64 gen = 0;
+        bool valid = false;                  // summary is for gen
+        bool busy = false;                   // a job for gen is in flight
+        Summary summary{};
+    };
+    enum class Result { Found, NotFound, Unknown };
+
+    GtkSourceView* view_ = nullptr;
+    GtkTextBuffer* buffer_ = nullptr;
+    GtkTextTag* match_tag_ = nullptr;
+    GtkTextTag* mismatch_tag_ = nullptr;
+    GtkTextMark* shown_[2] = { nullptr, nullptr };
+    bool shown_valid_ = false;
+
+    bool enabled_ = true;
+    int scan_chars_ = 65536;
+    guint update_id_ = 0;
+    bool waiting_ = false;                   // last lookup needs the index
+
+    std::vector<Chunk> chunks_;
+    guint64 next_gen_ = 1;
+    bool want_index_ = false;
+    int jobs_ = 0;
+    guint build_id_ = 0;
+    GCancellable* cancel_ = nullptr;
+
+    int delete_offset_ = 0;                  // span of the deletion in progress
+    int delete_chars_ = 0;
+
+    void schedule_update();
+    void update();
+    void clear_shown();
+    void show(const GtkTextIter* a, const GtkTextIter* b, bool found);
+
+    Result find_forward(const GtkTextIter* open, int kind, GtkTextIter* match);
+    Result find_backward(const GtkTextIter* close, int kind, GtkTextIter* match);
+    bool in_string_or_comment(int offset) const;
+    bool index_ready(size_t from, size_t to) const;
+
+    void range_changed(int offset, int old_chars, int new_chars);
+    size_t chunk_at(int offset, int* first) const;
+    void split_chunk(size_t index);
+    void schedule_build();
+    bool build_step();
+    void request_chunk(size_t index, int first);
+    gchar* chunk_text(int first, int chars) const;
+
+    static gboolean s_on_update(gpointer);
+    static gboolean s_on_build(gpointer);
+    static void s_on_cursor_notify(GObject*, GParamSpec*, gpointer);
+    static void s_on_insert_text(GtkTextBuffer*, GtkTextIter*, gchar*, gint, gpointer);
+    static void s_on_before_delete(GtkTextBuffer*, GtkTextIter*, GtkTextIter*, gpointer);
+    static void s_on_after_delete(GtkTextBuffer*, GtkTextIter*, GtkTextIter*, gpointer);
+    static void s_on_chunk_done(GObject*, GAsyncResult*, gpointer);
+};
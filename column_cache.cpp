@@ -0,0 +1,143 @@
+// column_cache.cpp — character offset and visual column of a position, cheap on long lines
+
+#include "column_cache.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+static const int kShortLineBytes = 8192;    // positions this close to the line start are counted directly
+static const int kCheckpointChars = 4096;
+static const size_t kMaxLines = 4;
+
+// GtkTextBuffer ends lines at \n, \r, \r\n and U+2029.
+static bool has_line_end(const char* text, size_t bytes) {
+    return std::memchr(text, '\n', bytes) || std::memchr(text, '\r', bytes) ||
+           g_strstr_len(text, (gssize)bytes, "\xE2\x80\xA9");
+}
+
+// Text going in at a, or a deletion closing up from a to b, between a \r
+// and a \n splits or joins one line end.
+static bool splits_crlf(const GtkTextIter* a, const GtkTextIter* b) {
+    GtkTextIter prev = *a;
+    return gtk_text_iter_backward_char(&prev) && gtk_text_iter_get_char(&prev) == '\r' &&
+           gtk_text_iter_get_char(b) == '\n';
+}
+
+} // namespace
+
+ColumnCache::ColumnCache(GtkTextBuffer* buffer) : buffer_(buffer) {
+    g_object_ref(buffer_);
+    // before the default handlers, while the iterators still point at the old text
+    g_signal_connect(buffer_, "insert-text", G_CALLBACK(ColumnCache::s_on_insert_text), this);
+    g_signal_connect(buffer_, "delete-range", G_CALLBACK(ColumnCache::s_on_delete_range), this);
+}
+
+ColumnCache::~ColumnCache() {
+    g_signal_handlers_disconnect_by_data(buffer_, this);
+    g_object_unref(buffer_);
+}
+
+void ColumnCache::set_tab_width(int width) {
+    if (width == tab_width_) return;
+    tab_width_ = std::max(1, width);
+    lines_.clear();
+}
+
+size_t ColumnCache::memory_bytes() const {
+    size_t n = lines_.capacity() * sizeof(Line);
+    for (const Line& l : lines_) n += l.points.capacity() * sizeof(Checkpoint);
+    return n;
+}
+
+// Where text (starting at from) ends.
+ColumnCache::Checkpoint ColumnCache::advance(const Checkpoint& from, const char* text) const {
+    Checkpoint cp = from;
+    for (const char* p = text; *p; p = g_utf8_next_char(p)) {
+        cp.column = *p == '\t' ? (cp.column / tab_width_ + 1) * tab_width_ : cp.column + 1;
+        ++cp.offset;
+    }
+    cp.byte += (int)std::strlen(text);
+    return cp;
+}
+
+ColumnCache::Line& ColumnCache::line_entry(int line) {
+    for (Line& l : lines_) {
+        if (l.line != line) continue;
+        l.used = ++clock_;
+        return l;
+    }
+    if (lines_.size() < kMaxLines) {
+        lines_.emplace_back();
+    } else {
+        auto lru = std::min_element(lines_.begin(), lines_.end(),
+                                    [](const Line& a, const Line& b) { return a.used < b.used; });
+        std::swap(*lru, lines_.back());
+    }
+    Line& l = lines_.back();
+    l.line = line;
+    l.used = ++clock_;
+    l.points.assign(1, Checkpoint{ 0, 0, 0 });
+    return l;
+}
+
+ColumnCache::Position ColumnCache::position(const GtkTextIter* iter) {
+    const int line = gtk_text_iter_get_line(iter);
+    const int byte = gtk_text_iter_get_line_index(iter);
+
+    Checkpoint from{ 0, 0, 0 };
+    GtkTextIter a = *iter;
+    if (byte <= kShortLineBytes) {
+        gtk_text_iter_set_line_offset(&a, 0);
+    } else {
+        Line& l = line_entry(line);
+
+        // extend the checkpoints up to the position
+        while (l.points.back().byte < byte) {
+            GtkTextIter s = *iter, e;
+            gtk_text_iter_set_line_index(&s, l.points.back().byte);
+            e = s;
+            gtk_text_iter_forward_chars(&e, kCheckpointChars);
+            if (gtk_text_iter_get_line(&e) != line || gtk_text_iter_compare(&e, iter) > 0) break;
+
+            gchar* text = gtk_text_buffer_get_slice(buffer_, &s, &e, TRUE);
+            l.points.push_back(advance(l.points.back(), text));
+            g_free(text);
+        }
+
+        auto it = std::upper_bound(l.points.begin(), l.points.end(), byte,
+                                   [](int b, const Checkpoint& cp) { return b < cp.byte; });
+        from = *(it - 1);
+        gtk_text_iter_set_line_index(&a, from.byte);
+    }
+
+    gchar* text = gtk_text_buffer_get_slice(buffer_, &a, iter, TRUE);
+    const Checkpoint at = advance(from, text);
+    g_free(text);
+    return Position{ at.offset, at.column };
+}
+
+// Checkpoints at or before byte on line stay valid.
+void ColumnCache::truncate(int line, int byte) {
+    for (Line& l : lines_) {
+        if (l.line != line) continue;
+        while (l.points.size() > 1 && l.points.back().byte > byte) l.points.pop_back();
+    }
+}
+
+void ColumnCache::s_on_insert_text(GtkTextBuffer*, GtkTextIter* location, gchar* text, gint len, gpointer ud) {
+    ColumnCache* self = static_cast<ColumnCache*>(ud);
+    if (self->lines_.empty()) return;
+    const size_t bytes = len < 0 ? std::strlen(text) : (size_t)len;
+    // new lines renumber everything below; the cache only ever holds a few
+    if (has_line_end(text, bytes) || splits_crlf(location, location)) self->lines_.clear();
+    else self->truncate(gtk_text_iter_get_line(location), gtk_text_iter_get_line_index(location));
+}
+
+void ColumnCache::s_on_delete_range(GtkTextBuffer*, GtkTextIter* start, GtkTextIter* end, gpointer ud) {
+    ColumnCache* self = static_cast<ColumnCache*>(ud);
+    if (self->lines_.empty()) return;
+    if (gtk_text_iter_get_line(start) != gtk_text_iter_get_line(end) || splits_crlf(start, end)) self->lines_.clear();
+    else self->truncate(gtk_text_iter_get_line(start), gtk_text_iter_get_line_index(start));
+}
@@ -0,0 +1,57 @@
+// column_cache.h — character offset and visual column of a position, cheap on long lines
+
+#pragma once
+
+#include <gtk/gtk.h>
+#include <vector>
+
+// Counting the characters and tab stops before a position walks the whole
+// line up to it, which on a multi-megabyte line costs far more than a
+// cursor move should. For the few long lines recently asked about, this
+// keeps checkpoints every few thousand characters (byte index, character
+// offset, visual column); a query scans only from the nearest checkpoint.
+// An edit drops the checkpoints after it on the edited line; they are
+// rebuilt lazily up to the next position asked for.
+class ColumnCache {
+public:
+    struct Position {
+        int offset;      // characters from the start of the line
+        int column;      // visual column with tabs expanded, 0-based
+    };
+
+    explicit ColumnCache(GtkTextBuffer* buffer);
+    ~ColumnCache();
+
+    ColumnCache(const ColumnCache&) = delete;
+    ColumnCache& operator=(const ColumnCache&) = delete;
+
+    void set_tab_width(int width);
+    Position position(const GtkTextIter* iter);
+
+    void clear() { lines_.clear(); }
+    size_t memory_bytes() const;
+
+private:
+    struct Checkpoint {
+        int byte;
+        int offset;
+        int column;
+    };
+    struct Line {
+        int line = -1;
+        guint64 used = 0;
+        std::vector<Checkpoint> points;     // ascending; points[0] is the line start
+    };
+
+    GtkTextBuffer* buffer_ = nullptr;
+    int tab_width_ = 4;
+    std::vector<Line> lines_;
+    guint64 clock_ = 0;
+
+    Line& line_entry(int line);
+    void truncate(int line, int byte);
+    Checkpoint advance(const Checkpoint& from, const char* text) const;
+
+    static void s_on_insert_text(GtkTextBuffer*, GtkTextIter*, gchar*, gint, gpointer);
+    static void s_on_delete_range(GtkTextBuffer*, GtkTextIter*, GtkTextIter*, gpointer);
+};
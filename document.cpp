@@ -0,0 +1,144 @@
+// document.cpp — an open document while it is not the one shown
+
+#include "document.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+static const int kCompressLevel = 1;         // fast: text still shrinks 3-5x
+static const size_t kMinOutput = 4096;
+
+struct CompressJob {
+    GCancellable* cancel = nullptr;
+    guint64 gen = 0;
+    std::string text;                        // in: plain, out: compressed
+
+    ~CompressJob() {
+        if (cancel) g_object_unref(cancel);
+    }
+};
+
+// All of in through conv; false on error or when cancelled.
+static bool zlib_convert(GConverter* conv, const std::string& in, size_t size_hint,
+                         std::string* out, GCancellable* cancel) {
+    out->assign(std::max(size_hint, kMinOutput), '\0');
+    size_t read = 0, written = 0;
+    for (;;) {
+        if (cancel && g_cancellable_is_cancelled(cancel)) return false;
+        if (out->size() - written < kMinOutput) out->resize(out->size() * 2);
+
+        gsize r = 0, w = 0;
+        GError* err = nullptr;
+        const GConverterResult res = g_converter_convert(conv, in.data() + read, in.size() - read,
+                                                         &(*out)[written], out->size() - written,
+                                                         G_CONVERTER_INPUT_AT_END, &r, &w, &err);
+        if (res == G_CONVERTER_ERROR) {
+            const bool no_space = g_error_matches(err, G_IO_ERROR, G_IO_ERROR_NO_SPACE);
+            g_error_free(err);
+            if (!no_space) return false;
+            out->resize(out->size() * 2);
+            continue;
+        }
+        read += r;
+        written += w;
+        if (res == G_CONVERTER_FINISHED) break;
+    }
+    out->resize(written);
+    out->shrink_to_fit();
+    return true;
+}
+
+static void compress_thread(GTask* task, gpointer, gpointer task_data, GCancellable*) {
+    CompressJob* job = static_cast<CompressJob*>(task_data);
+    GZlibCompressor* z = g_zlib_compressor_new(G_ZLIB_COMPRESSOR_FORMAT_RAW, kCompressLevel);
+    std::string packed;
+    const bool ok = zlib_convert(G_CONVERTER(z), job->text, job->text.size() / 3, &packed, job->cancel);
+    g_object_unref(z);
+    if (ok) job->text.swap(packed);
+    g_task_return_boolean(task, ok);
+}
+
+} // namespace
+
+Document::Document(std::string p) : path(std::move(p)) {}
+
+Document::~Document() {
+    cancel_compress();
+}
+
+void Document::cancel_compress() {
+    if (!compress_cancel_) return;
+    g_cancellable_cancel(compress_cancel_);
+    g_object_unref(compress_cancel_);
+    compress_cancel_ = nullptr;
+}
+
+void Document::park(std::string text) {
+    cancel_compress();
+    ++gen_;
+    plain_bytes_ = text.size();
+    text_ = std::move(text);
+    text_.shrink_to_fit();
+    storage_ = Storage::Plain;
+}
+
+bool Document::unpark(std::string* text) {
+    if (storage_ == Storage::OnDisk) return false;
+    if (storage_ == Storage::Compressed) {
+        GZlibDecompressor* z = g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_RAW);
+        const bool ok = zlib_convert(G_CONVERTER(z), text_, plain_bytes_ + 1, text, nullptr);
+        g_object_unref(z);
+        if (!ok) {
+            text->clear();
+            return false;
+        }
+    } else {
+        text->swap(text_);
+    }
+
+    cancel_compress();
+    ++gen_;
+    storage_ = Storage::Shown;
+    std::string().swap(text_);
+    plain_bytes_ = 0;
+    return true;
+}
+
+void Document::drop() {
+    if (!can_drop()) return;
+    cancel_compress();
+    ++gen_;
+    std::string().swap(text_);
+    plain_bytes_ = 0;
+    storage_ = Storage::OnDisk;
+}
+
+void Document::compress_in_background() {
+    if (storage_ != Storage::Plain || compress_cancel_) return;
+
+    CompressJob* job = new CompressJob;
+    job->cancel = g_cancellable_new();
+    job->gen = gen_;
+    job->text = text_;
+    compress_cancel_ = G_CANCELLABLE(g_object_ref(job->cancel));
+
+    GTask* task = g_task_new(nullptr, job->cancel, Document::s_on_compressed, this);
+    g_task_set_task_data(task, job, [](gpointer p) { delete static_cast<CompressJob*>(p); });
+    g_task_run_in_thread(task, compress_thread);
+    g_object_unref(task);
+}
+
+void Document::s_on_compressed(GObject*, GAsyncResult* res, gpointer ud) {
+    CompressJob* job = static_cast<CompressJob*>(g_task_get_task_data(G_TASK(res)));
+    if (g_cancellable_is_cancelled(job->cancel)) return;   // taken back, or closed
+
+    Document* self = static_cast<Document*>(ud);
+    g_object_unref(self->compress_cancel_);
+    self->compress_cancel_ = nullptr;
+    if (!g_task_propagate_boolean(G_TASK(res), nullptr) || job->gen != self->gen_) return;
+
+    self->text_.swap(job->text);
+    self->storage_ = Storage::Compressed;
+}
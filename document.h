@@ -0,0 +1,76 @@
+// document.h — an open document while it is not the one shown
+
+#pragma once
+
+#include <gtk/gtk.h>
+#include <cstddef>
+#include <string>
+
+#include "file_meta.h"
+#include "line_set.h"
+#include "undo_history.h"
+
+// A window shows one document at a time through its single buffer and
+// view; every other open document is parked here. Its text is kept as a
+// plain copy (cheapest to switch back to), compressed with zlib when the
+// background budget runs short and the text has unsaved changes or an
+// undo history, or dropped outright when the file on disk has it all, to
+// be reread when the tab is chosen again. Documents restored from the
+// session start out dropped. The undo history and modified lines are
+// parked along with the text.
+class Document {
+public:
+    enum class Storage {
+        Shown,          // in the buffer: nothing held here
+        Plain,
+        Compressed,
+        OnDisk,         // reread from path when shown
+    };
+
+    explicit Document(std::string path = std::string());
+    ~Document();
+
+    Document(const Document&) = delete;
+    Document& operator=(const Document&) = delete;
+
+    std::string path;                        // empty: untitled
+    bool modified = false;
+    bool long_lines = false;                 // long-line mode
+    FileMeta view;                           // cursor, scroll, tabs, line ending
+    guint64 last_shown = 0;                  // for the budget: oldest goes first
+    guint64 mtime_us = 0;                    // the file's when parked
+    UndoHistory::State history;
+    LineSet modified_lines;
+
+    // owned by the window's notebook
+    GtkWidget* page = nullptr;
+    GtkWidget* label = nullptr;
+
+    Storage storage() const { return storage_; }
+    bool can_drop() const { return !modified && !path.empty() && history.undo.empty() && history.redo.empty(); }
+
+    // Takes the buffer's text when another document is shown.
+    void park(std::string text);
+    // The text back for the buffer; false when it must be reread from path,
+    // or when compressed text will not unpack, which stays parked as it is.
+    bool unpark(std::string* text);
+    void drop();
+
+    // Compressing runs on a worker; the result is kept only if the text was
+    // not taken back meanwhile.
+    void compress_in_background();
+    bool compressing() const { return compress_cancel_ != nullptr; }
+
+    size_t memory_bytes() const { return text_.capacity(); }
+    size_t text_bytes() const { return plain_bytes_; }
+
+private:
+    Storage storage_ = Storage::Shown;
+    std::string text_;                       // plain or zlib-compressed
+    size_t plain_bytes_ = 0;
+    guint64 gen_ = 0;                        // bumped whenever text_ changes hands
+    GCancellable* compress_cancel_ = nullptr;
+
+    void cancel_compress();
+    static void s_on_compressed(GObject*, GAsyncResult*, gpointer);
+};
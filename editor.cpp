@@ -1,6 +1,15 @@
 // editor.cpp — COLOSSUS Editor implementation (GTK3 + GtkSourceView-3 compatible)
 
 #include "editor.h"
+#include "fast_scroll.h"
+#include "file_meta.h"
+#include "memory_stats.h"
+#include "recent_files.h"
+#include "startup_profile.h"
+#include "text_search.h"
+#include "trace.h"
+
+#include <glib/gstdio.h>
 
 #include <algorithm>
 #include <cctype>
@@ -11,12 +20,34 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
+// Full scan for the results panel; the worker hands hits over in batches
+// that the UI thread drains while the scan is still running.
+struct MatchScanJob {
+    std::string text;                   // buffer snapshot
+    std::string query;
+    bool case_sensitive = false;
+    bool regex = false;
+    GCancellable* cancel = nullptr;
+
+    GMutex lock;
+    std::vector<MatchIndex::Hit> pending;
+
+    MatchScanJob() { g_mutex_init(&lock); }
+    ~MatchScanJob() {
+        g_mutex_clear(&lock);
+        if (cancel) g_object_unref(cancel);
+    }
+};
+
 namespace {
 
-// Global instance for GApplication callbacks
-static Editor* g_editor_instance = nullptr;
+// Every window, oldest first, and the one focused last: the session
+static std::vector<Editor*> g_editors;
+static Editor* g_active_editor = nullptr;
+static bool g_quitting = false;              // Quit already saved the session
 
 static std::string dirname_of(const std::string& p) {
     auto pos = p.find_last_of("/\\");
@@ -38,6 +69,34 @@ static std::string rtrim_copy(std::string s) {
     return s;
 }
 
+// Runs of non-whitespace, as wc -w counts them (ASCII whitespace only).
+static gint64 count_words(const char* p, size_t len) {
+    gint64 n = 0;
+    bool in_word = false;
+    for (size_t i = 0; i < len; ++i) {
+        const unsigned char c = (unsigned char)p[i];
+        const bool space = c == ' ' || (c >= '\t' && c <= '\r');
+        if (!space && !in_word) ++n;
+        in_word = !space;
+    }
+    return n;
+}
+
+// Long-line protection: the longest line decides whether the guard shows
+// slices of the long lines and highlighting goes off; the buffer keeps the
+// file's bytes as they are.
+static size_t longest_line(const char* p, size_t len) {
+    size_t longest = 0;
+    const char* end = p + len;
+    while (p < end) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', (size_t)(end - p)));
+        const char* stop = nl ? nl : end;
+        longest = std::max(longest, (size_t)(stop - p));
+        p = stop + 1;
+    }
+    return longest;
+}
+
 // file mtime in microseconds using GIO
 static guint64 file_mtime_us_gio(const std::string& path) {
     GFile* f = g_file_new_for_path(path.c_str());
@@ -81,6 +140,167 @@ static std::string config_path() {
     return config_dir() + "/config.ini";
 }
 
+// Open Recent, shared by every window; left for the process exit to reclaim
+static RecentFiles* g_recent_files = nullptr;
+
+static RecentFiles& recent_files() {
+    if (!g_recent_files) g_recent_files = new RecentFiles(config_dir() + "/recent-files");
+    return *g_recent_files;
+}
+
+static const size_t kRecentMenuItems = 12;
+
+// cursor, scroll and options of every file opened, shared by every window
+static FileMetaStore* g_file_meta = nullptr;
+
+static FileMetaStore& file_meta() {
+    if (!g_file_meta) g_file_meta = new FileMetaStore(config_dir() + "/file-meta");
+    return *g_file_meta;
+}
+
+// From the first line break; the buffer keeps whatever the file has.
+static FileMeta::LineEnding detect_line_ending(const char* p, size_t len) {
+    const char* nl = static_cast<const char*>(std::memchr(p, '\n', len));
+    if (nl) return nl > p && nl[-1] == '\r' ? FileMeta::kEndingCRLF : FileMeta::kEndingLF;
+    return std::memchr(p, '\r', len) ? FileMeta::kEndingCR : FileMeta::kEndingUnknown;
+}
+
+// "name — ~/dir"
+static std::string recent_label(const std::string& path) {
+    std::string dir = dirname_of(path);
+    const std::string home = g_get_home_dir();
+    if (home.size() > 1 && dir.compare(0, home.size(), home) == 0 &&
+        (dir.size() == home.size() || dir[home.size()] == '/'))
+        dir = "~" + dir.substr(home.size());
+    return basename_of(path) + " — " + dir;
+}
+
+// The compiled-in colossus-mono scheme. GtkSourceView 3 only reads schemes
+// from directories, so the resource is copied once into a cache directory
+// of its own (rewritten only when it changed) and a private manager
+// searches just that: no scan of the system scheme directories. Falls back
+// to an installed copy.
+static GtkSourceStyleScheme* builtin_style_scheme() {
+    static GtkSourceStyleSchemeManager* mgr = nullptr;
+    if (mgr) return gtk_source_style_scheme_manager_get_scheme(mgr, "colossus-mono");
+
+    GBytes* data = g_resources_lookup_data("/tech/will/colossus_editor/styles/colossus-mono.xml",
+                                           G_RESOURCE_LOOKUP_FLAGS_NONE, nullptr);
+    const std::string dir = std::string(g_get_user_cache_dir()) + "/colossus-editor/styles";
+    const std::string path = dir + "/colossus-mono.xml";
+    bool ready = false;
+    if (data) {
+        gsize len = 0;
+        const char* xml = static_cast<const char*>(g_bytes_get_data(data, &len));
+        gchar* old = nullptr;
+        gsize old_len = 0;
+        ready = g_file_get_contents(path.c_str(), &old, &old_len, nullptr) &&
+                old_len == len && std::memcmp(old, xml, len) == 0;
+        g_free(old);
+        if (!ready) {
+            g_mkdir_with_parents(dir.c_str(), 0755);
+            ready = g_file_set_contents(path.c_str(), xml, (gssize)len, nullptr);
+        }
+        g_bytes_unref(data);
+    }
+
+    if (!ready) {
+        mgr = gtk_source_style_scheme_manager_get_default();
+    } else {
+        mgr = gtk_source_style_scheme_manager_new();
+        const gchar* search_path[] = { dir.c_str(), nullptr };
+        gtk_source_style_scheme_manager_set_search_path(mgr, const_cast<gchar**>(search_path));
+    }
+    return gtk_source_style_scheme_manager_get_scheme(mgr, "colossus-mono");
+}
+
+// config.ini as read at launch; the first window takes it over instead of
+// parsing the file again
+static GKeyFile* g_launch_config = nullptr;
+
+// Empty when there is no config yet. The caller frees it.
+static GKeyFile* read_config() {
+    if (GKeyFile* kf = g_launch_config) {
+        g_launch_config = nullptr;
+        return kf;
+    }
+    GKeyFile* kf = g_key_file_new();
+    g_key_file_load_from_file(kf, config_path().c_str(), G_KEY_FILE_NONE, nullptr);
+    return kf;
+}
+
+// [prefs] single_instance, read before any GTK start-up: later launches
+// then hand their files to the running instance instead of starting anew
+static bool single_instance_configured() {
+    g_launch_config = read_config();
+    return g_key_file_get_boolean(g_launch_config, "prefs", "single_instance", nullptr);
+}
+
+// Whether an instance already owns the application id on the session bus,
+// a --server or a single_instance launch; a plain launch joins it then,
+// and otherwise stays on its own.
+static bool primary_running(const char* app_id) {
+    GDBusConnection* bus = g_bus_get_sync(G_BUS_TYPE_SESSION, nullptr, nullptr);
+    if (!bus) return false;
+    GVariant* reply = g_dbus_connection_call_sync(bus, "org.freedesktop.DBus", "/org/freedesktop/DBus",
+                                                  "org.freedesktop.DBus", "NameHasOwner",
+                                                  g_variant_new("(s)", app_id), G_VARIANT_TYPE("(b)"),
+                                                  G_DBUS_CALL_FLAGS_NONE, 1000, nullptr, nullptr);
+    g_object_unref(bus);
+    if (!reply) return false;
+    gboolean owned = FALSE;
+    g_variant_get(reply, "(b)", &owned);
+    g_variant_unref(reply);
+    return owned;
+}
+
+// The documents open when the last session ended, in tab order, and which
+// was shown; files since deleted are left out.
+static std::vector<std::string> session_files(size_t* active_index) {
+    GKeyFile* kf = g_launch_config;
+    if (!kf) {
+        kf = g_key_file_new();
+        g_key_file_load_from_file(kf, config_path().c_str(), G_KEY_FILE_NONE, nullptr);
+    }
+
+    std::vector<std::string> files;
+    gsize n = 0;
+    gchar** list = g_key_file_get_string_list(kf, "session", "files", &n, nullptr);
+    const gint active = g_key_file_get_integer(kf, "session", "active", nullptr);
+    *active_index = 0;
+    for (gsize i = 0; list && i < n; ++i) {
+        if (!g_file_test(list[i], G_FILE_TEST_IS_REGULAR)) continue;
+        if ((gint)i <= active) *active_index = files.size();
+        files.push_back(list[i]);
+    }
+    g_strfreev(list);
+
+    if (kf != g_launch_config) g_key_file_free(kf);
+    return files;
+}
+
+// --startup-profile: the breakdown ends with the UI built after first paint
+static void on_app_startup(GApplication*, gpointer) {
+    startup_profile::mark("register + gtk init");
+}
+
+// "+LINE" or "+LINE:COLUMN" (the leading '+' already skipped), 1-based
+static bool parse_cli_position(const char* s, int* line, int* column) {
+    char* end = nullptr;
+    const long l = std::strtol(s, &end, 10);
+    if (end == s || l <= 0) return false;
+    long c = 0;
+    if (*end == ':') {
+        const char* cs = end + 1;
+        c = std::strtol(cs, &end, 10);
+        if (end == cs || c <= 0) return false;
+    }
+    if (*end) return false;
+    *line = (int)l;
+    *column = (int)c;
+    return true;
+}
+
 static void ensure_dir_exists(const std::string& dir) {
     GError* err = nullptr;
     if (!g_file_test(dir.c_str(), G_FILE_TEST_IS_DIR)) {
@@ -96,6 +316,250 @@ static std::string to_lower(std::string s) {
     return s;
 }
 
+// nearest ancestor holding a .git entry, else the file's own directory
+static std::string find_project_root(const std::string& file) {
+    std::string start;
+    if (!file.empty()) start = dirname_of(file);
+    else {
+        gchar* cwd = g_get_current_dir();
+        start = cwd ? cwd : ".";
+        g_free(cwd);
+    }
+
+    for (std::string d = start;; d = dirname_of(d)) {
+        if (g_file_test((d + "/.git").c_str(), G_FILE_TEST_EXISTS)) return d;
+        if (d == "/" || d == ".") break;
+    }
+    return start;
+}
+
+// index location: ~/.config/colossus-editor/index/<sha1 of root>.tri
+static std::string index_path_for_root(const std::string& root) {
+    gchar* sum = g_compute_checksum_for_string(G_CHECKSUM_SHA1, root.c_str(), -1);
+    std::string path = config_dir() + "/index/" + (sum ? sum : "default") + ".tri";
+    g_free(sum);
+    return path;
+}
+
+// ── background jobs for project search ──
+
+struct ProjectHit {
+    std::string path;
+    int line;
+    std::string text;
+};
+
+struct ProjectSearchJob {
+    std::string root;
+    std::string query;
+    bool case_sensitive = false;
+    bool walk = false;                  // no usable index: scan the whole tree
+    std::vector<std::string> files;     // candidates narrowed by the index
+    GCancellable* cancel = nullptr;
+
+    std::vector<ProjectHit> hits;
+    size_t files_scanned = 0;
+    bool truncated = false;
+
+    ~ProjectSearchJob() { if (cancel) g_object_unref(cancel); }
+};
+
+struct IndexBuildJob {
+    std::string root;
+    std::string index_path;
+    size_t memory_budget = 0;
+    std::set<std::string> dirty_before;
+    GCancellable* cancel = nullptr;
+    TrigramIndex::BuildResult result;
+
+    ~IndexBuildJob() { if (cancel) g_object_unref(cancel); }
+};
+
+struct IndexValidateJob {
+    std::string root;
+    std::vector<TrigramIndex::FileInfo> known;
+    GCancellable* cancel = nullptr;
+
+    std::vector<std::string> dirs;
+    std::vector<std::string> stale;
+
+    ~IndexValidateJob() { if (cancel) g_object_unref(cancel); }
+};
+
+struct ReplacePreviewJob {
+    std::string text;                   // buffer snapshot
+    std::string query;
+    std::string repl;
+    bool case_sensitive = false;
+    bool regex = false;
+    guint64 serial = 0;
+    int base_line = 0;                  // snapshot start (scoped replace)
+    int base_index = 0;
+    GCancellable* cancel = nullptr;
+
+    ReplacePlan plan;
+    bool ok = false;
+
+    ~ReplacePreviewJob() { if (cancel) g_object_unref(cancel); }
+};
+
+static const size_t kMaxProjectHits = 5000;
+static const size_t kMaxProjectMonitors = 512;
+
+static void project_search_thread(GTask* task, gpointer, gpointer data, GCancellable* cancel) {
+    ProjectSearchJob* job = static_cast<ProjectSearchJob*>(data);
+    if (job->walk) TrigramIndex::walk(job->root, &job->files, nullptr, cancel);
+
+    TextMatcher matcher(job->query, job->case_sensitive, false);
+
+    for (const std::string& path : job->files) {
+        if (g_cancellable_is_cancelled(cancel) || job->truncated) break;
+
+        gchar* data_buf = nullptr;
+        gsize len = 0;
+        if (!g_file_get_contents(path.c_str(), &data_buf, &len, nullptr)) continue;
+        job->files_scanned++;
+
+        if (std::memchr(data_buf, 0, std::min<gsize>(len, 8192))) {
+            g_free(data_buf);
+            continue;
+        }
+
+        int line = 1;
+        size_t counted_to = 0;
+        int last_line = 0;
+        matcher.find_all(data_buf, len, [&](size_t s, size_t) {
+            line += (int)std::count(data_buf + counted_to, data_buf + s, '\n');
+            counted_to = s;
+            if (line == last_line) return true;     // one entry per line
+            last_line = line;
+
+            const char* ls = data_buf + s;
+            while (ls > data_buf && ls[-1] != '\n') --ls;
+            const char* le = (const char*)std::memchr(data_buf + s, '\n', len - s);
+            if (!le) le = data_buf + len;
+
+            std::string text(ls, (size_t)std::min<ptrdiff_t>(le - ls, 240));
+            if (!g_utf8_validate(text.c_str(), (gssize)text.size(), nullptr)) {
+                gchar* fixed = g_utf8_make_valid(text.c_str(), (gssize)text.size());
+                text = fixed;
+                g_free(fixed);
+            }
+            job->hits.push_back(ProjectHit{ path, line, text });
+            if (job->hits.size() >= kMaxProjectHits) {
+                job->truncated = true;
+                return false;
+            }
+            return true;
+        }, cancel);
+
+        g_free(data_buf);
+    }
+
+    g_task_return_boolean(task, TRUE);
+}
+
+static void replace_preview_thread(GTask* task, gpointer, gpointer data, GCancellable* cancel) {
+    trace::Span span("replace_preview_thread");
+    ReplacePreviewJob* job = static_cast<ReplacePreviewJob*>(data);
+    job->ok = job->plan.compute(std::move(job->text), job->query, job->case_sensitive,
+                                job->regex, job->repl, cancel);
+    g_task_return_boolean(task, job->ok);
+}
+
+static const size_t kMatchBatch = 4096;
+
+static void match_scan_thread(GTask* task, gpointer, gpointer data, GCancellable* cancel) {
+    trace::Span span("match_scan_thread");
+    MatchScanJob* job = static_cast<MatchScanJob*>(data);
+    TextMatcher matcher(job->query, job->case_sensitive, job->regex);
+
+    std::vector<MatchIndex::Hit> batch;
+    auto flush = [&]() {
+        g_mutex_lock(&job->lock);
+        job->pending.insert(job->pending.end(), batch.begin(), batch.end());
+        g_mutex_unlock(&job->lock);
+        batch.clear();
+    };
+
+    MatchIndex::scan(matcher, job->text.data(), job->text.size(), 0, [&](const MatchIndex::Hit& h) {
+        batch.push_back(h);
+        if (batch.size() >= kMatchBatch) flush();
+        return true;
+    }, cancel);
+    flush();
+
+    g_task_return_boolean(task, TRUE);
+}
+
+// One line of context around a hit, match in bold, as Pango markup.
+static std::string results_snippet(GtkTextBuffer* buffer, const MatchIndex::Hit& h) {
+    if (h.line >= gtk_text_buffer_get_line_count(buffer)) return std::string();
+
+    GtkTextIter s, e;
+    gtk_text_buffer_get_iter_at_line(buffer, &s, h.line);
+    e = s;
+    if (!gtk_text_iter_ends_line(&e)) gtk_text_iter_forward_to_line_end(&e);
+    gchar* line = gtk_text_buffer_get_text(buffer, &s, &e, TRUE);
+    std::string text = line ? line : "";
+    g_free(line);
+
+    auto is_cont = [&](size_t i) { return i < text.size() && ((unsigned char)text[i] & 0xC0) == 0x80; };
+
+    const size_t ms = std::min(text.size(), (size_t)h.index);
+    const size_t me = std::min(text.size(), ms + (size_t)h.length);
+    size_t from = ms > 60 ? ms - 60 : 0;
+    while (from < ms && is_cont(from)) ++from;
+    while (from < ms && (text[from] == ' ' || text[from] == '\t')) ++from;
+    size_t to = std::min(text.size(), me + 160);
+    while (to > me && is_cont(to)) --to;
+
+    auto esc = [&](size_t a, size_t b) {
+        gchar* m = g_markup_escape_text(text.data() + a, (gssize)(b - a));
+        std::string out = m ? m : "";
+        g_free(m);
+        return out;
+    };
+    return (from > 0 && text[from - 1] != ' ' && text[from - 1] != '\t' ? "…" : "") +
+           esc(from, ms) + "<b>" + esc(ms, me) + "</b>" + esc(me, to) +
+           (to < text.size() ? "…" : "");
+}
+
+static void index_build_thread(GTask* task, gpointer, gpointer data, GCancellable* cancel) {
+    IndexBuildJob* job = static_cast<IndexBuildJob*>(data);
+    ensure_dir_exists(dirname_of(job->index_path));
+    job->result = TrigramIndex::build(job->root, job->index_path, job->memory_budget, cancel);
+    g_task_return_boolean(task, job->result.error.empty());
+}
+
+// After loading an index from disk: find files edited while we were not
+// watching, and collect the directories to watch from now on.
+static void index_validate_thread(GTask* task, gpointer, gpointer data, GCancellable* cancel) {
+    IndexValidateJob* job = static_cast<IndexValidateJob*>(data);
+
+    std::vector<std::string> files;
+    TrigramIndex::walk(job->root, &files, &job->dirs, cancel);
+
+    std::sort(job->known.begin(), job->known.end(),
+              [](const TrigramIndex::FileInfo& a, const TrigramIndex::FileInfo& b) { return a.path < b.path; });
+
+    for (const std::string& path : files) {
+        if (g_cancellable_is_cancelled(cancel)) break;
+
+        auto it = std::lower_bound(job->known.begin(), job->known.end(), path,
+                                   [](const TrigramIndex::FileInfo& a, const std::string& p) { return a.path < p; });
+        if (it == job->known.end() || it->path != path) {
+            job->stale.push_back(path);       // new since the index was built
+            continue;
+        }
+        GStatBuf st;
+        if (g_stat(path.c_str(), &st) == 0 && (guint64)st.st_mtime * 1000000ULL != it->mtime_us)
+            job->stale.push_back(path);
+    }
+
+    g_task_return_boolean(task, TRUE);
+}
+
 } // namespace
 
 // ───────────────────────────────────────────────
@@ -105,78 +569,131 @@ static std::string to_lower(std::string s) {
 Editor::Editor(GtkApplication* app)
     : app_(app)
 {
-    g_editor_instance = this;
-    load_config();
-    load_session();
+    g_editors.push_back(this);
+    g_active_editor = this;
+    trace::Span span("startup");
+    GKeyFile* kf = read_config();
+    load_config(kf);
+    load_session(kf);
+    g_key_file_free(kf);
+    startup_profile::mark("config");
     setup_ui();
+    // an empty Untitled tab, replaced by the first file opened into it
+    shown_doc_ = add_document(std::string());
+    shown_doc_->last_shown = ++show_clock_;
+    startup_profile::mark("window");
 }
 
 Editor::~Editor() {
+    // closing one of several windows drops its documents from the session;
+    // the last window keeps them
+    const bool last = g_editors.size() == 1;
+    if (!last) g_editors.erase(std::remove(g_editors.begin(), g_editors.end(), this), g_editors.end());
+    if (g_active_editor == this) g_active_editor = g_editors.back();
+    // the widgets outlive us by a moment while the window is torn down
+    g_signal_handlers_disconnect_by_data(buffer_, this);
+    g_signal_handlers_disconnect_by_data(window_, this);
+    g_signal_handlers_disconnect_by_data(text_view_, this);
+    g_signal_handlers_disconnect_by_data(gtk_scrollable_get_vadjustment(GTK_SCROLLABLE(text_view_)), this);
+
     remove_file_monitor();
+    if (finish_ui_id_) g_source_remove(finish_ui_id_);
+    if (pin_idle_id_) g_source_remove(pin_idle_id_);
+    cancel_project_jobs();
+
+    if (search_debounce_id_) g_source_remove(search_debounce_id_);
+    if (search_cancel_) {
+        g_cancellable_cancel(search_cancel_);
+        g_object_unref(search_cancel_);
+    }
+    if (highlight_id_) g_source_remove(highlight_id_);
+    delete search_matcher_;
+
+    if (replace_preview_cancel_) {
+        g_cancellable_cancel(replace_preview_cancel_);
+        g_object_unref(replace_preview_cancel_);
+    }
+    delete replace_hits_;
+
+    stop_results_scan();
+    delete results_matcher_;
+    delete results_hits_;
 
     if (search_context_) g_object_unref(search_context_);
     if (search_settings_) g_object_unref(search_settings_);
-
-    save_session();
+    delete minimap_;
+    delete ruler_;
+    delete bracket_matcher_;
+    remember_file_meta();
+    delete column_cache_;
+    delete line_guard_;
+    delete undo_;
+    g_signal_handlers_disconnect_by_data(tabs_, this);
+
+    if (!g_quitting) save_session();
     save_config();
+    if (last) {
+        g_editors.clear();
+        g_active_editor = nullptr;
+        g_quitting = false;                  // a --server instance carries on
+    }
+
+    for (Document* d : docs_) delete d;
+
+    // clients started with --wait return now
+    for (GApplicationCommandLine* cmd : waiters_) g_object_unref(cmd);
 }
 
 // ───────────────────────────────────────────────
 //  UI setup
 // ───────────────────────────────────────────────
 
+// Only what the first frame shows: the window, the view with its buffer and
+// the status bar. Menus, the search bar and the results panel follow in
+// finish_ui.
 void Editor::setup_ui() {
+    trace::Span span("Editor::setup_ui");
     window_ = gtk_application_window_new(app_);
     gtk_window_set_default_size(GTK_WINDOW(window_), 900, 700);
     gtk_window_set_title(GTK_WINDOW(window_), "Untitled — COLOSSUS Editor");
     gtk_window_set_icon_name(GTK_WINDOW(window_), "accessories-text-editor");
-
-    // Main vertical box
-    GtkWidget* vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
-    gtk_container_add(GTK_CONTAINER(window_), vbox);
-
-    // Menu bar
-    GtkWidget* menubar = create_menu_bar();
-    gtk_box_pack_start(GTK_BOX(vbox), menubar, FALSE, FALSE, 0);
+    ui_.attach(window_, [this](unsigned dirty) { flush_ui(dirty); });
+    latency_.attach(window_);
+
+    // Main vertical box; the menu bar and search bar go above the text later
+    main_box_ = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+    gtk_container_add(GTK_CONTAINER(window_), main_box_);
+
+    // Tab strip: its pages are empty, every document is shown in the one
+    // view below. Hidden while there is a single document.
+    tabs_ = gtk_notebook_new();
+    gtk_notebook_set_show_border(GTK_NOTEBOOK(tabs_), FALSE);
+    gtk_notebook_set_show_tabs(GTK_NOTEBOOK(tabs_), FALSE);
+    gtk_notebook_set_scrollable(GTK_NOTEBOOK(tabs_), TRUE);
+    gtk_widget_set_can_focus(tabs_, FALSE);
+    gtk_box_pack_start(GTK_BOX(main_box_), tabs_, FALSE, FALSE, 0);
+    // after the notebook's own handler, once the page has changed
+    g_signal_connect_after(tabs_, "switch-page", G_CALLBACK(Editor::s_on_switch_page), this);
 
     // Source buffer + view
-    lang_manager_ = gtk_source_language_manager_get_default();
     GtkSourceBuffer* src_buffer = gtk_source_buffer_new(nullptr);
-	// Load COLOSSUS monochrome style scheme (project-local ./styles)
-	GtkSourceStyleSchemeManager* scheme_mgr = gtk_source_style_scheme_manager_get_default();
-	gtk_source_style_scheme_manager_append_search_path(scheme_mgr, "./styles");
-	gtk_source_style_scheme_manager_force_rescan(scheme_mgr);
-
-	GtkSourceStyleScheme* scheme =
-    		gtk_source_style_scheme_manager_get_scheme(scheme_mgr, "colossus-mono");
-
-	if (scheme) {
-    		gtk_source_buffer_set_style_scheme(src_buffer, scheme);
-	} else {
-    g_printerr("COLOSSUS: could not find style scheme 'colossus-mono' in ./styles\n");
-}
+    // COLOSSUS monochrome style scheme, built into the binary
+    if (GtkSourceStyleScheme* scheme = builtin_style_scheme())
+        gtk_source_buffer_set_style_scheme(src_buffer, scheme);
+    else
+        g_printerr("COLOSSUS: could not load style scheme 'colossus-mono'\n");
 
     buffer_ = GTK_TEXT_BUFFER(src_buffer);
+    undo_ = new UndoHistory(src_buffer);
+    column_cache_ = new ColumnCache(buffer_);
 
     text_view_ = gtk_source_view_new_with_buffer(src_buffer);
     gtk_text_view_set_wrap_mode(GTK_TEXT_VIEW(text_view_), GTK_WRAP_NONE);
-
-    // inherit GTK theme (no forced palette), but we can set tiny CSS for current line if desired
-    // NOTE: keep minimal to respect your “match system theme” goal.
-    GtkCssProvider* provider = gtk_css_provider_new();
-    const gchar* css =
-        "GtkSourceView.view .current-line {"
-        "  background-color: rgba(0,0,0,0.10);"
-        "}\n";
-    gtk_css_provider_load_from_data(provider, css, -1, nullptr);
-    GtkStyleContext* ctx = gtk_widget_get_style_context(text_view_);
-    gtk_style_context_add_provider(ctx, GTK_STYLE_PROVIDER(provider),
-                                   GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
-    g_object_unref(provider);
+    line_guard_ = new LongLineGuard(GTK_TEXT_VIEW(text_view_));
 
     setup_sourceview_defaults();
     setup_search();
-    setup_recent();
+    setup_pins();
 
     // Scroll container
     GtkWidget* scrolled = gtk_scrolled_window_new(nullptr, nullptr);
@@ -185,16 +702,47 @@ void Editor::setup_ui() {
                                    GTK_POLICY_AUTOMATIC,
                                    GTK_POLICY_AUTOMATIC);
 
-    gtk_box_pack_start(GTK_BOX(vbox), scrolled, TRUE, TRUE, 0);
+    // overview ruler beside the scrollbar, minimap to the right of it
+    ruler_ = new OverviewRuler(GTK_SOURCE_VIEW(text_view_), &results_);
+    minimap_ = new Minimap(GTK_SOURCE_VIEW(text_view_));
+    GtkWidget* text_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
+    GtkWidget* overlay = gtk_overlay_new();
+    gtk_container_add(GTK_CONTAINER(overlay), scrolled);
+    gtk_overlay_add_overlay(GTK_OVERLAY(overlay), latency_.hud());
+    gtk_overlay_set_overlay_pass_through(GTK_OVERLAY(overlay), latency_.hud(), TRUE);
+    gtk_box_pack_start(GTK_BOX(text_box), overlay, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(text_box), ruler_->widget(), FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(text_box), minimap_->widget(), FALSE, FALSE, 0);
+    gtk_widget_set_no_show_all(ruler_->widget(), !show_ruler_);
+    gtk_widget_set_no_show_all(minimap_->widget(), !show_minimap_);
+
+    // text on top, search results panel (hidden until asked for) below
+    text_paned_ = gtk_paned_new(GTK_ORIENTATION_VERTICAL);
+    gtk_paned_pack1(GTK_PANED(text_paned_), text_box, TRUE, FALSE);
+    gtk_box_pack_start(GTK_BOX(main_box_), text_paned_, TRUE, TRUE, 0);
+
+    // viewport-driven work (pinned-term highlighting) follows scrolling and resizes
+    GtkAdjustment* vadj = gtk_scrollable_get_vadjustment(GTK_SCROLLABLE(text_view_));
+    g_signal_connect(vadj, "value-changed", G_CALLBACK(Editor::s_on_view_scrolled), this);
+    g_signal_connect(vadj, "changed", G_CALLBACK(Editor::s_on_view_scrolled), this);
 
     // Status bar (label)
     status_bar_ = gtk_label_new("");
-    gtk_box_pack_start(GTK_BOX(vbox), status_bar_, FALSE, FALSE, 4);
+    gtk_box_pack_start(GTK_BOX(main_box_), status_bar_, FALSE, FALSE, 4);
 
     // signals
     g_signal_connect(buffer_, "changed", G_CALLBACK(Editor::s_on_buffer_changed), this);
     g_signal_connect(buffer_, "notify::cursor-position", G_CALLBACK(Editor::s_on_cursor_notify), this);
+    g_signal_connect(buffer_, "mark-set", G_CALLBACK(Editor::s_on_mark_set), this);
+
+    // statistics follow each edit, taken before it while its neighbours are known
+    g_signal_connect(buffer_, "insert-text", G_CALLBACK(Editor::s_on_stats_before_insert), this);
+    g_signal_connect(buffer_, "delete-range", G_CALLBACK(Editor::s_on_stats_before_delete), this);
     g_signal_connect(window_, "key-press-event", G_CALLBACK(Editor::s_on_key_press), this);
+    g_signal_connect(window_, "delete-event", G_CALLBACK(Editor::s_on_window_delete), this);
+    g_signal_connect(window_, "destroy", G_CALLBACK(Editor::s_on_window_destroy), this);
+    g_signal_connect(window_, "focus-in-event", G_CALLBACK(Editor::s_on_window_focus_in), this);
+    g_signal_connect_after(window_, "draw", G_CALLBACK(Editor::s_on_first_draw), this);
 
     // Apply initial zoom
     zoom_set(font_pt_);
@@ -204,6 +752,49 @@ void Editor::setup_ui() {
     update_status_full();
 
     gtk_widget_show_all(window_);
+    latency_.set_hud_visible(show_latency_hud_);
+}
+
+// The rest of the UI, built once: in idle time after the first frame, or
+// earlier if a key press gets there first (accelerators need the menus).
+void Editor::finish_ui() {
+    if (ui_complete_) return;
+    ui_complete_ = true;
+    if (finish_ui_id_) {
+        g_source_remove(finish_ui_id_);
+        finish_ui_id_ = 0;
+    }
+    trace::Span span("Editor::finish_ui");
+
+    GtkWidget* menubar = create_menu_bar();
+    gtk_box_pack_start(GTK_BOX(main_box_), menubar, FALSE, FALSE, 0);
+    gtk_box_reorder_child(GTK_BOX(main_box_), menubar, 0);
+    gtk_widget_show_all(menubar);
+    startup_profile::mark("menus");
+
+    // Inline search bar (hidden until Ctrl+F)
+    GtkWidget* bar = create_search_bar();
+    gtk_box_pack_start(GTK_BOX(main_box_), bar, FALSE, FALSE, 0);
+    gtk_box_reorder_child(GTK_BOX(main_box_), bar, 2);   // below the tabs
+    gtk_widget_show_all(bar);
+    gtk_paned_pack2(GTK_PANED(text_paned_), create_results_panel(), FALSE, TRUE);
+    startup_profile::mark("search bar + results");
+
+    // inherit GTK theme (no forced palette), but we can set tiny CSS for current line if desired
+    // NOTE: keep minimal to respect your “match system theme” goal.
+    GtkCssProvider* provider = gtk_css_provider_new();
+    const gchar* css =
+        "GtkSourceView.view .current-line {"
+        "  background-color: rgba(0,0,0,0.10);"
+        "}\n";
+    gtk_css_provider_load_from_data(provider, css, -1, nullptr);
+    GtkStyleContext* ctx = gtk_widget_get_style_context(text_view_);
+    gtk_style_context_add_provider(ctx, GTK_STYLE_PROVIDER(provider),
+                                   GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+    g_object_unref(provider);
+
+    startup_profile::mark("css");
+    startup_profile::report();
 }
 
 void Editor::setup_sourceview_defaults() {
@@ -215,24 +806,90 @@ void Editor::setup_sourceview_defaults() {
     gtk_source_view_set_tab_width(GTK_SOURCE_VIEW(text_view_), tab_width_);
     gtk_source_view_set_insert_spaces_instead_of_tabs(GTK_SOURCE_VIEW(text_view_), TRUE);
 
-    // bracket matching: GtkSourceView-3 uses buffer API
-    gtk_source_buffer_set_highlight_matching_brackets(GTK_SOURCE_BUFFER(buffer_), TRUE);
+    // bracket matching: our own, bounded however far away the partner is
+    gtk_source_buffer_set_highlight_matching_brackets(GTK_SOURCE_BUFFER(buffer_), FALSE);
+    bracket_matcher_ = new BracketMatcher(GTK_SOURCE_VIEW(text_view_));
+    bracket_matcher_->set_scan_chars(std::max(1, bracket_scan_kb_) * 1024);
 
     // show right margin is optional; leaving off keeps it neutral
 }
 
+// The search settings and context are made on the first search
+// (ensure_search_context); only the tags and marks are needed up front.
 void Editor::setup_search() {
-    search_settings_ = gtk_source_search_settings_new();
-    // default: case-insensitive, wrap around on our side
-    gtk_source_search_settings_set_case_sensitive(search_settings_, FALSE);
-    gtk_source_search_settings_set_wrap_around(search_settings_, FALSE);
-
-    search_context_ = gtk_source_search_context_new(GTK_SOURCE_BUFFER(buffer_), search_settings_);
-    gtk_source_search_context_set_highlight(search_context_, TRUE);
+    // scope tint first so match highlights draw over it
+    GdkRGBA tint = { 0.5, 0.5, 0.5, 0.12 };
+    scope_tag_ = gtk_text_buffer_create_tag(buffer_, "search-scope", "background-rgba", &tint, nullptr);
+
+    // same look as the context's own highlighting, taken from the scheme
+    gchar* fg = nullptr;
+    gchar* bg = nullptr;
+    GtkSourceStyleScheme* scheme = gtk_source_buffer_get_style_scheme(GTK_SOURCE_BUFFER(buffer_));
+    GtkSourceStyle* style = scheme ? gtk_source_style_scheme_get_style(scheme, "search-match") : nullptr;
+    if (style) g_object_get(style, "foreground", &fg, "background", &bg, nullptr);
+    match_tag_ = gtk_text_buffer_create_tag(buffer_, "search-match",
+                                            "foreground", fg ? fg : "#000000",
+                                            "background", bg ? bg : "#fce94f",
+                                            nullptr);
+    g_free(fg);
+    g_free(bg);
+
+    GtkTextIter start;
+    gtk_text_buffer_get_start_iter(buffer_, &start);
+    hl_start_ = gtk_text_buffer_create_mark(buffer_, nullptr, &start, TRUE);
+    hl_end_ = gtk_text_buffer_create_mark(buffer_, nullptr, &start, FALSE);
+    rebuild_search_matcher();
 }
 
-void Editor::setup_recent() {
-    recent_mgr_ = gtk_recent_manager_get_default();
+GtkWidget* Editor::create_search_bar() {
+    search_bar_ = gtk_search_bar_new();
+    gtk_search_bar_set_show_close_button(GTK_SEARCH_BAR(search_bar_), TRUE);
+
+    GtkWidget* box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 4);
+
+    search_entry_ = gtk_search_entry_new();
+    gtk_entry_set_width_chars(GTK_ENTRY(search_entry_), 32);
+    gtk_entry_set_text(GTK_ENTRY(search_entry_), last_query_.c_str());
+    gtk_box_pack_start(GTK_BOX(box), search_entry_, FALSE, FALSE, 0);
+
+    GtkWidget* prev = gtk_button_new_from_icon_name("go-up-symbolic", GTK_ICON_SIZE_BUTTON);
+    gtk_widget_set_tooltip_text(prev, "Previous match (Ctrl+Shift+G)");
+    gtk_box_pack_start(GTK_BOX(box), prev, FALSE, FALSE, 0);
+
+    GtkWidget* next = gtk_button_new_from_icon_name("go-down-symbolic", GTK_ICON_SIZE_BUTTON);
+    gtk_widget_set_tooltip_text(next, "Next match (Enter, Ctrl+G)");
+    gtk_box_pack_start(GTK_BOX(box), next, FALSE, FALSE, 0);
+
+    search_case_btn_ = gtk_check_button_new_with_mnemonic("Match _case");
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(search_case_btn_), search_case_sensitive_);
+    gtk_box_pack_start(GTK_BOX(box), search_case_btn_, FALSE, FALSE, 6);
+
+    search_regex_btn_ = gtk_check_button_new_with_mnemonic("Re_gex");
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(search_regex_btn_), search_regex_);
+    gtk_box_pack_start(GTK_BOX(box), search_regex_btn_, FALSE, FALSE, 0);
+
+    search_scope_btn_ = gtk_check_button_new_with_mnemonic("In _selection");
+    gtk_widget_set_tooltip_text(search_scope_btn_, "Limit find and replace to the selected text");
+    gtk_box_pack_start(GTK_BOX(box), search_scope_btn_, FALSE, FALSE, 6);
+
+    search_count_label_ = gtk_label_new("");
+    gtk_box_pack_start(GTK_BOX(box), search_count_label_, FALSE, FALSE, 6);
+
+    gtk_container_add(GTK_CONTAINER(search_bar_), box);
+    gtk_search_bar_connect_entry(GTK_SEARCH_BAR(search_bar_), GTK_ENTRY(search_entry_));
+
+    g_signal_connect(search_entry_, "changed", G_CALLBACK(Editor::s_on_search_entry_changed), this);
+    g_signal_connect(search_entry_, "activate", G_CALLBACK(Editor::s_on_search_entry_activate), this);
+    g_signal_connect(search_entry_, "next-match", G_CALLBACK(Editor::s_on_search_next_match), this);
+    g_signal_connect(search_entry_, "previous-match", G_CALLBACK(Editor::s_on_search_previous_match), this);
+    g_signal_connect(prev, "clicked", G_CALLBACK(Editor::s_on_search_prev_clicked), this);
+    g_signal_connect(next, "clicked", G_CALLBACK(Editor::s_on_search_next_clicked), this);
+    g_signal_connect(search_case_btn_, "toggled", G_CALLBACK(Editor::s_on_search_option_toggled), this);
+    g_signal_connect(search_regex_btn_, "toggled", G_CALLBACK(Editor::s_on_search_option_toggled), this);
+    g_signal_connect(search_scope_btn_, "toggled", G_CALLBACK(Editor::s_on_search_scope_toggled), this);
+    g_signal_connect(search_bar_, "notify::search-mode-enabled", G_CALLBACK(Editor::s_on_search_mode_notify), this);
+
+    return search_bar_;
 }
 
 GtkWidget* Editor::create_menu_bar() {
@@ -261,20 +918,16 @@ GtkWidget* Editor::create_menu_bar() {
     add_item(file_menu, "_New", "<Control>N", G_CALLBACK(Editor::s_on_new_activate));
     add_item(file_menu, "_Open…", "<Control>O", G_CALLBACK(Editor::s_on_open_activate));
 
-    // Open Recent submenu
-    GtkWidget* recent_item = gtk_menu_item_new_with_mnemonic("Open _Recent");
-    GtkWidget* recent_menu = gtk_recent_chooser_menu_new_for_manager(recent_mgr_);
-    gtk_recent_chooser_set_show_icons(GTK_RECENT_CHOOSER(recent_menu), TRUE);
-    gtk_recent_chooser_set_limit(GTK_RECENT_CHOOSER(recent_menu), 12);
-    gtk_recent_chooser_set_sort_type(GTK_RECENT_CHOOSER(recent_menu), GTK_RECENT_SORT_MRU);
-    g_signal_connect(recent_menu, "item-activated", G_CALLBACK(Editor::s_on_recent_activated), this);
-    gtk_menu_item_set_submenu(GTK_MENU_ITEM(recent_item), recent_menu);
-    gtk_menu_shell_append(GTK_MENU_SHELL(file_menu), recent_item);
+    // Open Recent submenu, (re)built when the File menu opens
+    recent_item_ = gtk_menu_item_new_with_mnemonic("Open _Recent");
+    gtk_menu_shell_append(GTK_MENU_SHELL(file_menu), recent_item_);
+    g_signal_connect(file_menu, "show", G_CALLBACK(Editor::s_on_file_menu_show), this);
 
     add_item(file_menu, "_Save", "<Control>S", G_CALLBACK(Editor::s_on_save_activate));
     add_item(file_menu, "Save _As…", "<Shift><Control>S", G_CALLBACK(Editor::s_on_save_as_activate));
     add_item(file_menu, "_Reload from Disk", "F5", G_CALLBACK(Editor::s_on_reload_activate));
     add_item(file_menu, "Open _Containing Folder", "<Control><Shift>O", G_CALLBACK(Editor::s_on_open_folder_activate));
+    add_item(file_menu, "_Close Tab", "<Control>W", G_CALLBACK(Editor::s_on_close_tab_activate));
 
     gtk_menu_shell_append(GTK_MENU_SHELL(file_menu), gtk_separator_menu_item_new());
     add_item(file_menu, "_Quit", "<Control>Q", G_CALLBACK(Editor::s_on_quit_activate));
@@ -300,6 +953,12 @@ GtkWidget* Editor::create_menu_bar() {
     add_item(search_menu, "_Find…", "<Control>F", G_CALLBACK(Editor::s_on_find_activate));
     add_item(search_menu, "_Replace…", "<Control>H", G_CALLBACK(Editor::s_on_replace_activate));
     add_item(search_menu, "_Go to Line…", "<Control>L", G_CALLBACK(Editor::s_on_goto_line_activate));
+    gtk_menu_shell_append(GTK_MENU_SHELL(search_menu), gtk_separator_menu_item_new());
+    add_item(search_menu, "Show All _Matches", "<Shift><Control>M", G_CALLBACK(Editor::s_on_results_activate));
+    add_item(search_menu, "Find in _Project…", "<Shift><Control>F", G_CALLBACK(Editor::s_on_project_search_activate));
+    gtk_menu_shell_append(GTK_MENU_SHELL(search_menu), gtk_separator_menu_item_new());
+    add_item(search_menu, "Pin / Unpin _Term", "<Shift><Control>P", G_CALLBACK(Editor::s_on_pin_term_activate));
+    add_item(search_menu, "_Clear Pinned Terms", nullptr, G_CALLBACK(Editor::s_on_clear_pins_activate));
 
     // ───── View ─────
     GtkWidget* view_menu = gtk_menu_new();
@@ -310,6 +969,32 @@ GtkWidget* Editor::create_menu_bar() {
     add_item(view_menu, "Zoom _In", "<Control>plus", G_CALLBACK(Editor::s_on_zoom_in_activate));
     add_item(view_menu, "Zoom _Out", "<Control>minus", G_CALLBACK(Editor::s_on_zoom_out_activate));
     add_item(view_menu, "Zoom _Reset", "<Control>0", G_CALLBACK(Editor::s_on_zoom_reset_activate));
+    gtk_menu_shell_append(GTK_MENU_SHELL(view_menu), gtk_separator_menu_item_new());
+    add_item(view_menu, "_Next Tab", "<Control>Page_Down", G_CALLBACK(Editor::s_on_next_tab_activate));
+    add_item(view_menu, "_Previous Tab", "<Control>Page_Up", G_CALLBACK(Editor::s_on_prev_tab_activate));
+    gtk_menu_shell_append(GTK_MENU_SHELL(view_menu), gtk_separator_menu_item_new());
+
+    GtkWidget* minimap_item = gtk_check_menu_item_new_with_mnemonic("_Minimap");
+    gtk_check_menu_item_set_active(GTK_CHECK_MENU_ITEM(minimap_item), show_minimap_);
+    g_signal_connect(minimap_item, "activate", G_CALLBACK(Editor::s_on_toggle_minimap), this);
+    gtk_menu_shell_append(GTK_MENU_SHELL(view_menu), minimap_item);
+
+    GtkWidget* ruler_item = gtk_check_menu_item_new_with_mnemonic("Overview _Ruler");
+    gtk_check_menu_item_set_active(GTK_CHECK_MENU_ITEM(ruler_item), show_ruler_);
+    g_signal_connect(ruler_item, "activate", G_CALLBACK(Editor::s_on_toggle_ruler), this);
+    gtk_menu_shell_append(GTK_MENU_SHELL(view_menu), ruler_item);
+
+    GtkWidget* hud_item = gtk_check_menu_item_new_with_mnemonic("_Latency HUD");
+    gtk_check_menu_item_set_active(GTK_CHECK_MENU_ITEM(hud_item), show_latency_hud_);
+    g_signal_connect(hud_item, "activate", G_CALLBACK(Editor::s_on_toggle_latency_hud), this);
+    gtk_menu_shell_append(GTK_MENU_SHELL(view_menu), hud_item);
+
+    GtkWidget* trace_item = gtk_check_menu_item_new_with_mnemonic("Record _Trace");
+    gtk_check_menu_item_set_active(GTK_CHECK_MENU_ITEM(trace_item), trace::enabled());
+    g_signal_connect(trace_item, "activate", G_CALLBACK(Editor::s_on_toggle_trace), this);
+    gtk_menu_shell_append(GTK_MENU_SHELL(view_menu), trace_item);
+    add_item(view_menu, "_Save Trace…", nullptr, G_CALLBACK(Editor::s_on_save_trace_activate));
+    add_item(view_menu, "_Memory Usage…", nullptr, G_CALLBACK(Editor::s_on_memory_usage_activate));
 
     // ───── Options ─────
     GtkWidget* opt_menu = gtk_menu_new();
@@ -327,10 +1012,16 @@ GtkWidget* Editor::create_menu_bar() {
     g_signal_connect(nl_item, "activate", G_CALLBACK(Editor::s_on_toggle_eof_nl), this);
     gtk_menu_shell_append(GTK_MENU_SHELL(opt_menu), nl_item);
 
-    GtkWidget* spaces_item = gtk_check_menu_item_new_with_mnemonic("Insert _spaces instead of tabs");
-    gtk_check_menu_item_set_active(GTK_CHECK_MENU_ITEM(spaces_item), TRUE);
-    g_signal_connect(spaces_item, "activate", G_CALLBACK(Editor::s_on_spaces_toggle), this);
-    gtk_menu_shell_append(GTK_MENU_SHELL(opt_menu), spaces_item);
+    GtkWidget* index_item = gtk_check_menu_item_new_with_mnemonic("_Index project for search");
+    gtk_check_menu_item_set_active(GTK_CHECK_MENU_ITEM(index_item), project_index_enabled_);
+    g_signal_connect(index_item, "activate", G_CALLBACK(Editor::s_on_toggle_project_index), this);
+    gtk_menu_shell_append(GTK_MENU_SHELL(opt_menu), index_item);
+
+    spaces_item_ = gtk_check_menu_item_new_with_mnemonic("Insert _spaces instead of tabs");
+    gtk_check_menu_item_set_active(GTK_CHECK_MENU_ITEM(spaces_item_),
+                                   gtk_source_view_get_insert_spaces_instead_of_tabs(GTK_SOURCE_VIEW(text_view_)));
+    g_signal_connect(spaces_item_, "activate", G_CALLBACK(Editor::s_on_spaces_toggle), this);
+    gtk_menu_shell_append(GTK_MENU_SHELL(opt_menu), spaces_item_);
 
     GtkWidget* tab_menu_item = gtk_menu_item_new_with_mnemonic("_Tab Width");
     GtkWidget* tab_menu = gtk_menu_new();
@@ -350,7 +1041,10 @@ GtkWidget* Editor::create_menu_bar() {
 
 bool Editor::maybe_confirm_discard(const char* action_label) {
     if (!modified_) return true;
+    return confirm_discard(action_label);
+}
 
+bool Editor::confirm_discard(const char* action_label) {
     GtkWidget* dlg = gtk_message_dialog_new(
         GTK_WINDOW(window_),
         GTK_DIALOG_MODAL,
@@ -391,6 +1085,20 @@ bool Editor::confirm_reload_external(const char* reason) {
     return resp == GTK_RESPONSE_ACCEPT;
 }
 
+void Editor::report_error(const char* message, const char* detail) {
+    std::cerr << message << " " << detail << "\n";
+    GtkWidget* dlg = gtk_message_dialog_new(
+        GTK_WINDOW(window_),
+        GTK_DIALOG_MODAL,
+        GTK_MESSAGE_ERROR,
+        GTK_BUTTONS_CLOSE,
+        "%s", message
+    );
+    gtk_message_dialog_format_secondary_text(GTK_MESSAGE_DIALOG(dlg), "%s", detail);
+    gtk_dialog_run(GTK_DIALOG(dlg));
+    gtk_widget_destroy(dlg);
+}
+
 // ───────────────────────────────────────────────
 //  File monitor
 // ───────────────────────────────────────────────
@@ -431,21 +1139,95 @@ guint64 Editor::get_file_mtime_us(const std::string& path) {
 //  File operations
 // ───────────────────────────────────────────────
 
+// A new Untitled tab; the document shown so far is parked, not discarded.
 void Editor::new_file() {
-    if (!maybe_confirm_discard("create a new file")) return;
+    Document* d = add_document(std::string());
+    d->park(std::string());
+    show_document(d);
+}
 
-    gtk_text_buffer_set_text(buffer_, "", -1);
-    current_file_.clear();
-    update_language_for_filename(current_file_);
-    remove_file_monitor();
-    mark_modified(false);
-    update_title();
-    update_status_full();
+// Replaces the whole document. Not undoable: the history would otherwise
+// keep both the old and the new text alive, and undoing past a load is
+// never what anyone wants.
+void Editor::load_text(const char* text, gint len) {
+    GtkSourceBuffer* srcb = GTK_SOURCE_BUFFER(buffer_);
+    gtk_source_buffer_begin_not_undoable_action(srcb);
+    gtk_text_buffer_set_text(buffer_, text, len);
+    gtk_source_buffer_end_not_undoable_action(srcb);
 }
 
-void Editor::open_file() {
-    if (!maybe_confirm_discard("open a file")) return;
+void Editor::remember_file_meta() {
+    if (!file_shown_ || current_file_.empty()) return;
+
+    FileMeta meta;
+    capture_view_state(&meta);
+    file_meta().store(current_file_, meta);
+}
+
+void Editor::capture_view_state(FileMeta* out) {
+    FileMeta& meta = *out;
+    GtkTextIter it;
+    gtk_text_buffer_get_iter_at_mark(buffer_, &it, gtk_text_buffer_get_insert(buffer_));
+    meta.cursor_line = gtk_text_iter_get_line(&it);
+    meta.cursor_offset = gtk_text_iter_get_line_offset(&it);
+
+    GdkRectangle r;
+    gtk_text_view_get_visible_rect(GTK_TEXT_VIEW(text_view_), &r);
+    gtk_text_view_get_line_at_y(GTK_TEXT_VIEW(text_view_), &it, r.y, nullptr);
+    meta.top_line = gtk_text_iter_get_line(&it);
+
+    GtkSourceView* view = GTK_SOURCE_VIEW(text_view_);
+    meta.tab_width = (int)gtk_source_view_get_tab_width(view);
+    meta.insert_spaces = gtk_source_view_get_insert_spaces_instead_of_tabs(view) ? 1 : 0;
+    meta.line_ending = line_ending_;
+    meta.encoding = "UTF-8";            // files are read and written as they are
+}
+
+// Back where the file was left, with the tab settings it was edited with;
+// a file seen for the first time gets the defaults.
+void Editor::restore_file_meta() {
+    FileMeta meta;
+    if (!file_meta().lookup(current_file_, &meta)) {
+        set_view_tab_width(tab_width_);
+        set_view_insert_spaces(true);
+        return;
+    }
+    apply_view_state(meta);
+}
+
+void Editor::apply_view_state(const FileMeta& meta) {
+    set_view_tab_width(meta.tab_width > 0 ? meta.tab_width : tab_width_);
+    set_view_insert_spaces(meta.insert_spaces != 0);
+
+    GtkTextIter it;
+    const int lines = gtk_text_buffer_get_line_count(buffer_);
+    gtk_text_buffer_get_iter_at_line(buffer_, &it, std::min(meta.cursor_line, lines - 1));
+    GtkTextIter end = it;
+    if (!gtk_text_iter_ends_line(&end)) gtk_text_iter_forward_to_line_end(&end);
+    gtk_text_iter_set_line_offset(&it, std::min(meta.cursor_offset, gtk_text_iter_get_line_offset(&end)));
+    gtk_text_buffer_place_cursor(buffer_, &it);
+
+    // also at 0: the view may still be scrolled for the previous document
+    fast_scroll_to_line(GTK_TEXT_VIEW(text_view_), std::min(meta.top_line, lines - 1), 0.0);
+}
 
+void Editor::set_view_tab_width(int width) {
+    GtkSourceView* view = GTK_SOURCE_VIEW(text_view_);
+    if ((int)gtk_source_view_get_tab_width(view) == width) return;
+    gtk_source_view_set_tab_width(view, width);
+    minimap_->invalidate();
+    update_cursor_status();
+}
+
+void Editor::set_view_insert_spaces(bool on) {
+    gtk_source_view_set_insert_spaces_instead_of_tabs(GTK_SOURCE_VIEW(text_view_), on);
+    if (!spaces_item_) return;
+    g_signal_handlers_block_by_func(spaces_item_, (gpointer)Editor::s_on_spaces_toggle, this);
+    gtk_check_menu_item_set_active(GTK_CHECK_MENU_ITEM(spaces_item_), on);
+    g_signal_handlers_unblock_by_func(spaces_item_, (gpointer)Editor::s_on_spaces_toggle, this);
+}
+
+void Editor::open_file() {
     GtkWidget* dialog = gtk_file_chooser_dialog_new(
         "Open File",
         GTK_WINDOW(window_),
@@ -457,7 +1239,7 @@ void Editor::open_file() {
     if (gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_ACCEPT) {
         char* filename = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog));
         if (filename) {
-            open_file_from_path(filename);
+            open_in_tab(filename);
             g_free(filename);
         }
     }
@@ -465,12 +1247,14 @@ void Editor::open_file() {
 }
 
 void Editor::open_file_from_path(const std::string& path) {
+    trace::Span span("Editor::open_file_from_path");
     if (!opened_via_cli_) {
         // only prompt discard if this came from menu actions
         // (CLI open usually means you want it opened)
         // still safe if modified:
         if (modified_ && !maybe_confirm_discard("open another file")) return;
     }
+    remember_file_meta();
 
     gchar* contents = nullptr;
     gsize length = 0;
@@ -478,13 +1262,23 @@ void Editor::open_file_from_path(const std::string& path) {
 
     if (g_file_get_contents(path.c_str(), &contents, &length, &error)) {
         suppress_monitor_once_ = true; // avoid seeing our own subsequent writes as "external"
-        gtk_text_buffer_set_text(buffer_, contents, (gint)length);
+
+        // one huge line would be laid out as a single Pango paragraph
+        const size_t limit = long_line_kb_ > 0 ? (size_t)long_line_kb_ * 1024 : 0;
+        const bool long_lines = limit && longest_line(contents, length) > limit;
+        line_ending_ = detect_line_ending(contents, length);
+        set_long_line_mode(long_lines);
+        load_text(contents, (gint)length);
         g_free(contents);
+        pins_reset();
+        set_search_scope(false);
 
         current_file_ = path;
         update_language_for_filename(current_file_);
         add_recent_item(current_file_);
         install_file_monitor(current_file_);
+        file_shown_ = true;
+        restore_file_meta();
 
         mark_modified(false);
         update_title();
@@ -492,10 +1286,16 @@ void Editor::open_file_from_path(const std::string& path) {
     } else {
         // If file doesn't exist, treat as new empty file with that name
         if (error && error->code == G_FILE_ERROR_NOENT) {
-            gtk_text_buffer_set_text(buffer_, "", -1);
+            set_long_line_mode(false);
+            load_text("", 0);
+            pins_reset();
+            set_search_scope(false);
             current_file_ = path;
+            line_ending_ = FileMeta::kEndingUnknown;
             update_language_for_filename(current_file_);
             remove_file_monitor();
+            file_shown_ = true;
+            restore_file_meta();
             mark_modified(false);
             update_title();
             update_status_full();
@@ -506,6 +1306,269 @@ void Editor::open_file_from_path(const std::string& path) {
     }
 }
 
+// ───────────────────────────────────────────────
+//  Documents (tabs)
+// ───────────────────────────────────────────────
+//
+// One buffer and view per window, whatever the number of tabs: the search,
+// pins, minimap, ruler and bracket index all follow that one buffer. A tab
+// switch parks the shown text in its Document, with its undo history and
+// modified lines, and loads the chosen one.
+
+// A tab for path, not shown yet; the caller parks or drops it.
+Document* Editor::add_document(const std::string& path) {
+    Document* d = new Document(path);
+    d->page = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+    g_object_set_data(G_OBJECT(d->page), "document", d);
+
+    GtkWidget* tab = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 4);
+    d->label = gtk_label_new("");
+    GtkWidget* close = gtk_button_new_from_icon_name("window-close-symbolic", GTK_ICON_SIZE_MENU);
+    gtk_button_set_relief(GTK_BUTTON(close), GTK_RELIEF_NONE);
+    gtk_widget_set_focus_on_click(close, FALSE);
+    g_object_set_data(G_OBJECT(close), "document", d);
+    g_signal_connect(close, "clicked", G_CALLBACK(Editor::s_on_tab_close_clicked), this);
+    gtk_box_pack_start(GTK_BOX(tab), d->label, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(tab), close, FALSE, FALSE, 0);
+    gtk_widget_show_all(tab);
+    gtk_widget_show(d->page);
+
+    switching_ = true;
+    gtk_notebook_append_page(GTK_NOTEBOOK(tabs_), d->page, tab);
+    switching_ = false;
+    docs_.push_back(d);
+    gtk_notebook_set_show_tabs(GTK_NOTEBOOK(tabs_), docs_.size() > 1);
+    update_tab_label(d);
+    return d;
+}
+
+// The shown document's path is current_file_: Save As changes it there.
+Document* Editor::find_document(const std::string& path) {
+    for (Document* d : docs_)
+        if ((d == shown_doc_ ? current_file_ : d->path) == path) return d;
+    return nullptr;
+}
+
+// Open, Open Recent and the command line: a file already open is brought
+// forward, an untouched empty Untitled tab is reused, anything else gets a
+// new tab.
+void Editor::open_in_tab(const std::string& path) {
+    if (Document* d = find_document(path)) {
+        show_document(d);
+        return;
+    }
+    if (shown_doc_ && current_file_.empty() && !modified_ && gtk_text_buffer_get_char_count(buffer_) == 0) {
+        opened_via_cli_ = true;
+        open_file_from_path(path);
+        opened_via_cli_ = false;
+        return;
+    }
+    Document* d = add_document(path);
+    d->drop();
+    show_document(d);
+}
+
+void Editor::show_document(Document* d) {
+    if (d == shown_doc_) return;
+    trace::Span span("Editor::show_document");
+
+    // changed on disk while parked: read it again rather than show stale
+    // text, and the history made for the old text goes with it. Unsaved
+    // changes are only given up when the user says so; kept, the new
+    // mtime is taken as seen, as the file monitor does.
+    if (!d->path.empty() && d->storage() != Document::Storage::OnDisk) {
+        const guint64 now = get_file_mtime_us(d->path);
+        if (now && now != d->mtime_us &&
+            (!d->modified || confirm_reload_external((basename_of(d->path) + " was modified externally.").c_str()))) {
+            d->modified = false;
+            d->history = UndoHistory::State();
+            d->modified_lines.clear();
+            d->drop();
+        }
+    }
+
+    // unpacked before the shown document is parked, so that a failure
+    // leaves everything as it was. Its unsaved text is not in the file, so
+    // it is not reread in its place: it stays parked in its tab.
+    std::string text;
+    const bool parked = d->storage() != Document::Storage::OnDisk;
+    if (parked && !d->unpark(&text)) {
+        report_error("Could not restore the document.",
+                     (d->path.empty() ? std::string("Untitled") : d->path).c_str());
+        if (shown_doc_) {
+            const gint page = gtk_notebook_page_num(GTK_NOTEBOOK(tabs_), shown_doc_->page);
+            switching_ = true;
+            gtk_notebook_set_current_page(GTK_NOTEBOOK(tabs_), page);
+            switching_ = false;
+        } else {
+            Document* blank = add_document(std::string());
+            blank->park(std::string());
+            show_document(blank);
+        }
+        return;
+    }
+
+    park_shown_document();
+    shown_doc_ = d;
+    d->last_shown = ++show_clock_;
+
+    if (parked) {
+        set_long_line_mode(d->long_lines);
+        load_text(text.data(), (gint)text.size());
+        std::string().swap(text);
+        pins_reset();
+        set_search_scope(false);
+
+        current_file_ = d->path;
+        line_ending_ = d->view.line_ending;
+        update_language_for_filename(current_file_);
+        if (current_file_.empty()) remove_file_monitor();
+        else install_file_monitor(current_file_);
+        file_shown_ = true;
+        apply_view_state(d->view);
+
+        mark_modified(d->modified);
+        if (ruler_) ruler_->restore_modified(std::move(d->modified_lines));
+        undo_->restore(std::move(d->history));
+    } else {
+        // dropped under the budget, or restored from the session
+        opened_via_cli_ = true;
+        open_file_from_path(d->path);
+        opened_via_cli_ = false;
+        if (!file_shown_) {
+            // unreadable now (the error went to stderr): an empty Untitled
+            // rather than the previous document's text under this tab
+            set_long_line_mode(false);
+            load_text("", 0);
+            pins_reset();
+            set_search_scope(false);
+            current_file_.clear();
+            update_language_for_filename(current_file_);
+            remove_file_monitor();
+            file_shown_ = true;
+            apply_view_state(FileMeta());
+            mark_modified(false);
+        }
+    }
+
+    const gint page = gtk_notebook_page_num(GTK_NOTEBOOK(tabs_), d->page);
+    if (gtk_notebook_get_current_page(GTK_NOTEBOOK(tabs_)) != page) {
+        switching_ = true;
+        gtk_notebook_set_current_page(GTK_NOTEBOOK(tabs_), page);
+        switching_ = false;
+    }
+    update_title();
+    update_status_full();
+    enforce_background_budget((size_t)std::max(0, background_mb_) << 20);
+}
+
+// The buffer's text and view state into the shown document, which then
+// sits in the background like any other.
+void Editor::park_shown_document() {
+    Document* d = shown_doc_;
+    if (!d) return;
+    remember_file_meta();                // also for the next session
+    capture_view_state(&d->view);
+    d->path = current_file_;
+    d->mtime_us = file_mtime_utc_us_;
+    d->modified = modified_;
+    d->long_lines = long_line_mode_;
+    d->history = undo_->take();
+    if (ruler_) d->modified_lines = ruler_->take_modified();
+
+    GtkTextIter s, e;
+    gtk_text_buffer_get_bounds(buffer_, &s, &e);
+    gchar* text = gtk_text_buffer_get_text(buffer_, &s, &e, TRUE);
+    d->park(text);
+    g_free(text);
+
+    update_tab_label(d);
+    file_shown_ = false;
+    shown_doc_ = nullptr;
+}
+
+// Unsaved changes are asked about with the document shown, or as it is
+// when it cannot be. Closing the last tab leaves an empty Untitled one.
+void Editor::close_document(Document* d) {
+    if (d != shown_doc_ && d->modified) show_document(d);
+    const bool shown = d == shown_doc_;
+    if (shown) {
+        if (!maybe_confirm_discard("close it")) return;
+        remember_file_meta();
+    } else if (d->modified && !confirm_discard("close it")) {
+        return;
+    }
+
+    const auto it = std::find(docs_.begin(), docs_.end(), d);
+    const size_t index = (size_t)(it - docs_.begin());
+    docs_.erase(it);
+    Document* next = nullptr;
+    if (shown) {
+        shown_doc_ = nullptr;
+        file_shown_ = false;
+        if (docs_.empty()) {
+            next = add_document(std::string());
+            next->park(std::string());
+        } else {
+            next = docs_[std::min(index, docs_.size() - 1)];
+        }
+    }
+
+    switching_ = true;
+    gtk_notebook_remove_page(GTK_NOTEBOOK(tabs_), gtk_notebook_page_num(GTK_NOTEBOOK(tabs_), d->page));
+    switching_ = false;
+    delete d;
+    gtk_notebook_set_show_tabs(GTK_NOTEBOOK(tabs_), docs_.size() > 1);
+    if (next) show_document(next);
+}
+
+// Quit: every modified document in turn, shown while it is asked about.
+bool Editor::confirm_discard_all(const char* action_label) {
+    for (size_t i = 0; i < docs_.size(); ++i) {
+        Document* d = docs_[i];
+        if (!(d == shown_doc_ ? modified_ : d->modified)) continue;
+        show_document(d);
+        if (!(d == shown_doc_ ? maybe_confirm_discard(action_label) : confirm_discard(action_label))) return false;
+    }
+    return true;
+}
+
+void Editor::update_tab_label(Document* d) {
+    const bool shown = d == shown_doc_;
+    const std::string& path = shown ? current_file_ : d->path;
+    std::string text = path.empty() ? "Untitled" : basename_of(path);
+    if (shown ? modified_ : d->modified) text = "*" + text;
+    gtk_label_set_text(GTK_LABEL(d->label), text.c_str());
+    gtk_widget_set_tooltip_text(d->label, path.empty() ? nullptr : path.c_str());
+}
+
+// Least recently shown first: text the file on disk still has is dropped,
+// unsaved text or text with an undo history is compressed, until the
+// background documents fit budget.
+void Editor::enforce_background_budget(size_t budget) {
+    std::vector<Document*> parked;
+    size_t total = 0;
+    for (Document* d : docs_) {
+        if (d == shown_doc_ || d->storage() == Document::Storage::OnDisk) continue;
+        parked.push_back(d);
+        total += d->memory_bytes();
+    }
+    if (total <= budget) return;
+
+    std::sort(parked.begin(), parked.end(),
+              [](const Document* a, const Document* b) { return a->last_shown < b->last_shown; });
+    for (Document* d : parked) {
+        if (total <= budget) break;
+        if (d->can_drop()) {
+            total -= d->memory_bytes();
+            d->drop();
+        } else if (d->storage() == Document::Storage::Plain && !d->compressing()) {
+            total -= d->memory_bytes() * 3 / 4;   // about what level 1 saves on text
+            d->compress_in_background();
+        }
+    }
+}
+
 static std::string make_backup_path_impl(const std::string& path) {
     return path + ".bak";
 }
@@ -515,6 +1578,7 @@ std::string Editor::make_backup_path(const std::string& path) {
 }
 
 void Editor::apply_save_fixes(std::string& text) {
+    trace::Span span("Editor::apply_save_fixes");
     if (trim_ws_on_save_) {
         std::stringstream in(text);
         std::string out;
@@ -534,6 +1598,7 @@ void Editor::apply_save_fixes(std::string& text) {
 }
 
 void Editor::save_file() {
+    trace::Span span("Editor::save_file");
     if (current_file_.empty()) {
         save_file_as();
         return;
@@ -542,7 +1607,7 @@ void Editor::save_file() {
     GtkTextIter start, end;
     gtk_text_buffer_get_start_iter(buffer_, &start);
     gtk_text_buffer_get_end_iter(buffer_, &end);
-    gchar* raw = gtk_text_buffer_get_text(buffer_, &start, &end, FALSE);
+    gchar* raw = gtk_text_buffer_get_text(buffer_, &start, &end, TRUE);   // with the text long lines hide
 
     std::string text = raw ? raw : "";
     if (raw) g_free(raw);
@@ -595,7 +1660,7 @@ void Editor::save_file_as() {
         GtkTextIter start, end;
         gtk_text_buffer_get_start_iter(buffer_, &start);
         gtk_text_buffer_get_end_iter(buffer_, &end);
-        gchar* raw = gtk_text_buffer_get_text(buffer_, &start, &end, FALSE);
+        gchar* raw = gtk_text_buffer_get_text(buffer_, &start, &end, TRUE);
 
         std::string text = raw ? raw : "";
         if (raw) g_free(raw);
@@ -606,6 +1671,7 @@ void Editor::save_file_as() {
         suppress_monitor_once_ = true;
         if (g_file_set_contents(filename, text.c_str(), (gssize)text.size(), &error)) {
             current_file_ = filename;
+            file_shown_ = true;
             update_language_for_filename(current_file_);
             add_recent_item(current_file_);
             install_file_monitor(current_file_);
@@ -640,10 +1706,12 @@ void Editor::open_containing_folder() {
 
 void Editor::cut() {
     GtkClipboard* cb = gtk_clipboard_get(GDK_SELECTION_CLIPBOARD);
+    if (line_guard_->copy(cb, true)) return;
     gtk_text_buffer_cut_clipboard(buffer_, cb, TRUE);
 }
 void Editor::copy() {
     GtkClipboard* cb = gtk_clipboard_get(GDK_SELECTION_CLIPBOARD);
+    if (line_guard_->copy(cb, false)) return;
     gtk_text_buffer_copy_clipboard(buffer_, cb);
 }
 void Editor::paste() {
@@ -664,37 +1732,460 @@ void Editor::select_all() {
 void Editor::ensure_search_context() {
     if (!search_settings_) {
         search_settings_ = gtk_source_search_settings_new();
-        gtk_source_search_settings_set_case_sensitive(search_settings_, FALSE);
+        apply_search_options();
         gtk_source_search_settings_set_wrap_around(search_settings_, FALSE);
     }
     if (!search_context_) {
         search_context_ = gtk_source_search_context_new(GTK_SOURCE_BUFFER(buffer_), search_settings_);
         gtk_source_search_context_set_highlight(search_context_, TRUE);
+        g_signal_connect(search_context_, "notify::occurrences-count", G_CALLBACK(Editor::s_on_search_count_notify), this);
     }
 }
 
-void Editor::update_search_from_dialog(GtkWidget* dialog) {
-    ensure_search_context();
+void Editor::apply_search_options() {
+    if (!search_settings_) return;
+    gtk_source_search_settings_set_case_sensitive(search_settings_, search_case_sensitive_);
+    gtk_source_search_settings_set_regex_enabled(search_settings_, search_regex_);
+}
 
-    GtkWidget* entry = GTK_WIDGET(g_object_get_data(G_OBJECT(dialog), "find_entry"));
-    const char* t = entry ? gtk_entry_get_text(GTK_ENTRY(entry)) : "";
-    gtk_source_search_settings_set_search_text(search_settings_, t ? t : "");
+// Large buffers cost more per rescan, so wait for a longer pause in typing.
+static guint search_debounce_ms(GtkTextBuffer* buffer) {
+    gint chars = gtk_text_buffer_get_char_count(buffer);
+    if (chars > (8 << 20)) return 300;
+    if (chars > (1 << 20)) return 180;
+    return 80;
 }
 
-void Editor::search_find_next(bool backwards) {
-    ensure_search_context();
+// The context scans and tags the whole buffer whenever it has search text,
+// so it only gets the text while no bounded highlighting is in charge.
+void Editor::sync_search_context() {
+    if (!search_settings_) return;
+    const bool use_context = !manual_highlight() && !last_query_.empty();
+    gtk_source_search_settings_set_search_text(search_settings_, use_context ? last_query_.c_str() : nullptr);
+    hl_dirty_ = true;
+    refresh_manual_highlight();
+}
 
-    GtkTextIter iter, mstart, mend;
-    gtk_text_buffer_get_iter_at_mark(buffer_, &iter, gtk_text_buffer_get_insert(buffer_));
+void Editor::rebuild_search_matcher() {
+    delete search_matcher_;
+    search_matcher_ = new TextMatcher(last_query_, search_case_sensitive_, search_regex_);
+}
 
-    gboolean found = FALSE;
-    if (backwards) {
-        found = gtk_source_search_context_backward(search_context_, &iter, &mstart, &mend);
-        if (!found) {
-            // wrap to end
-            gtk_text_buffer_get_end_iter(buffer_, &iter);
-            found = gtk_source_search_context_backward(search_context_, &iter, &mstart, &mend);
-        }
+bool Editor::manual_highlight() const {
+    return search_in_scope_ || viewport_highlight_;
+}
+
+// Past the threshold the context's whole-buffer scan (and the tags it lays
+// over every match) costs more than it is worth; only the viewport is tagged.
+// Long lines get the same: most of their text is hidden, not worth tagging.
+void Editor::update_highlight_mode() {
+    const bool on = long_line_mode_
+                 || (viewport_highlight_mb_ > 0 && text_bytes_ >= ((gint64)viewport_highlight_mb_ << 20));
+    if (on == viewport_highlight_) return;
+    viewport_highlight_ = on;
+    hl_dirty_ = true;
+    sync_search_context();
+    update_search_count();
+}
+
+bool Editor::set_search_scope(bool on) {
+    if (on && !search_in_scope_) {
+        GtkTextIter s, e;
+        if (!gtk_text_buffer_get_selection_bounds(buffer_, &s, &e)) return false;
+
+        if (!scope_start_) {
+            scope_start_ = gtk_text_buffer_create_mark(buffer_, "search-scope-start", &s, TRUE);
+            scope_end_ = gtk_text_buffer_create_mark(buffer_, "search-scope-end", &e, FALSE);
+        } else {
+            gtk_text_buffer_move_mark(buffer_, scope_start_, &s);
+            gtk_text_buffer_move_mark(buffer_, scope_end_, &e);
+        }
+        gtk_text_buffer_apply_tag(buffer_, scope_tag_, &s, &e);
+        search_in_scope_ = true;
+    } else if (!on && search_in_scope_) {
+        GtkTextIter s, e;
+        get_search_scope(&s, &e);
+        gtk_text_buffer_remove_tag(buffer_, scope_tag_, &s, &e);
+        search_in_scope_ = false;
+    }
+
+    if (search_scope_btn_ &&
+        gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(search_scope_btn_)) != (gboolean)search_in_scope_) {
+        g_signal_handlers_block_by_func(search_scope_btn_, (gpointer)Editor::s_on_search_scope_toggled, this);
+        gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(search_scope_btn_), search_in_scope_);
+        g_signal_handlers_unblock_by_func(search_scope_btn_, (gpointer)Editor::s_on_search_scope_toggled, this);
+    }
+
+    sync_search_context();
+    update_search_count();
+    return true;
+}
+
+bool Editor::get_search_scope(GtkTextIter* start, GtkTextIter* end) {
+    if (!search_in_scope_) return false;
+    gtk_text_buffer_get_iter_at_mark(buffer_, start, scope_start_);
+    gtk_text_buffer_get_iter_at_mark(buffer_, end, scope_end_);
+    return true;
+}
+
+// Matches of the current query between start and end, as character offsets.
+void Editor::range_matches(const GtkTextIter* start, const GtkTextIter* end,
+                           std::vector<std::pair<int, int>>* out) {
+    out->clear();
+    if (!search_matcher_ || !search_matcher_->valid()) return;
+
+    gchar* text = gtk_text_buffer_get_text(buffer_, start, end, TRUE);
+    if (!text) return;
+
+    const int base = gtk_text_iter_get_offset(start);
+    int chars = 0;
+    size_t at = 0;
+    search_matcher_->find_all(text, std::strlen(text), [&](size_t s, size_t e) {
+        chars += (int)g_utf8_strlen(text + at, (gssize)(s - at));
+        const int len = (int)g_utf8_strlen(text + s, (gssize)(e - s));
+        out->emplace_back(base + chars, base + chars + len);
+        chars += len;
+        at = e;
+        return true;
+    });
+    g_free(text);
+}
+
+void Editor::highlight_matches_in_range(const GtkTextIter* start, const GtkTextIter* end) {
+    GtkTextIter a = *start, b = *end;
+    gtk_text_buffer_remove_tag(buffer_, match_tag_, &a, &b);
+
+    std::vector<std::pair<int, int>> hits;
+    range_matches(&a, &b, &hits);
+
+    GtkTextIter ms = a;
+    for (const auto& h : hits) {
+        gtk_text_iter_set_offset(&ms, h.first);
+        GtkTextIter me = ms;
+        gtk_text_iter_forward_chars(&me, h.second - h.first);
+        gtk_text_buffer_apply_tag(buffer_, match_tag_, &ms, &me);
+    }
+}
+
+void Editor::clear_manual_highlight() {
+    if (!hl_valid_) return;
+    GtkTextIter s, e;
+    gtk_text_buffer_get_iter_at_mark(buffer_, &s, hl_start_);
+    gtk_text_buffer_get_iter_at_mark(buffer_, &e, hl_end_);
+    gtk_text_buffer_remove_tag(buffer_, match_tag_, &s, &e);
+    hl_valid_ = false;
+}
+
+static const int kHighlightMarginLines = 60;
+static const int kFindChunkLines = 20000;
+
+// What bounded highlighting should cover: the scope, or the lines around the
+// viewport (clipped to the scope) in viewport mode.
+bool Editor::highlight_target(GtkTextIter* start, GtkTextIter* end) {
+    GtkTextIter ss, se;
+    const bool scoped = get_search_scope(&ss, &se);
+    if (!viewport_highlight_) {
+        if (!scoped) return false;
+        *start = ss;
+        *end = se;
+        return true;
+    }
+
+    get_visible_range(kHighlightMarginLines, start, end);
+    if (scoped) {
+        if (gtk_text_iter_compare(start, &ss) < 0) *start = ss;
+        if (gtk_text_iter_compare(end, &se) > 0) *end = se;
+    }
+    return gtk_text_iter_compare(start, end) < 0;
+}
+
+// Brings the tagged range in line with highlight_target(). After a scroll
+// only the lines that entered the window are scanned and the ones that left
+// it untagged; an edit or a new query retags the whole window.
+void Editor::refresh_manual_highlight() {
+    if (!match_tag_) return;
+
+    GtkTextIter ns, ne;
+    if (!manual_highlight() || last_query_.empty() || !highlight_target(&ns, &ne)) {
+        clear_manual_highlight();
+        hl_dirty_ = false;
+        return;
+    }
+
+    GtkTextIter os, oe;
+    if (hl_valid_) {
+        gtk_text_buffer_get_iter_at_mark(buffer_, &os, hl_start_);
+        gtk_text_buffer_get_iter_at_mark(buffer_, &oe, hl_end_);
+    }
+
+    if (hl_valid_ && !hl_dirty_ &&
+        gtk_text_iter_compare(&ns, &oe) < 0 && gtk_text_iter_compare(&os, &ne) < 0) {
+        if (gtk_text_iter_equal(&ns, &os) && gtk_text_iter_equal(&ne, &oe)) return;
+
+        if (gtk_text_iter_compare(&ns, &os) < 0) highlight_matches_in_range(&ns, &os);
+        else if (gtk_text_iter_compare(&ns, &os) > 0) gtk_text_buffer_remove_tag(buffer_, match_tag_, &os, &ns);
+
+        if (gtk_text_iter_compare(&ne, &oe) > 0) highlight_matches_in_range(&oe, &ne);
+        else if (gtk_text_iter_compare(&ne, &oe) < 0) gtk_text_buffer_remove_tag(buffer_, match_tag_, &ne, &oe);
+    } else {
+        clear_manual_highlight();
+        GtkTextIter ss, se;
+        if (get_search_scope(&ss, &se))
+            gtk_text_buffer_apply_tag(buffer_, scope_tag_, &ss, &se);   // text typed into the scope
+        highlight_matches_in_range(&ns, &ne);
+    }
+
+    gtk_text_buffer_move_mark(buffer_, hl_start_, &ns);
+    gtk_text_buffer_move_mark(buffer_, hl_end_, &ne);
+    hl_valid_ = true;
+    hl_dirty_ = false;
+}
+
+// now: run ahead of the next redraw (scrolling); otherwise debounce like typing.
+void Editor::schedule_highlight(bool now) {
+    if (!manual_highlight()) return;
+    if (now) {
+        if (highlight_id_) g_source_remove(highlight_id_);
+        highlight_id_ = g_idle_add_full(G_PRIORITY_HIGH_IDLE, Editor::s_on_highlight_timeout, this, nullptr);
+        return;
+    }
+    if (highlight_id_) return;
+    highlight_id_ = g_timeout_add(search_debounce_ms(buffer_), Editor::s_on_highlight_timeout, this);
+}
+
+// Next match from the given position, scanning a bounded number of lines at
+// a time so a nearby match is found without copying the whole buffer. Wraps
+// around once.
+bool Editor::find_chunked(const GtkTextIter* from, bool backwards, GtkTextIter* ms, GtkTextIter* me) {
+    if (!search_matcher_ || !search_matcher_->valid()) return false;
+
+    const int lines = gtk_text_buffer_get_line_count(buffer_);
+    const int origin = gtk_text_iter_get_offset(from);
+    std::vector<std::pair<int, int>> hits;
+
+    auto pick = [&](int lo, int hi) -> bool {
+        const std::pair<int, int>* best = nullptr;
+        for (const auto& h : hits) {
+            if (h.first < lo || h.first >= hi) continue;
+            best = &h;
+            if (!backwards) break;              // first after, or last before
+        }
+        if (!best) return false;
+        gtk_text_buffer_get_iter_at_offset(buffer_, ms, best->first);
+        gtk_text_buffer_get_iter_at_offset(buffer_, me, best->second);
+        return true;
+    };
+
+    // forward: cursor line to the end, then the top down to the cursor line;
+    // backward: the same walk in reverse
+    const int line = gtk_text_iter_get_line(from);
+    bool wrapped = false;
+    int at = backwards ? line + 1 : line;
+    for (;;) {
+        int first, last;
+        if (!backwards) {
+            first = at;
+            last = std::min(wrapped ? line + 1 : lines, at + kFindChunkLines);
+            at = last;
+        } else {
+            last = at;
+            first = std::max(wrapped ? line : 0, at - kFindChunkLines);
+            at = first;
+        }
+
+        GtkTextIter cs, ce;
+        gtk_text_buffer_get_iter_at_line(buffer_, &cs, first);
+        if (last >= lines) gtk_text_buffer_get_end_iter(buffer_, &ce);
+        else gtk_text_buffer_get_iter_at_line(buffer_, &ce, last);
+        range_matches(&cs, &ce, &hits);
+
+        // before wrapping only matches past the cursor count, after it only
+        // the ones up to it
+        int lo = G_MININT, hi = G_MAXINT;
+        if (wrapped == backwards) lo = origin;
+        else hi = origin;
+        if (pick(lo, hi)) return true;
+
+        const bool done = backwards ? at <= (wrapped ? line : 0) : at >= (wrapped ? line + 1 : lines);
+        if (!done) continue;
+        if (wrapped) break;
+        wrapped = true;
+        at = backwards ? lines : 0;
+    }
+    return false;
+}
+
+void Editor::schedule_incremental_search() {
+    // whatever is still running was computed for older text
+    if (search_cancel_) {
+        g_cancellable_cancel(search_cancel_);
+        g_object_unref(search_cancel_);
+        search_cancel_ = nullptr;
+    }
+    if (search_debounce_id_) g_source_remove(search_debounce_id_);
+    search_debounce_id_ = g_timeout_add(search_debounce_ms(buffer_), Editor::s_on_search_debounce, this);
+}
+
+void Editor::run_incremental_search() {
+    ensure_search_context();
+
+    const char* t = gtk_entry_get_text(GTK_ENTRY(search_entry_));
+    last_query_ = t ? t : "";
+
+    // Changing the text restarts the context's highlighter, which scans in
+    // idle-time batches; the debounce keeps that to one restart per pause.
+    rebuild_search_matcher();
+    sync_search_context();
+
+    GtkStyleContext* sc = gtk_widget_get_style_context(search_entry_);
+    gtk_style_context_remove_class(sc, "error");
+    gtk_widget_set_tooltip_text(search_entry_, nullptr);
+    update_search_count();
+    if (results_tracking()) start_results_scan();
+    if (last_query_.empty()) return;
+
+    if (!search_matcher_->valid()) {
+        gtk_style_context_add_class(sc, "error");
+        gtk_widget_set_tooltip_text(search_entry_, search_matcher_->error().c_str());
+        return;
+    }
+
+    if (manual_highlight()) {
+        // bounded to the scope: a synchronous pass costs O(range)
+        GtkTextIter from;
+        gtk_text_buffer_get_iter_at_mark(buffer_, &from, search_anchor_ ? search_anchor_ : gtk_text_buffer_get_insert(buffer_));
+        gtk_text_buffer_place_cursor(buffer_, &from);
+        search_find_next(false);
+        if (!gtk_text_buffer_get_selection_bounds(buffer_, nullptr, nullptr))
+            gtk_style_context_add_class(sc, "error");
+        return;
+    }
+
+    if (search_cancel_) {
+        g_cancellable_cancel(search_cancel_);
+        g_object_unref(search_cancel_);
+    }
+    search_cancel_ = g_cancellable_new();
+    search_wrapped_ = false;
+
+    GtkTextIter from;
+    if (search_anchor_) gtk_text_buffer_get_iter_at_mark(buffer_, &from, search_anchor_);
+    else gtk_text_buffer_get_iter_at_mark(buffer_, &from, gtk_text_buffer_get_insert(buffer_));
+
+    gtk_source_search_context_forward_async(search_context_, &from, search_cancel_,
+                                            Editor::s_on_incremental_search_done, this);
+}
+
+void Editor::update_search_count() {
+    if (!search_count_label_) return;
+    if (!search_context_ || last_query_.empty()) {
+        gtk_label_set_text(GTK_LABEL(search_count_label_), "");
+        return;
+    }
+
+    if (viewport_highlight_ && !search_in_scope_) {
+        // counting would mean scanning the whole buffer on every change
+        gtk_label_set_text(GTK_LABEL(search_count_label_), "Large file: matches on screen highlighted");
+        return;
+    }
+
+    if (manual_highlight()) {
+        GtkTextIter ss, se;
+        std::vector<std::pair<int, int>> hits;
+        if (get_search_scope(&ss, &se)) range_matches(&ss, &se, &hits);
+
+        gint pos = 0;
+        GtkTextIter s, e;
+        if (gtk_text_buffer_get_selection_bounds(buffer_, &s, &e)) {
+            const std::pair<int, int> sel(gtk_text_iter_get_offset(&s), gtk_text_iter_get_offset(&e));
+            auto it = std::lower_bound(hits.begin(), hits.end(), sel);
+            if (it != hits.end() && *it == sel) pos = (gint)(it - hits.begin()) + 1;
+        }
+
+        std::stringstream ss_label;
+        if (hits.empty()) ss_label << "No matches in selection";
+        else if (pos > 0) ss_label << pos << " of " << hits.size() << " in selection";
+        else ss_label << hits.size() << (hits.size() == 1 ? " match" : " matches") << " in selection";
+        gtk_label_set_text(GTK_LABEL(search_count_label_), ss_label.str().c_str());
+        return;
+    }
+
+    gint total = gtk_source_search_context_get_occurrences_count(search_context_);
+    if (total < 0) {
+        gtk_label_set_text(GTK_LABEL(search_count_label_), "…");   // still scanning
+        return;
+    }
+    if (total == 0) {
+        gtk_label_set_text(GTK_LABEL(search_count_label_), "No matches");
+        return;
+    }
+
+    gint pos = 0;
+    GtkTextIter s, e;
+    if (gtk_text_buffer_get_selection_bounds(buffer_, &s, &e))
+        pos = gtk_source_search_context_get_occurrence_position(search_context_, &s, &e);
+
+    std::stringstream ss;
+    if (pos > 0) ss << pos << " of " << total;
+    else ss << total << (total == 1 ? " match" : " matches");
+    gtk_label_set_text(GTK_LABEL(search_count_label_), ss.str().c_str());
+}
+
+void Editor::search_find_next(bool backwards) {
+    trace::Span span("Editor::search_find_next");
+    ensure_search_context();
+
+    GtkTextIter ss, se;
+    if (get_search_scope(&ss, &se)) {
+        std::vector<std::pair<int, int>> hits;
+        range_matches(&ss, &se, &hits);
+        if (hits.empty()) {
+            update_search_count();
+            update_status_full();
+            return;
+        }
+
+        // continue past the current selection, wrapping inside the scope
+        GtkTextIter cs, ce;
+        gtk_text_buffer_get_selection_bounds(buffer_, &cs, &ce);
+        size_t pick;
+        if (backwards) {
+            const int before = gtk_text_iter_get_offset(&cs);
+            auto it = std::lower_bound(hits.begin(), hits.end(), std::make_pair(before, 0));
+            pick = it == hits.begin() ? hits.size() - 1 : (size_t)(it - hits.begin()) - 1;
+        } else {
+            const int after = gtk_text_iter_get_offset(&ce);
+            auto it = std::lower_bound(hits.begin(), hits.end(), std::make_pair(after, 0));
+            pick = it == hits.end() ? 0 : (size_t)(it - hits.begin());
+        }
+
+        GtkTextIter ms, me;
+        gtk_text_buffer_get_iter_at_offset(buffer_, &ms, hits[pick].first);
+        gtk_text_buffer_get_iter_at_offset(buffer_, &me, hits[pick].second);
+        gtk_text_buffer_select_range(buffer_, &ms, &me);
+        if (search_anchor_) gtk_text_buffer_move_mark(buffer_, search_anchor_, &ms);
+        gtk_text_view_scroll_to_iter(GTK_TEXT_VIEW(text_view_), &ms, 0.2, FALSE, 0, 0);
+        update_search_count();
+        update_status_full();
+        return;
+    }
+
+    GtkTextIter iter, mstart, mend;
+    gtk_text_buffer_get_iter_at_mark(buffer_, &iter, gtk_text_buffer_get_insert(buffer_));
+
+    gboolean found = FALSE;
+    if (viewport_highlight_) {
+        // the context holds no search text in this mode
+        GtkTextIter cs, ce;
+        gtk_text_buffer_get_selection_bounds(buffer_, &cs, &ce);
+        found = find_chunked(backwards ? &cs : &ce, backwards, &mstart, &mend);
+    } else if (backwards) {
+        found = gtk_source_search_context_backward(search_context_, &iter, &mstart, &mend);
+        if (!found) {
+            // wrap to end
+            gtk_text_buffer_get_end_iter(buffer_, &iter);
+            found = gtk_source_search_context_backward(search_context_, &iter, &mstart, &mend);
+        }
     } else {
         found = gtk_source_search_context_forward(search_context_, &iter, &mstart, &mend);
         if (!found) {
@@ -710,7 +2201,9 @@ void Editor::search_find_next(bool backwards) {
     }
 
     gtk_text_buffer_select_range(buffer_, &mstart, &mend);
+    if (search_anchor_) gtk_text_buffer_move_mark(buffer_, search_anchor_, &mstart);
     gtk_text_view_scroll_to_iter(GTK_TEXT_VIEW(text_view_), &mstart, 0.2, FALSE, 0, 0);
+    update_search_count();
     update_status_full();
 }
 
@@ -722,147 +2215,1085 @@ void Editor::search_replace_one(const std::string& repl) {
         if (!gtk_text_buffer_get_selection_bounds(buffer_, &s, &e)) return;
     }
 
+    GtkTextIter ss, se;
+    if (get_search_scope(&ss, &se) &&
+        (gtk_text_iter_compare(&s, &ss) < 0 || gtk_text_iter_compare(&e, &se) > 0)) return;
+
     gtk_text_buffer_begin_user_action(buffer_);
     gtk_text_buffer_delete(buffer_, &s, &e);
     gtk_text_buffer_insert(buffer_, &s, repl.c_str(), -1);
     gtk_text_buffer_end_user_action(buffer_);
 }
 
-void Editor::search_replace_all(const std::string& repl) {
-    ensure_search_context();
+void Editor::show_search_bar() {
+    GtkTextIter s, e;
+    const bool has_sel = gtk_text_buffer_get_selection_bounds(buffer_, &s, &e);
 
-    GtkTextIter iter, mstart, mend;
-    gtk_text_buffer_get_start_iter(buffer_, &iter);
+    // type-ahead restarts from where the search was opened
+    if (!search_anchor_) search_anchor_ = gtk_text_buffer_create_mark(buffer_, "search-anchor", &s, TRUE);
+    else gtk_text_buffer_move_mark(buffer_, search_anchor_, &s);
+
+    if (has_sel && gtk_text_iter_get_line(&s) == gtk_text_iter_get_line(&e)) {
+        gchar* sel = gtk_text_buffer_get_text(buffer_, &s, &e, TRUE);
+        if (sel) {
+            gtk_entry_set_text(GTK_ENTRY(search_entry_), sel);
+            g_free(sel);
+        }
+    } else if (has_sel) {
+        // a block is selected: search inside it
+        gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(search_scope_btn_), TRUE);
+    }
+
+    gtk_search_bar_set_search_mode(GTK_SEARCH_BAR(search_bar_), TRUE);
+    gtk_widget_grab_focus(search_entry_);
+    gtk_editable_select_region(GTK_EDITABLE(search_entry_), 0, -1);
+    schedule_incremental_search();
+}
+
+void Editor::hide_search_bar() {
+    if (search_debounce_id_) {
+        g_source_remove(search_debounce_id_);
+        search_debounce_id_ = 0;
+    }
+    if (search_cancel_) {
+        g_cancellable_cancel(search_cancel_);
+        g_object_unref(search_cancel_);
+        search_cancel_ = nullptr;
+    }
+    if (search_bar_ && gtk_search_bar_get_search_mode(GTK_SEARCH_BAR(search_bar_)))
+        gtk_search_bar_set_search_mode(GTK_SEARCH_BAR(search_bar_), FALSE);
+    if (!results_tracking()) drop_results();
+    gtk_widget_grab_focus(text_view_);
+}
+
+void Editor::show_replace_dialog() {
+    if (replace_dialog_) {
+        gtk_window_present(GTK_WINDOW(replace_dialog_));
+        return;
+    }
+
+    GtkWidget* dialog = gtk_dialog_new_with_buttons(
+        "Replace",
+        GTK_WINDOW(window_),
+        GTK_DIALOG_MODAL,
+        "_Close", GTK_RESPONSE_CLOSE,
+        "_Replace", GTK_RESPONSE_ACCEPT,
+        "Replace _All", GTK_RESPONSE_APPLY,
+        nullptr);
+
+    replace_dialog_ = dialog;
+
+    GtkWidget* content = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
+    GtkWidget* box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
+    gtk_container_set_border_width(GTK_CONTAINER(box), 8);
+    gtk_container_add(GTK_CONTAINER(content), box);
+
+    GtkWidget* find_label = gtk_label_new("Find text:");
+    gtk_box_pack_start(GTK_BOX(box), find_label, FALSE, FALSE, 0);
+
+    GtkWidget* find_entry = gtk_entry_new();
+    gtk_box_pack_start(GTK_BOX(box), find_entry, FALSE, FALSE, 0);
+
+    GtkWidget* repl_label = gtk_label_new("Replace with:");
+    gtk_box_pack_start(GTK_BOX(box), repl_label, FALSE, FALSE, 0);
+
+    GtkWidget* repl_entry = gtk_entry_new();
+    gtk_box_pack_start(GTK_BOX(box), repl_entry, FALSE, FALSE, 0);
+
+    // a multi-line selection becomes the scope, as with the search bar
+    GtkTextIter s, e;
+    if (!search_in_scope_ && gtk_text_buffer_get_selection_bounds(buffer_, &s, &e) &&
+        gtk_text_iter_get_line(&s) != gtk_text_iter_get_line(&e))
+        set_search_scope(true);
+
+    GtkWidget* scope = gtk_check_button_new_with_mnemonic("In _selection only");
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(scope), search_in_scope_);
+    g_signal_connect(scope, "toggled", G_CALLBACK(Editor::s_on_search_scope_toggled), this);
+    gtk_box_pack_start(GTK_BOX(box), scope, FALSE, FALSE, 0);
+
+    g_object_set_data(G_OBJECT(dialog), "find_entry", find_entry);
+    g_object_set_data(G_OBJECT(dialog), "repl_entry", repl_entry);
+
+    g_signal_connect(dialog, "response", G_CALLBACK(Editor::s_on_replace_dialog_response), this);
+    gtk_widget_show_all(dialog);
+}
+
+// ───────────────────────────────────────────────
+//  Search results panel
+// ───────────────────────────────────────────────
+
+// edits spanning more lines than this rescan the whole buffer in the background
+static const int kResultsRescanLines = 2000;
+
+GtkWidget* Editor::create_results_panel() {
+    results_hits_ = new HitListModel(
+        { G_TYPE_INT, G_TYPE_STRING },
+        [this](size_t row, int column, GValue* value) {
+            const MatchIndex::Hit& h = results_[row];
+            if (column == 0) g_value_set_int(value, h.line + 1);
+            else g_value_set_string(value, results_snippet(buffer_, h).c_str());
+        });
+
+    results_panel_ = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+    gtk_widget_set_no_show_all(results_panel_, TRUE);
+
+    GtkWidget* header = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 4);
+    gtk_container_set_border_width(GTK_CONTAINER(header), 2);
+    results_label_ = gtk_label_new("");
+    gtk_label_set_xalign(GTK_LABEL(results_label_), 0.0f);
+    gtk_box_pack_start(GTK_BOX(header), results_label_, TRUE, TRUE, 4);
+
+    GtkWidget* close = gtk_button_new_from_icon_name("window-close-symbolic", GTK_ICON_SIZE_MENU);
+    gtk_button_set_relief(GTK_BUTTON(close), GTK_RELIEF_NONE);
+    gtk_widget_set_tooltip_text(close, "Hide matches (Ctrl+Shift+M)");
+    gtk_box_pack_end(GTK_BOX(header), close, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(results_panel_), header, FALSE, FALSE, 0);
+
+    // fixed-height rows: only the visible rows are ever measured or formatted
+    results_view_ = gtk_tree_view_new_with_model(results_hits_->model());
+    gtk_tree_view_set_fixed_height_mode(GTK_TREE_VIEW(results_view_), TRUE);
+    gtk_tree_view_set_headers_visible(GTK_TREE_VIEW(results_view_), FALSE);
+    gtk_tree_view_set_activate_on_single_click(GTK_TREE_VIEW(results_view_), TRUE);
+
+    GtkCellRenderer* num = gtk_cell_renderer_text_new();
+    g_object_set(num, "xalign", 1.0f, "family", "Monospace", nullptr);
+    GtkTreeViewColumn* col = gtk_tree_view_column_new_with_attributes("Line", num, "text", 0, nullptr);
+    gtk_tree_view_column_set_sizing(col, GTK_TREE_VIEW_COLUMN_FIXED);
+    gtk_tree_view_column_set_fixed_width(col, 72);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(results_view_), col);
+
+    GtkCellRenderer* text = gtk_cell_renderer_text_new();
+    g_object_set(text, "family", "Monospace", nullptr);
+    col = gtk_tree_view_column_new_with_attributes("Text", text, "markup", 1, nullptr);
+    gtk_tree_view_column_set_sizing(col, GTK_TREE_VIEW_COLUMN_FIXED);
+    gtk_tree_view_column_set_fixed_width(col, 2000);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(results_view_), col);
+
+    GtkWidget* scrolled = gtk_scrolled_window_new(nullptr, nullptr);
+    gtk_widget_set_size_request(scrolled, -1, 140);
+    gtk_container_add(GTK_CONTAINER(scrolled), results_view_);
+    gtk_box_pack_start(GTK_BOX(results_panel_), scrolled, TRUE, TRUE, 0);
+
+    // the panel itself stays out of the window's show_all
+    gtk_widget_show_all(header);
+    gtk_widget_show_all(scrolled);
+
+    g_signal_connect(close, "clicked", G_CALLBACK(Editor::s_on_results_close_clicked), this);
+    g_signal_connect(results_view_, "row-activated", G_CALLBACK(Editor::s_on_results_row_activated), this);
+
+    // the span of a deletion is only known before it happens
+    g_signal_connect(buffer_, "delete-range", G_CALLBACK(Editor::s_on_results_before_delete), this);
+    g_signal_connect_after(buffer_, "delete-range", G_CALLBACK(Editor::s_on_results_after_delete), this);
+    g_signal_connect_after(buffer_, "insert-text", G_CALLBACK(Editor::s_on_results_insert_text), this);
+
+    return results_panel_;
+}
+
+bool Editor::results_active() const {
+    return results_panel_ && gtk_widget_get_visible(results_panel_);
+}
+
+// The match index also feeds the overview ruler while the search bar is open.
+bool Editor::results_tracking() const {
+    if (results_active()) return true;
+    return show_ruler_ && search_bar_ && gtk_search_bar_get_search_mode(GTK_SEARCH_BAR(search_bar_));
+}
+
+// nothing is tracked while no one looks; starting again means a fresh scan
+void Editor::drop_results() {
+    stop_results_scan();
+    delete results_matcher_;
+    results_matcher_ = nullptr;
+    results_.clear();
+    results_hits_->reset(0);
+    gtk_tree_view_set_model(GTK_TREE_VIEW(results_view_), results_hits_->model());
+    ruler_->hits_reset();
+}
+
+void Editor::show_results_panel(bool show) {
+    if (show == results_active()) return;
+
+    if (show) {
+        gtk_widget_show(results_panel_);
+        if (search_entry_) {
+            const char* t = gtk_entry_get_text(GTK_ENTRY(search_entry_));
+            if (t && *t) last_query_ = t;
+        }
+        start_results_scan();
+        return;
+    }
+
+    gtk_widget_hide(results_panel_);
+    if (!results_tracking()) drop_results();
+    gtk_widget_grab_focus(text_view_);
+}
+
+void Editor::stop_results_scan() {
+    if (results_cancel_) {
+        g_cancellable_cancel(results_cancel_);
+        g_object_unref(results_cancel_);
+        results_cancel_ = nullptr;
+    }
+    results_job_ = nullptr;
+    if (results_drain_id_) {
+        g_source_remove(results_drain_id_);
+        results_drain_id_ = 0;
+    }
+    if (results_rescan_id_) {
+        g_source_remove(results_rescan_id_);
+        results_rescan_id_ = 0;
+    }
+}
+
+void Editor::start_results_scan() {
+    stop_results_scan();
+
+    results_.clear();
+    results_hits_->reset(0);
+    gtk_tree_view_set_model(GTK_TREE_VIEW(results_view_), results_hits_->model());
+    ruler_->hits_reset();
+
+    delete results_matcher_;
+    results_matcher_ = nullptr;
+    if (last_query_.empty()) {
+        update_results_label();
+        return;
+    }
+
+    results_matcher_ = new TextMatcher(last_query_, search_case_sensitive_, search_regex_);
+    if (!results_matcher_->valid()) {
+        update_results_label();
+        return;
+    }
+
+    GtkTextIter s, e;
+    gtk_text_buffer_get_bounds(buffer_, &s, &e);
+    gchar* text = gtk_text_buffer_get_text(buffer_, &s, &e, TRUE);
+
+    results_cancel_ = g_cancellable_new();
+
+    MatchScanJob* job = new MatchScanJob();
+    job->text = text ? text : "";
+    g_free(text);
+    job->query = last_query_;
+    job->case_sensitive = search_case_sensitive_;
+    job->regex = search_regex_;
+    job->cancel = G_CANCELLABLE(g_object_ref(results_cancel_));
+    results_job_ = job;
+
+    GTask* task = g_task_new(nullptr, results_cancel_, Editor::s_on_results_scan_done, this);
+    g_task_set_task_data(task, job, [](gpointer p) { delete static_cast<MatchScanJob*>(p); });
+    g_task_run_in_thread(task, match_scan_thread);
+    g_object_unref(task);
+
+    results_drain_id_ = g_timeout_add(50, Editor::s_on_results_drain, this);
+    update_results_label();
+}
+
+void Editor::drain_results() {
+    if (!results_job_) return;
+
+    std::vector<MatchIndex::Hit> batch;
+    g_mutex_lock(&results_job_->lock);
+    batch.swap(results_job_->pending);
+    g_mutex_unlock(&results_job_->lock);
+    if (batch.empty()) return;
+
+    const size_t from = results_.size();
+    results_.append(batch);
+    ruler_->hits_appended(from);
+
+    // Announcing a huge batch row by row costs more than swapping the
+    // model; new rows only ever land past the current scroll position.
+    if (batch.size() > 20000) {
+        GtkAdjustment* adj = gtk_scrollable_get_vadjustment(GTK_SCROLLABLE(results_view_));
+        const double pos = gtk_adjustment_get_value(adj);
+        results_hits_->reset(results_.size());
+        gtk_tree_view_set_model(GTK_TREE_VIEW(results_view_), results_hits_->model());
+        gtk_adjustment_set_value(adj, pos);
+    } else {
+        results_hits_->append(batch.size());
+    }
+    update_results_label();
+}
+
+// Lines [line, line + old_lines) became [line, line + new_lines): rescan just those.
+void Editor::results_lines_changed(int line, int old_lines, int new_lines) {
+    if (!results_matcher_ || !results_matcher_->valid()) return;
+    if (results_job_ || bulk_edit_ || new_lines > kResultsRescanLines) {
+        schedule_results_rescan();
+        return;
+    }
+
+    GtkTextIter s, e;
+    gtk_text_buffer_get_iter_at_line(buffer_, &s, line);
+    e = s;
+    gtk_text_iter_forward_lines(&e, new_lines);
+    gchar* text = gtk_text_buffer_get_text(buffer_, &s, &e, TRUE);
+
+    std::vector<MatchIndex::Hit> hits;
+    if (text) {
+        MatchIndex::scan(*results_matcher_, text, std::strlen(text), line, [&](const MatchIndex::Hit& h) {
+            if (h.line < line + new_lines) hits.push_back(h);
+            return true;
+        }, nullptr);
+        g_free(text);
+    }
+
+    MatchIndex::Splice sp = results_.replace_lines(line, old_lines, new_lines, std::move(hits));
+    if (sp.inserted > sp.removed) results_hits_->insert(sp.at + sp.removed, sp.inserted - sp.removed);
+    else if (sp.removed > sp.inserted) results_hits_->remove(sp.at + sp.inserted, sp.removed - sp.inserted);
+    ruler_->hits_changed(line, old_lines, new_lines);
+
+    // rows below moved to other line numbers; cells are formatted on draw
+    gtk_widget_queue_draw(results_view_);
+    update_results_label();
+}
+
+void Editor::schedule_results_rescan() {
+    if (results_rescan_id_) g_source_remove(results_rescan_id_);
+    results_rescan_id_ = g_timeout_add(search_debounce_ms(buffer_), Editor::s_on_results_rescan, this);
+}
+
+void Editor::update_results_label() {
+    if (!results_label_) return;
+
+    std::stringstream ss;
+    if (last_query_.empty()) {
+        ss << "Type in the search bar to list matches";
+    } else if (results_matcher_ && !results_matcher_->valid()) {
+        ss << results_matcher_->error();
+    } else {
+        ss << results_.size() << (results_.size() == 1 ? " match" : " matches")
+           << " for \"" << last_query_ << "\"";
+        if (results_job_) ss << " (scanning…)";
+    }
+    gtk_label_set_text(GTK_LABEL(results_label_), ss.str().c_str());
+}
+
+// ───────────────────────────────────────────────
+//  Replace All preview
+// ───────────────────────────────────────────────
+
+static const gint kResponseAcceptAll = 1;
+static const gint kResponseRejectAll = 2;
+static const size_t kPreviewColumnBytes = 240;
+
+void Editor::start_replace_preview(const std::string& query, const std::string& repl) {
+    trace::Span span("Editor::start_replace_preview");
+    if (replace_preview_cancel_) {
+        g_cancellable_cancel(replace_preview_cancel_);
+        g_object_unref(replace_preview_cancel_);
+        replace_preview_cancel_ = nullptr;
+    }
+
+    replace_query_ = query;
+    replace_with_ = repl;
+    replace_plan_.clear();
+    show_replace_preview();
+    if (query.empty()) return;
+
+    // only the scope is snapshotted and scanned when one is active
+    GtkTextIter s, e;
+    if (!get_search_scope(&s, &e)) gtk_text_buffer_get_bounds(buffer_, &s, &e);
+    gchar* text = gtk_text_buffer_get_text(buffer_, &s, &e, TRUE);
+
+    replace_preview_cancel_ = g_cancellable_new();
+
+    ReplacePreviewJob* job = new ReplacePreviewJob();
+    job->text = text ? text : "";
+    g_free(text);
+    job->base_line = gtk_text_iter_get_line(&s);
+    job->base_index = gtk_text_iter_get_line_index(&s);
+    job->query = query;
+    job->repl = repl;
+    job->case_sensitive = search_case_sensitive_;
+    job->regex = search_regex_;
+    job->serial = edit_serial_;
+    job->cancel = G_CANCELLABLE(g_object_ref(replace_preview_cancel_));
+
+    GTask* task = g_task_new(nullptr, replace_preview_cancel_, Editor::s_on_replace_preview_done, this);
+    g_task_set_task_data(task, job, [](gpointer p) { delete static_cast<ReplacePreviewJob*>(p); });
+    g_task_run_in_thread(task, replace_preview_thread);
+    g_object_unref(task);
+}
+
+void Editor::show_replace_preview() {
+    if (!replace_hits_) {
+        replace_hits_ = new HitListModel(
+            { G_TYPE_BOOLEAN, G_TYPE_INT, G_TYPE_STRING, G_TYPE_STRING },
+            [this](size_t row, int column, GValue* value) {
+                const ReplacePlan::Hunk& h = replace_plan_.hunks()[row];
+                switch (column) {
+                case 0: g_value_set_boolean(value, h.accepted); break;
+                case 1: g_value_set_int(value, replace_base_line_ + h.line + 1); break;
+                case 2: g_value_set_string(value, replace_plan_.before(row, kPreviewColumnBytes).c_str()); break;
+                case 3: g_value_set_string(value, replace_plan_.after(row, kPreviewColumnBytes).c_str()); break;
+                }
+            });
+    }
+    replace_hits_->reset(0);
+
+    if (replace_preview_) {
+        GtkWidget* tree = GTK_WIDGET(g_object_get_data(G_OBJECT(replace_preview_), "results"));
+        gtk_tree_view_set_model(GTK_TREE_VIEW(tree), replace_hits_->model());
+        update_replace_preview_status();
+        gtk_window_present(GTK_WINDOW(replace_preview_));
+        return;
+    }
+
+    GtkWidget* dialog = gtk_dialog_new_with_buttons(
+        "Replace All",
+        GTK_WINDOW(window_),
+        GTK_DIALOG_DESTROY_WITH_PARENT,
+        "Accept All", kResponseAcceptAll,
+        "Reject All", kResponseRejectAll,
+        "_Cancel", GTK_RESPONSE_CANCEL,
+        "_Replace", GTK_RESPONSE_APPLY,
+        nullptr);
+    gtk_window_set_default_size(GTK_WINDOW(dialog), 900, 520);
+    gtk_dialog_set_default_response(GTK_DIALOG(dialog), GTK_RESPONSE_APPLY);
+
+    replace_preview_ = dialog;
+
+    GtkWidget* content = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
+    GtkWidget* box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
+    gtk_container_set_border_width(GTK_CONTAINER(box), 8);
+    gtk_box_pack_start(GTK_BOX(content), box, TRUE, TRUE, 0);
+
+    // fixed-height rows: the view only ever measures and renders what is on screen
+    GtkWidget* tree = gtk_tree_view_new_with_model(replace_hits_->model());
+    gtk_tree_view_set_fixed_height_mode(GTK_TREE_VIEW(tree), TRUE);
+
+    GtkCellRenderer* toggle = gtk_cell_renderer_toggle_new();
+    g_signal_connect(toggle, "toggled", G_CALLBACK(Editor::s_on_replace_hunk_toggled), this);
+    GtkTreeViewColumn* col = gtk_tree_view_column_new_with_attributes("Apply", toggle, "active", 0, nullptr);
+    gtk_tree_view_column_set_sizing(col, GTK_TREE_VIEW_COLUMN_FIXED);
+    gtk_tree_view_column_set_fixed_width(col, 56);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(tree), col);
+
+    GtkCellRenderer* cell = gtk_cell_renderer_text_new();
+    g_object_set(cell, "family", "Monospace", nullptr);
+    const struct { const char* title; int column; int width; } cols[] = {
+        { "Line", 1, 64 }, { "Before", 2, 380 }, { "After", 3, 380 },
+    };
+    for (const auto& c : cols) {
+        col = gtk_tree_view_column_new_with_attributes(c.title, cell, "text", c.column, nullptr);
+        gtk_tree_view_column_set_sizing(col, GTK_TREE_VIEW_COLUMN_FIXED);
+        gtk_tree_view_column_set_fixed_width(col, c.width);
+        gtk_tree_view_column_set_resizable(col, TRUE);
+        gtk_tree_view_append_column(GTK_TREE_VIEW(tree), col);
+    }
+    g_signal_connect(tree, "row-activated", G_CALLBACK(Editor::s_on_replace_preview_row_activated), this);
+
+    GtkWidget* scrolled = gtk_scrolled_window_new(nullptr, nullptr);
+    gtk_container_add(GTK_CONTAINER(scrolled), tree);
+    gtk_box_pack_start(GTK_BOX(box), scrolled, TRUE, TRUE, 0);
+
+    GtkWidget* status = gtk_label_new("");
+    gtk_label_set_xalign(GTK_LABEL(status), 0.0f);
+    gtk_box_pack_start(GTK_BOX(box), status, FALSE, FALSE, 0);
+
+    g_object_set_data(G_OBJECT(dialog), "results", tree);
+    g_object_set_data(G_OBJECT(dialog), "status", status);
+
+    g_signal_connect(dialog, "response", G_CALLBACK(Editor::s_on_replace_preview_response), this);
+    update_replace_preview_status();
+    gtk_widget_show_all(dialog);
+}
+
+void Editor::update_replace_preview_status() {
+    if (!replace_preview_) return;
+    GtkWidget* status = GTK_WIDGET(g_object_get_data(G_OBJECT(replace_preview_), "status"));
+    if (!status) return;
+
+    std::stringstream ss;
+    if (replace_preview_cancel_) {
+        ss << "Finding matches for \"" << replace_query_ << "\"…";
+    } else if (!replace_plan_.error().empty()) {
+        ss << replace_plan_.error();
+    } else if (replace_plan_.empty()) {
+        ss << "No matches for \"" << replace_query_ << "\"";
+    } else {
+        ss << replace_plan_.accepted_edits() << " of " << replace_plan_.edits().size()
+           << " replacements selected on " << replace_plan_.hunks().size() << " lines";
+        if (replace_plan_serial_ != edit_serial_)
+            ss << " (text changed; Replace will recompute first)";
+    }
+    gtk_label_set_text(GTK_LABEL(status), ss.str().c_str());
+}
+
+// Accepted hunks go in as one user action. Edits are applied back to front
+// so the line/byte positions recorded against the snapshot stay valid.
+void Editor::apply_replace_plan() {
+    trace::Span span("Editor::apply_replace_plan");
+    const std::string& text = replace_plan_.text();
+    const std::vector<ReplacePlan::Edit>& edits = replace_plan_.edits();
+    const std::vector<ReplacePlan::Hunk>& hunks = replace_plan_.hunks();
+
+    // One iterator walks back through the snapshot. Everything before the
+    // edit being made is still the snapshot's text, so counting characters
+    // over the gap places it without resolving a line and index per edit.
+    GtkTextIter at;
+    gtk_text_buffer_get_iter_at_line_index(buffer_, &at, replace_base_line_, replace_base_index_);
+    size_t pos = 0;
+    bool placed = false;
+
+    size_t applied = 0;
+    bulk_edit_ = true;
+    gtk_text_buffer_begin_user_action(buffer_);
+
+    for (size_t i = hunks.size(); i-- > 0;) {
+        const ReplacePlan::Hunk& h = hunks[i];
+        if (!h.accepted) continue;
+
+        for (uint32_t k = h.first_edit + h.n_edits; k-- > h.first_edit;) {
+            const ReplacePlan::Edit& ed = edits[k];
+            if (!placed) {
+                gtk_text_iter_forward_chars(&at, (gint)g_utf8_strlen(text.data(), (gssize)ed.end));
+                placed = true;
+            } else {
+                gtk_text_iter_backward_chars(&at, (gint)g_utf8_strlen(text.data() + ed.end,
+                                                                      (gssize)(pos - ed.end)));
+            }
+
+            GtkTextIter ms = at;
+            gtk_text_iter_backward_chars(&ms, (gint)g_utf8_strlen(text.data() + ed.start,
+                                                                  (gssize)(ed.end - ed.start)));
+            gtk_text_buffer_delete(buffer_, &ms, &at);
+            gtk_text_buffer_insert(buffer_, &at, ed.text.data(), (gint)ed.text.size());
+            gtk_text_iter_backward_chars(&at, (gint)g_utf8_strlen(ed.text.data(), (gssize)ed.text.size()));
+            pos = ed.start;
+            ++applied;
+        }
+    }
+
+    gtk_text_buffer_end_user_action(buffer_);
+    bulk_edit_ = false;
+    if (applied) mark_modified(true);
+}
+
+void Editor::close_replace_preview() {
+    if (replace_preview_cancel_) {
+        g_cancellable_cancel(replace_preview_cancel_);
+        g_object_unref(replace_preview_cancel_);
+        replace_preview_cancel_ = nullptr;
+    }
+    if (replace_preview_) {
+        gtk_widget_destroy(replace_preview_);
+        replace_preview_ = nullptr;
+    }
+    if (replace_hits_) replace_hits_->reset(0);
+    replace_plan_.clear();
+}
+
+void Editor::show_goto_line_dialog() {
+    GtkWidget* dialog = gtk_dialog_new_with_buttons(
+        "Go to Line",
+        GTK_WINDOW(window_),
+        GTK_DIALOG_MODAL,
+        "_Cancel", GTK_RESPONSE_CANCEL,
+        "_Go", GTK_RESPONSE_OK,
+        nullptr);
+
+    GtkWidget* content = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
+    GtkWidget* box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
+    gtk_container_set_border_width(GTK_CONTAINER(box), 8);
+    gtk_container_add(GTK_CONTAINER(content), box);
+
+    GtkWidget* label = gtk_label_new("Line number (1-based):");
+    gtk_box_pack_start(GTK_BOX(box), label, FALSE, FALSE, 0);
+
+    GtkWidget* entry = gtk_entry_new();
+    gtk_entry_set_activates_default(GTK_ENTRY(entry), TRUE);
+    gtk_box_pack_start(GTK_BOX(box), entry, FALSE, FALSE, 0);
+
+    gtk_dialog_set_default_response(GTK_DIALOG(dialog), GTK_RESPONSE_OK);
+    g_object_set_data(G_OBJECT(dialog), "line_entry", entry);
+
+    g_signal_connect(dialog, "response", G_CALLBACK(Editor::s_on_goto_line_response), this);
+    gtk_widget_show_all(dialog);
+}
+
+void Editor::goto_line(int line, int column) {
+    if (line <= 0) return;
+
+    int line_count = gtk_text_buffer_get_line_count(buffer_);
+    if (line > line_count) line = line_count;
+
+    GtkTextIter iter;
+    gtk_text_buffer_get_iter_at_line(buffer_, &iter, line - 1);
+    if (column > 1) {
+        GtkTextIter end = iter;
+        if (!gtk_text_iter_ends_line(&end)) gtk_text_iter_forward_to_line_end(&end);
+        gtk_text_iter_set_line_offset(&iter, std::min(column - 1, gtk_text_iter_get_line_offset(&end)));
+    }
+    gtk_text_buffer_place_cursor(buffer_, &iter);
+
+    // nearby: a plain scroll only lays out what it passes
+    GdkRectangle r;
+    gint y = 0, h = 0;
+    gtk_text_view_get_visible_rect(GTK_TEXT_VIEW(text_view_), &r);
+    gtk_text_view_get_line_yrange(GTK_TEXT_VIEW(text_view_), &iter, &y, &h);
+    if (y + h > r.y - r.height && y < r.y + 2 * r.height)
+        gtk_text_view_scroll_to_iter(GTK_TEXT_VIEW(text_view_), &iter, 0.2, FALSE, 0, 0);
+    else
+        fast_scroll_to_line(GTK_TEXT_VIEW(text_view_), line - 1, 0.3);
+    update_status_full();
+}
+
+// ───────────────────────────────────────────────
+//  Project search
+// ───────────────────────────────────────────────
+
+void Editor::show_project_search_dialog() {
+    if (project_dialog_) {
+        gtk_window_present(GTK_WINDOW(project_dialog_));
+        return;
+    }
+
+    GtkWidget* dialog = gtk_dialog_new_with_buttons(
+        "Find in Project",
+        GTK_WINDOW(window_),
+        GTK_DIALOG_DESTROY_WITH_PARENT,
+        "_Close", GTK_RESPONSE_CLOSE,
+        "_Search", GTK_RESPONSE_OK,
+        nullptr);
+    gtk_window_set_default_size(GTK_WINDOW(dialog), 720, 480);
+    gtk_dialog_set_default_response(GTK_DIALOG(dialog), GTK_RESPONSE_OK);
+
+    project_dialog_ = dialog;
+
+    GtkWidget* content = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
+    GtkWidget* box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
+    gtk_container_set_border_width(GTK_CONTAINER(box), 8);
+    gtk_box_pack_start(GTK_BOX(content), box, TRUE, TRUE, 0);
+
+    GtkWidget* entry = gtk_entry_new();
+    gtk_entry_set_activates_default(GTK_ENTRY(entry), TRUE);
+    gtk_box_pack_start(GTK_BOX(box), entry, FALSE, FALSE, 0);
+
+    // abs path, line, display path, text
+    GtkListStore* store = gtk_list_store_new(4, G_TYPE_STRING, G_TYPE_INT, G_TYPE_STRING, G_TYPE_STRING);
+    GtkWidget* tree = gtk_tree_view_new_with_model(GTK_TREE_MODEL(store));
+    g_object_unref(store);
+
+    GtkCellRenderer* cell = gtk_cell_renderer_text_new();
+    gtk_tree_view_append_column(GTK_TREE_VIEW(tree),
+        gtk_tree_view_column_new_with_attributes("File", cell, "text", 2, nullptr));
+    gtk_tree_view_append_column(GTK_TREE_VIEW(tree),
+        gtk_tree_view_column_new_with_attributes("Line", cell, "text", 1, nullptr));
+    gtk_tree_view_append_column(GTK_TREE_VIEW(tree),
+        gtk_tree_view_column_new_with_attributes("Text", cell, "text", 3, nullptr));
+    g_signal_connect(tree, "row-activated", G_CALLBACK(Editor::s_on_project_row_activated), this);
+
+    GtkWidget* scrolled = gtk_scrolled_window_new(nullptr, nullptr);
+    gtk_container_add(GTK_CONTAINER(scrolled), tree);
+    gtk_box_pack_start(GTK_BOX(box), scrolled, TRUE, TRUE, 0);
+
+    GtkWidget* status = gtk_label_new("");
+    gtk_label_set_xalign(GTK_LABEL(status), 0.0f);
+    gtk_box_pack_start(GTK_BOX(box), status, FALSE, FALSE, 0);
+
+    g_object_set_data(G_OBJECT(dialog), "find_entry", entry);
+    g_object_set_data(G_OBJECT(dialog), "results", tree);
+    g_object_set_data(G_OBJECT(dialog), "status", status);
+
+    g_signal_connect(dialog, "response", G_CALLBACK(Editor::s_on_project_dialog_response), this);
+    gtk_widget_show_all(dialog);
+}
+
+void Editor::project_search(const std::string& query) {
+    if (project_search_cancel_) {
+        g_cancellable_cancel(project_search_cancel_);
+        g_object_unref(project_search_cancel_);
+        project_search_cancel_ = nullptr;
+    }
+    if (query.empty()) return;
+
+    const std::string root = find_project_root(current_file_);
+
+    ProjectSearchJob* job = new ProjectSearchJob();
+    job->root = root;
+    job->query = query;
+    job->case_sensitive = search_settings_ &&
+        gtk_source_search_settings_get_case_sensitive(search_settings_);
+
+    if (project_index_enabled_) ensure_project_index(root);
+
+    if (project_index_enabled_ && project_index_.loaded() && project_index_.root() == root) {
+        job->files = project_index_.candidates(query);
+        // files touched since the index was written are always verified
+        std::set<std::string> merged(job->files.begin(), job->files.end());
+        for (const std::string& p : project_dirty_) {
+            if (merged.insert(p).second) job->files.push_back(p);
+        }
+    } else {
+        job->walk = true;
+    }
+
+    project_search_cancel_ = g_cancellable_new();
+    job->cancel = G_CANCELLABLE(g_object_ref(project_search_cancel_));
+
+    if (project_dialog_) {
+        GtkWidget* status = GTK_WIDGET(g_object_get_data(G_OBJECT(project_dialog_), "status"));
+        std::string msg = job->walk ? "Scanning " + root + "…"
+                                    : "Checking " + std::to_string(job->files.size()) + " candidate files…";
+        if (status) gtk_label_set_text(GTK_LABEL(status), msg.c_str());
+    }
+
+    GTask* task = g_task_new(nullptr, project_search_cancel_, Editor::s_on_project_search_done, this);
+    g_task_set_task_data(task, job, [](gpointer p) { delete static_cast<ProjectSearchJob*>(p); });
+    g_task_run_in_thread(task, project_search_thread);
+    g_object_unref(task);
+}
+
+void Editor::ensure_project_index(const std::string& root) {
+    if (project_root_ == root && (project_index_.loaded() || index_building_)) return;
+
+    // switching projects: drop watchers and pending work for the old root
+    if (project_root_ != root) {
+        if (index_cancel_) g_cancellable_cancel(index_cancel_);
+        index_building_ = false;
+        remove_project_monitors();
+        project_dirty_.clear();
+        project_index_.close();
+        project_root_ = root;
+    }
+
+    if (project_index_.load(index_path_for_root(root), root)) {
+        if (index_cancel_) g_object_unref(index_cancel_);
+        index_cancel_ = g_cancellable_new();
+
+        IndexValidateJob* job = new IndexValidateJob();
+        job->root = root;
+        job->known = project_index_.files();
+        job->cancel = G_CANCELLABLE(g_object_ref(index_cancel_));
+
+        GTask* task = g_task_new(nullptr, index_cancel_, Editor::s_on_index_validate_done, this);
+        g_task_set_task_data(task, job, [](gpointer p) { delete static_cast<IndexValidateJob*>(p); });
+        g_task_run_in_thread(task, index_validate_thread);
+        g_object_unref(task);
+        return;
+    }
+
+    start_index_build();
+}
+
+void Editor::start_index_build() {
+    if (project_root_.empty() || index_building_) return;
+
+    if (index_cancel_) {
+        g_cancellable_cancel(index_cancel_);
+        g_object_unref(index_cancel_);
+    }
+    index_cancel_ = g_cancellable_new();
+    index_building_ = true;
+
+    IndexBuildJob* job = new IndexBuildJob();
+    job->root = project_root_;
+    job->index_path = index_path_for_root(project_root_);
+    job->memory_budget = (size_t)std::max(index_memory_mb_, 4) << 20;
+    job->dirty_before = project_dirty_;
+    job->cancel = G_CANCELLABLE(g_object_ref(index_cancel_));
+
+    GTask* task = g_task_new(nullptr, index_cancel_, Editor::s_on_index_build_done, this);
+    g_task_set_task_data(task, job, [](gpointer p) { delete static_cast<IndexBuildJob*>(p); });
+    g_task_run_in_thread(task, index_build_thread);
+    g_object_unref(task);
+}
+
+void Editor::schedule_index_rebuild(guint seconds) {
+    if (index_rebuild_id_) g_source_remove(index_rebuild_id_);
+    index_rebuild_id_ = g_timeout_add_seconds(seconds, Editor::s_on_index_rebuild_timeout, this);
+}
+
+void Editor::install_project_monitors(const std::vector<std::string>& dirs) {
+    remove_project_monitors();
+
+    // inotify watches are a shared, limited resource; past the cap, changes
+    // in unwatched directories are picked up by the next rebuild
+    for (size_t i = 0; i < dirs.size() && i < kMaxProjectMonitors; ++i) {
+        GFile* f = g_file_new_for_path(dirs[i].c_str());
+        GFileMonitor* mon = g_file_monitor_directory(f, G_FILE_MONITOR_WATCH_MOVES, nullptr, nullptr);
+        g_object_unref(f);
+        if (!mon) continue;
+        g_signal_connect(mon, "changed", G_CALLBACK(Editor::s_on_project_dir_changed), this);
+        project_monitors_.push_back(mon);
+    }
+}
+
+void Editor::remove_project_monitors() {
+    for (GFileMonitor* mon : project_monitors_) {
+        g_signal_handlers_disconnect_by_data(mon, this);
+        g_file_monitor_cancel(mon);
+        g_object_unref(mon);
+    }
+    project_monitors_.clear();
+}
+
+void Editor::cancel_project_jobs() {
+    if (project_search_cancel_) {
+        g_cancellable_cancel(project_search_cancel_);
+        g_object_unref(project_search_cancel_);
+        project_search_cancel_ = nullptr;
+    }
+    if (index_cancel_) {
+        g_cancellable_cancel(index_cancel_);
+        g_object_unref(index_cancel_);
+        index_cancel_ = nullptr;
+    }
+    if (index_rebuild_id_) {
+        g_source_remove(index_rebuild_id_);
+        index_rebuild_id_ = 0;
+    }
+    index_building_ = false;
+    remove_project_monitors();
+}
+
+// ───────────────────────────────────────────────
+//  Pinned terms
+// ───────────────────────────────────────────────
 
-    int count = 0;
-    gtk_text_buffer_begin_user_action(buffer_);
+// legible on light and dark themes alike (tags also force a dark foreground)
+static const char* const kPinColors[] = {
+    "#fff3a0", "#c8f0c8", "#c8dcff", "#ffd0d0",
+    "#e8d0ff", "#ffe0b8", "#c8f0f0", "#e0e0e0",
+};
+static const size_t kMaxPinnedTerms = 64;
+static const int kPinMarginLines = 40;
+static const int kPinChunkLines = 2000;
+
+void Editor::setup_pins() {
+    GtkTextIter start;
+    gtk_text_buffer_get_start_iter(buffer_, &start);
+    pin_dirty_start_ = gtk_text_buffer_create_mark(buffer_, nullptr, &start, TRUE);
+    pin_dirty_end_   = gtk_text_buffer_create_mark(buffer_, nullptr, &start, FALSE);
+    pin_view_start_  = gtk_text_buffer_create_mark(buffer_, nullptr, &start, TRUE);
+    pin_view_end_    = gtk_text_buffer_create_mark(buffer_, nullptr, &start, FALSE);
+
+    g_signal_connect_after(buffer_, "insert-text", G_CALLBACK(Editor::s_on_pin_insert_text), this);
+    g_signal_connect_after(buffer_, "delete-range", G_CALLBACK(Editor::s_on_pin_delete_range), this);
+
+    // terms restored from the session
+    std::vector<std::string> terms;
+    terms.swap(pinned_terms_);
+    set_pinned_terms(terms);
+}
 
-    while (gtk_source_search_context_forward(search_context_, &iter, &mstart, &mend)) {
-        gtk_text_buffer_delete(buffer_, &mstart, &mend);
-        gtk_text_buffer_insert(buffer_, &mstart, repl.c_str(), -1);
-        count++;
+void Editor::set_pinned_terms(const std::vector<std::string>& terms) {
+    GtkTextIter s, e;
+    gtk_text_buffer_get_bounds(buffer_, &s, &e);
+    for (GtkTextTag* t : pin_tags_) gtk_text_buffer_remove_tag(buffer_, t, &s, &e);
+
+    pinned_terms_.clear();
+    for (const std::string& t : terms) {
+        if (t.empty() || t.find('\n') != std::string::npos) continue;
+        if (std::find(pinned_terms_.begin(), pinned_terms_.end(), t) != pinned_terms_.end()) continue;
+        if (pinned_terms_.size() >= kMaxPinnedTerms) break;
+        pinned_terms_.push_back(t);
+    }
 
-        iter = mstart;
-        gtk_text_iter_forward_chars(&iter, (gint)repl.size());
+    GtkTextTagTable* table = gtk_text_buffer_get_tag_table(buffer_);
+    while (pin_tags_.size() < pinned_terms_.size()) {
+        const size_t i = pin_tags_.size();
+        std::string name = "pin-" + std::to_string(i);
+        GtkTextTag* tag = gtk_text_tag_table_lookup(table, name.c_str());
+        if (!tag) {
+            tag = gtk_text_buffer_create_tag(buffer_, name.c_str(),
+                                             "background", kPinColors[i % G_N_ELEMENTS(kPinColors)],
+                                             "foreground", "#000000",
+                                             nullptr);
+        }
+        pin_tags_.push_back(tag);
     }
 
-    gtk_text_buffer_end_user_action(buffer_);
-    (void)count;
+    pin_matcher_.build(pinned_terms_, false);
+    pin_dirty_ = false;
+    pin_view_valid_ = false;
+    schedule_pin_scan();
 }
 
-void Editor::show_find_dialog() {
-    if (find_dialog_) {
-        gtk_window_present(GTK_WINDOW(find_dialog_));
-        return;
-    }
+void Editor::toggle_pinned_term(const std::string& term) {
+    std::vector<std::string> terms = pinned_terms_;
+    auto it = std::find(terms.begin(), terms.end(), term);
+    if (it != terms.end()) terms.erase(it);
+    else terms.push_back(term);
+    set_pinned_terms(terms);
+}
 
+void Editor::show_pin_term_dialog() {
     GtkWidget* dialog = gtk_dialog_new_with_buttons(
-        "Find",
+        "Pin Term",
         GTK_WINDOW(window_),
         GTK_DIALOG_MODAL,
-        "_Close", GTK_RESPONSE_CLOSE,
-        "_Find Next", GTK_RESPONSE_OK,
+        "_Cancel", GTK_RESPONSE_CANCEL,
+        "_Pin", GTK_RESPONSE_OK,
         nullptr);
 
-    find_dialog_ = dialog;
-
     GtkWidget* content = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
     GtkWidget* box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
     gtk_container_set_border_width(GTK_CONTAINER(box), 8);
     gtk_container_add(GTK_CONTAINER(content), box);
 
-    GtkWidget* label = gtk_label_new("Find text:");
+    GtkWidget* label = gtk_label_new("Term to highlight (pinning it again unpins it):");
     gtk_box_pack_start(GTK_BOX(box), label, FALSE, FALSE, 0);
 
     GtkWidget* entry = gtk_entry_new();
+    gtk_entry_set_activates_default(GTK_ENTRY(entry), TRUE);
+    gtk_entry_set_text(GTK_ENTRY(entry), last_query_.c_str());
     gtk_box_pack_start(GTK_BOX(box), entry, FALSE, FALSE, 0);
 
-    g_object_set_data(G_OBJECT(dialog), "find_entry", entry);
+    gtk_dialog_set_default_response(GTK_DIALOG(dialog), GTK_RESPONSE_OK);
+    g_object_set_data(G_OBJECT(dialog), "term_entry", entry);
 
-    g_signal_connect(dialog, "response", G_CALLBACK(Editor::s_on_find_dialog_response), this);
+    g_signal_connect(dialog, "response", G_CALLBACK(Editor::s_on_pin_term_response), this);
     gtk_widget_show_all(dialog);
 }
 
-void Editor::show_replace_dialog() {
-    if (replace_dialog_) {
-        gtk_window_present(GTK_WINDOW(replace_dialog_));
-        return;
-    }
-
-    GtkWidget* dialog = gtk_dialog_new_with_buttons(
-        "Replace",
-        GTK_WINDOW(window_),
-        GTK_DIALOG_MODAL,
-        "_Close", GTK_RESPONSE_CLOSE,
-        "_Replace", GTK_RESPONSE_ACCEPT,
-        "Replace _All", GTK_RESPONSE_APPLY,
-        nullptr);
+// After the whole buffer was replaced (open/new/reload) nothing is "edited";
+// only the viewport needs tagging again.
+void Editor::pins_reset() {
+    pin_dirty_ = false;
+    pin_view_valid_ = false;
+    schedule_pin_scan();
+}
 
-    replace_dialog_ = dialog;
+void Editor::pin_mark_dirty(const GtkTextIter* start, const GtkTextIter* end) {
+    if (pin_matcher_.empty()) return;
 
-    GtkWidget* content = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
-    GtkWidget* box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
-    gtk_container_set_border_width(GTK_CONTAINER(box), 8);
-    gtk_container_add(GTK_CONTAINER(content), box);
+    GtkTextIter ls = *start, le = *end;
+    gtk_text_iter_set_line_offset(&ls, 0);
+    if (!gtk_text_iter_ends_line(&le)) gtk_text_iter_forward_to_line_end(&le);
 
-    GtkWidget* find_label = gtk_label_new("Find text:");
-    gtk_box_pack_start(GTK_BOX(box), find_label, FALSE, FALSE, 0);
+    if (pin_dirty_) {
+        GtkTextIter ds, de;
+        gtk_text_buffer_get_iter_at_mark(buffer_, &ds, pin_dirty_start_);
+        gtk_text_buffer_get_iter_at_mark(buffer_, &de, pin_dirty_end_);
+        if (gtk_text_iter_compare(&ds, &ls) < 0) ls = ds;
+        if (gtk_text_iter_compare(&de, &le) > 0) le = de;
+    }
 
-    GtkWidget* find_entry = gtk_entry_new();
-    gtk_box_pack_start(GTK_BOX(box), find_entry, FALSE, FALSE, 0);
+    gtk_text_buffer_move_mark(buffer_, pin_dirty_start_, &ls);
+    gtk_text_buffer_move_mark(buffer_, pin_dirty_end_, &le);
+    pin_dirty_ = true;
+    schedule_pin_scan();
+}
 
-    GtkWidget* repl_label = gtk_label_new("Replace with:");
-    gtk_box_pack_start(GTK_BOX(box), repl_label, FALSE, FALSE, 0);
+void Editor::schedule_pin_scan() {
+    if (pin_idle_id_ || pin_matcher_.empty()) return;
+    // ahead of the redraw so newly exposed lines paint with their tags
+    pin_idle_id_ = g_idle_add_full(G_PRIORITY_HIGH_IDLE, Editor::s_on_pin_idle, this, nullptr);
+}
 
-    GtkWidget* repl_entry = gtk_entry_new();
-    gtk_box_pack_start(GTK_BOX(box), repl_entry, FALSE, FALSE, 0);
+void Editor::get_visible_range(int margin_lines, GtkTextIter* start, GtkTextIter* end) {
+    GdkRectangle r;
+    gtk_text_view_get_visible_rect(GTK_TEXT_VIEW(text_view_), &r);
+    if (long_line_mode_) {
+        // one wrapped line may fill the screen many times over: go by display
+        // rows, a screenful of margin either side, and keep to the shown
+        // text around the cursor (or the top of the view), not the hidden
+        // megabytes between the rows
+        gtk_text_view_get_iter_at_location(GTK_TEXT_VIEW(text_view_), start, 0, std::max(0, r.y - r.height));
+        gtk_text_view_get_iter_at_location(GTK_TEXT_VIEW(text_view_), end, r.x + r.width, r.y + 2 * r.height);
+        if (!gtk_text_iter_ends_line(end)) gtk_text_iter_forward_char(end);
+
+        GtkTextIter anchor;
+        gtk_text_buffer_get_iter_at_mark(buffer_, &anchor, gtk_text_buffer_get_insert(buffer_));
+        if (gtk_text_iter_compare(&anchor, start) < 0 || gtk_text_iter_compare(&anchor, end) > 0)
+            gtk_text_view_get_iter_at_location(GTK_TEXT_VIEW(text_view_), &anchor, r.x, r.y);
+        line_guard_->clip_to_shown(&anchor, start, end);
+        return;
+    }
+    gtk_text_view_get_line_at_y(GTK_TEXT_VIEW(text_view_), start, r.y, nullptr);
+    gtk_text_view_get_line_at_y(GTK_TEXT_VIEW(text_view_), end, r.y + r.height, nullptr);
 
-    g_object_set_data(G_OBJECT(dialog), "find_entry", find_entry);
-    g_object_set_data(G_OBJECT(dialog), "repl_entry", repl_entry);
+    const int first = std::max(0, gtk_text_iter_get_line(start) - margin_lines);
+    const int last = gtk_text_iter_get_line(end) + margin_lines;
 
-    g_signal_connect(dialog, "response", G_CALLBACK(Editor::s_on_replace_dialog_response), this);
-    gtk_widget_show_all(dialog);
+    gtk_text_buffer_get_iter_at_line(buffer_, start, first);
+    if (last >= gtk_text_buffer_get_line_count(buffer_)) gtk_text_buffer_get_end_iter(buffer_, end);
+    else {
+        gtk_text_buffer_get_iter_at_line(buffer_, end, last);
+        if (!gtk_text_iter_ends_line(end)) gtk_text_iter_forward_to_line_end(end);
+    }
 }
 
-void Editor::show_goto_line_dialog() {
-    GtkWidget* dialog = gtk_dialog_new_with_buttons(
-        "Go to Line",
-        GTK_WINDOW(window_),
-        GTK_DIALOG_MODAL,
-        "_Cancel", GTK_RESPONSE_CANCEL,
-        "_Go", GTK_RESPONSE_OK,
-        nullptr);
+// One bounded unit of work; returns true while more remains.
+bool Editor::pin_scan_step() {
+    if (pin_matcher_.empty()) return false;
 
-    GtkWidget* content = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
-    GtkWidget* box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
-    gtk_container_set_border_width(GTK_CONTAINER(box), 8);
-    gtk_container_add(GTK_CONTAINER(content), box);
+    // 1) newly exposed part of the viewport
+    GtkTextIter ns, ne;
+    get_visible_range(kPinMarginLines, &ns, &ne);
 
-    GtkWidget* label = gtk_label_new("Line number (1-based):");
-    gtk_box_pack_start(GTK_BOX(box), label, FALSE, FALSE, 0);
+    if (!pin_view_valid_) {
+        pin_scan_lines(&ns, &ne);
+    } else {
+        GtkTextIter vs, ve;
+        gtk_text_buffer_get_iter_at_mark(buffer_, &vs, pin_view_start_);
+        gtk_text_buffer_get_iter_at_mark(buffer_, &ve, pin_view_end_);
 
-    GtkWidget* entry = gtk_entry_new();
-    gtk_entry_set_activates_default(GTK_ENTRY(entry), TRUE);
-    gtk_box_pack_start(GTK_BOX(box), entry, FALSE, FALSE, 0);
+        if (gtk_text_iter_compare(&ne, &vs) <= 0 || gtk_text_iter_compare(&ns, &ve) >= 0) {
+            pin_scan_lines(&ns, &ne);                 // no overlap
+        } else {
+            if (gtk_text_iter_compare(&ns, &vs) < 0) pin_scan_lines(&ns, &vs);
+            if (gtk_text_iter_compare(&ne, &ve) > 0) pin_scan_lines(&ve, &ne);
+        }
+    }
+    gtk_text_buffer_move_mark(buffer_, pin_view_start_, &ns);
+    gtk_text_buffer_move_mark(buffer_, pin_view_end_, &ne);
+    pin_view_valid_ = true;
 
-    gtk_dialog_set_default_response(GTK_DIALOG(dialog), GTK_RESPONSE_OK);
-    g_object_set_data(G_OBJECT(dialog), "line_entry", entry);
+    // 2) edited lines, a chunk at a time so a huge paste cannot stall a frame
+    if (!pin_dirty_) return false;
 
-    g_signal_connect(dialog, "response", G_CALLBACK(Editor::s_on_goto_line_response), this);
-    gtk_widget_show_all(dialog);
-}
+    GtkTextIter ds, de;
+    gtk_text_buffer_get_iter_at_mark(buffer_, &ds, pin_dirty_start_);
+    gtk_text_buffer_get_iter_at_mark(buffer_, &de, pin_dirty_end_);
 
-void Editor::goto_line(int line) {
-    if (line <= 0) return;
+    GtkTextIter ce = ds;
+    gtk_text_iter_forward_lines(&ce, kPinChunkLines);
+    if (gtk_text_iter_compare(&ce, &de) >= 0) ce = de;
+    else if (!gtk_text_iter_ends_line(&ce)) gtk_text_iter_forward_to_line_end(&ce);
 
-    int line_count = gtk_text_buffer_get_line_count(buffer_);
-    if (line > line_count) line = line_count;
+    pin_scan_lines(&ds, &ce);
 
-    GtkTextIter iter;
-    gtk_text_buffer_get_iter_at_line(buffer_, &iter, line - 1);
-    gtk_text_buffer_place_cursor(buffer_, &iter);
-    gtk_text_view_scroll_to_iter(GTK_TEXT_VIEW(text_view_), &iter, 0.2, FALSE, 0, 0);
-    update_status_full();
+    if (gtk_text_iter_compare(&ce, &de) >= 0) {
+        pin_dirty_ = false;
+        return false;
+    }
+    gtk_text_buffer_move_mark(buffer_, pin_dirty_start_, &ce);
+    return true;
+}
+
+void Editor::pin_scan_lines(const GtkTextIter* start, const GtkTextIter* end) {
+    GtkTextIter a = *start, b = *end;
+    if (gtk_text_iter_compare(&a, &b) >= 0) return;
+
+    for (GtkTextTag* t : pin_tags_) gtk_text_buffer_remove_tag(buffer_, t, &a, &b);
+
+    gchar* text = gtk_text_buffer_get_slice(buffer_, &a, &b, TRUE);
+    if (!text) return;
+
+    struct Hit { size_t start, end, term; };
+    std::vector<Hit> hits;
+    pin_matcher_.scan(text, std::strlen(text), [&](size_t term, size_t s, size_t e) {
+        hits.push_back(Hit{ s, e, term });
+    });
+    std::sort(hits.begin(), hits.end(), [](const Hit& x, const Hit& y) { return x.start < y.start; });
+
+    // walk the iterator forward instead of resolving every offset from scratch
+    GtkTextIter it = a;
+    size_t at = 0;
+    for (const Hit& h : hits) {
+        gtk_text_iter_forward_chars(&it, (gint)g_utf8_strlen(text + at, (gssize)(h.start - at)));
+        at = h.start;
+        GtkTextIter he = it;
+        gtk_text_iter_forward_chars(&he, (gint)g_utf8_strlen(text + h.start, (gssize)(h.end - h.start)));
+        gtk_text_buffer_apply_tag(buffer_, pin_tags_[h.term], &it, &he);
+    }
+    g_free(text);
 }
 
 // ───────────────────────────────────────────────
@@ -870,7 +3301,7 @@ void Editor::goto_line(int line) {
 // ───────────────────────────────────────────────
 
 void Editor::update_language_for_filename(const std::string& filename) {
-    if (!lang_manager_) return;
+    trace::Span span("Editor::update_language_for_filename");
 
     std::string ext;
     auto dot = filename.find_last_of('.');
@@ -898,63 +3329,332 @@ void Editor::update_language_for_filename(const std::string& filename) {
         return;
     }
 
+    // the manager indexes its language directories on first use, so that
+    // waits for the first file that actually has a language
+    if (!lang_manager_) lang_manager_ = gtk_source_language_manager_get_default();
     GtkSourceLanguage* lang =
         gtk_source_language_manager_get_language(lang_manager_, lang_id.c_str());
 
     if (lang) {
         gtk_source_buffer_set_language(srcb, lang);
-        gtk_source_buffer_set_highlight_syntax(srcb, TRUE);
+        gtk_source_buffer_set_highlight_syntax(srcb, !long_line_mode_);
     } else {
         gtk_source_buffer_set_language(srcb, nullptr);
         gtk_source_buffer_set_highlight_syntax(srcb, FALSE);
     }
 }
 
+// Long lines show only a slice each (see LongLineGuard), wrapped so it
+// does not run off screen, and search highlighting stays around the
+// viewport however small the file is.
+void Editor::set_long_line_mode(bool on) {
+    long_line_mode_ = on;
+    // GtkSourceView can only switch this per buffer, not per line; bracket
+    // matching stays on, it is bounded either way
+    GtkSourceBuffer* srcb = GTK_SOURCE_BUFFER(buffer_);
+    gtk_source_buffer_set_highlight_syntax(srcb, !on && gtk_source_buffer_get_language(srcb));
+    gtk_text_view_set_wrap_mode(GTK_TEXT_VIEW(text_view_), on ? GTK_WRAP_CHAR : GTK_WRAP_NONE);
+    line_guard_->set_limit(on ? long_line_kb_ * 1024 : 0);
+    update_highlight_mode();
+    update_status_full();
+}
+
 // ───────────────────────────────────────────────
 //  Status / title
 // ───────────────────────────────────────────────
 
+// Paste, Replace All and held keys change the buffer and cursor many times
+// per frame; the scheduler folds all of that into one refresh.
 void Editor::update_title() {
+    ui_.mark(kUiTitle);
+}
+
+void Editor::update_cursor_status() {
+    ui_.mark(kUiStatus);
+}
+
+void Editor::update_status_full() {
+    ui_.mark(kUiStatus);
+}
+
+void Editor::mark_modified(bool is_modified) {
+    if (!is_modified && ruler_) ruler_->clear_modified();
+    if (modified_ == is_modified) {
+        ui_.mark(kUiStatus);
+        return;
+    }
+    modified_ = is_modified;
+    ui_.mark(kUiTitle | kUiStatus);
+}
+
+void Editor::flush_ui(unsigned dirty) {
+    if (dirty & kUiTitle) render_title();
+    if (dirty & kUiStatus) render_status();
+}
+
+void Editor::render_title() {
     std::string title;
     if (current_file_.empty()) title = "Untitled — COLOSSUS Editor";
     else title = basename_of(current_file_) + " — COLOSSUS Editor";
 
     if (modified_) title = "*" + title;
-    gtk_window_set_title(GTK_WINDOW(window_), title.c_str());
+    UiScheduler::set_title(window_, &title_text_, title);
+    if (shown_doc_) update_tab_label(shown_doc_);
 }
 
-void Editor::update_cursor_status() {
+void Editor::render_status() {
     GtkTextIter iter;
     gtk_text_buffer_get_iter_at_mark(buffer_, &iter, gtk_text_buffer_get_insert(buffer_));
     int line = gtk_text_iter_get_line(&iter) + 1;
-    int col  = gtk_text_iter_get_line_offset(&iter) + 1;
+    column_cache_->set_tab_width((int)gtk_source_view_get_tab_width(GTK_SOURCE_VIEW(text_view_)));
+    int col  = column_cache_->position(&iter).column + 1;
 
-    std::stringstream ss;
-    ss << "Ln " << line << ", Col " << col;
-    if (!current_file_.empty()) ss << "  —  " << current_file_;
-    if (modified_) ss << "  (modified)";
-    gtk_label_set_text(GTK_LABEL(status_bar_), ss.str().c_str());
+    std::string text = "Ln " + std::to_string(line) + ", Col " + std::to_string(col);
+    if (!current_file_.empty()) text += "  —  " + current_file_;
+    if (modified_) text += "  (modified)";
+    if (long_line_mode_) text += "  (long lines shown around the cursor, no highlighting)";
+
+    text += "  |  " + std::to_string((int)gtk_text_buffer_get_line_count(buffer_)) + " lines, "
+          + std::to_string(word_count_) + " words, "
+          + std::to_string((int)gtk_text_buffer_get_char_count(buffer_)) + " chars";
+
+    GtkTextIter s, e;
+    if (gtk_text_buffer_get_selection_bounds(buffer_, &s, &e)) {
+        const int sel_lines = gtk_text_iter_get_line(&e) - gtk_text_iter_get_line(&s) + 1;
+        text += "  |  Sel " + std::to_string(gtk_text_iter_get_offset(&e) - gtk_text_iter_get_offset(&s)) + " chars";
+        if (sel_lines > 1) text += ", " + std::to_string(sel_lines) + " lines";
+    }
+    UiScheduler::set_label(status_bar_, &status_text_, text);
 }
 
-void Editor::update_status_full() {
-    update_cursor_status();
+// ───────────────────────────────────────────────
+//  Document statistics
+// ───────────────────────────────────────────────
+//
+// Lines and characters are kept by GtkTextBuffer. Words are a running total
+// changed by each edit. Only the edited text and the character on either
+// side of it are looked at: those two neighbours decide whether the edited
+// text joins the words around it, whatever the length of the line.
+
+static bool is_word_char(gunichar c) {
+    return c != 0 && !(c == ' ' || (c >= '\t' && c <= '\r'));
 }
 
-void Editor::mark_modified(bool is_modified) {
-    modified_ = is_modified;
-    update_title();
+// Words text adds between neighbours left and right (word characters or
+// not): its own words, less one for each end that merges into a neighbour.
+// Empty text adds nothing, but its neighbours count as one word when both
+// are word characters, so it takes that back.
+static gint64 joined_words(const char* text, size_t len, bool left, bool right) {
+    if (len == 0) return left && right ? -1 : 0;
+    gint64 n = count_words(text, len);
+    if (left && is_word_char((unsigned char)text[0])) --n;
+    if (right && is_word_char((unsigned char)text[len - 1])) --n;
+    return n;
+}
+
+// Whether the characters just before start and at end are word characters.
+static void edit_neighbours(const GtkTextIter* start, const GtkTextIter* end, bool* left, bool* right) {
+    GtkTextIter prev = *start;
+    *left = gtk_text_iter_backward_char(&prev) && is_word_char(gtk_text_iter_get_char(&prev));
+    *right = is_word_char(gtk_text_iter_get_char(end));
+}
+
+// Before the insertion, while at still has its neighbours.
+void Editor::stats_before_insert(const GtkTextIter* at, const char* text, int len) {
+    const size_t bytes = len < 0 ? std::strlen(text) : (size_t)len;
+    bool left, right;
+    edit_neighbours(at, at, &left, &right);
+    word_count_ += joined_words(text, bytes, left, right) - joined_words("", 0, left, right);
+    // before the buffer emits "changed", which checks the highlight mode
+    text_bytes_ += (gint64)bytes;
+    update_status_full();
+}
+
+void Editor::stats_before_delete(const GtkTextIter* start, const GtkTextIter* end) {
+    GtkTextIter a, b;
+    gtk_text_buffer_get_bounds(buffer_, &a, &b);
+    // clearing the buffer (set_text, reload) needs no count
+    if (gtk_text_iter_equal(start, &a) && gtk_text_iter_equal(end, &b)) {
+        word_count_ = 0;
+        text_bytes_ = 0;
+    } else {
+        gchar* text = gtk_text_buffer_get_slice(buffer_, start, end, TRUE);
+        const size_t bytes = std::strlen(text);
+        bool left, right;
+        edit_neighbours(start, end, &left, &right);
+        word_count_ += joined_words("", 0, left, right) - joined_words(text, bytes, left, right);
+        g_free(text);
+        text_bytes_ -= (gint64)bytes;
+    }
     update_status_full();
 }
 
+// ───────────────────────────────────────────────
+//  Memory usage
+// ───────────────────────────────────────────────
+
+static const gint kResponseTrim = 1;
+static const gint kResponseRefresh = 2;
+
+// Rough GtkTextBuffer bookkeeping on top of the text itself: B-tree line,
+// node and segment headers per line, and a toggle segment at each end of
+// every tagged range. Good to within a factor of two, which is the point.
+static const size_t kBufferBytesPerLine = 96;
+static const size_t kBufferBytesPerTagRange = 2 * 64;
+
+// Ranges of tag in the buffer; walks the toggles, never the text.
+static size_t count_tag_ranges(GtkTextBuffer* buffer, GtkTextTag* tag) {
+    if (!tag) return 0;
+    GtkTextIter it;
+    gtk_text_buffer_get_start_iter(buffer, &it);
+    size_t toggles = gtk_text_iter_toggles_tag(&it, tag) ? 1 : 0;
+    while (gtk_text_iter_forward_to_tag_toggle(&it, tag)) ++toggles;
+    return (toggles + 1) / 2;
+}
+
+void Editor::show_memory_dialog() {
+    if (memory_dialog_) {
+        update_memory_report();
+        gtk_window_present(GTK_WINDOW(memory_dialog_));
+        return;
+    }
+
+    GtkWidget* dialog = gtk_dialog_new_with_buttons(
+        "Memory Usage",
+        GTK_WINDOW(window_),
+        GTK_DIALOG_DESTROY_WITH_PARENT,
+        "_Trim Memory", kResponseTrim,
+        "_Refresh", kResponseRefresh,
+        "_Close", GTK_RESPONSE_CLOSE,
+        nullptr);
+    gtk_dialog_set_default_response(GTK_DIALOG(dialog), kResponseRefresh);
+    memory_dialog_ = dialog;
+
+    GtkWidget* content = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
+    GtkWidget* report = gtk_label_new("");
+    gtk_label_set_selectable(GTK_LABEL(report), TRUE);
+    gtk_label_set_xalign(GTK_LABEL(report), 0.0f);
+    gtk_label_set_yalign(GTK_LABEL(report), 0.0f);
+    gtk_widget_set_margin_start(report, 12);
+    gtk_widget_set_margin_end(report, 12);
+    gtk_widget_set_margin_top(report, 12);
+    gtk_widget_set_margin_bottom(report, 12);
+    gtk_style_context_add_class(gtk_widget_get_style_context(report), "monospace");
+    gtk_box_pack_start(GTK_BOX(content), report, TRUE, TRUE, 0);
+    g_object_set_data(G_OBJECT(dialog), "report", report);
+
+    g_signal_connect(dialog, "response", G_CALLBACK(Editor::s_on_memory_dialog_response), this);
+    update_memory_report();
+    gtk_widget_show_all(dialog);
+}
+
+void Editor::update_memory_report() {
+    if (!memory_dialog_) return;
+    trace::Span span("Editor::update_memory_report");
+
+    // one pass over the line index; the text is never copied
+    size_t text_bytes = 0;
+    GtkTextIter it;
+    gtk_text_buffer_get_start_iter(buffer_, &it);
+    do {
+        text_bytes += (size_t)gtk_text_iter_get_bytes_in_line(&it);
+    } while (gtk_text_iter_forward_line(&it));
+    const size_t lines = (size_t)gtk_text_buffer_get_line_count(buffer_);
+
+    size_t tagged = count_tag_ranges(buffer_, match_tag_) + count_tag_ranges(buffer_, scope_tag_);
+    size_t pinned = 0;
+    for (GtkTextTag* t : pin_tags_) pinned += count_tag_ranges(buffer_, t);
+    tagged += pinned;
+    const gint occurrences = search_context_ ? gtk_source_search_context_get_occurrences_count(search_context_) : 0;
+    const gint table_size = gtk_text_tag_table_get_size(gtk_text_buffer_get_tag_table(buffer_));
+
+    GtkSourceBuffer* srcb = GTK_SOURCE_BUFFER(buffer_);
+    const gint undo_levels = gtk_source_buffer_get_max_undo_levels(srcb);
+
+    auto row = [](std::ostringstream& ss, const char* name, size_t bytes, const std::string& note) {
+        char buf[128];
+        std::snprintf(buf, sizeof buf, "  %-20s %12s", name, format_bytes(bytes).c_str());
+        ss << buf;
+        if (!note.empty()) ss << "   " << note;
+        ss << "\n";
+    };
+
+    std::ostringstream ss;
+    ss << "Document  " << (current_file_.empty() ? "(untitled)" : current_file_) << "\n";
+    row(ss, "text", text_bytes, std::to_string(lines) + " lines");
+    row(ss, "buffer overhead", lines * kBufferBytesPerLine + tagged * kBufferBytesPerTagRange, "estimate");
+    row(ss, "undo history", undo_->memory_bytes(),
+        std::string("undo ") + (gtk_source_buffer_can_undo(srcb) ? "yes" : "no") +
+        ", redo " + (gtk_source_buffer_can_redo(srcb) ? "yes" : "no") +
+        ", limit " + (undo_levels < 0 ? std::string("none") : std::to_string(undo_levels)));
+    ss << "  tags                 " << table_size << " in table, " << tagged << " ranges tagged ("
+       << pinned << " pinned)";
+    if (occurrences >= 0) ss << ", " << occurrences << " search matches";
+    ss << "\n\nCaches\n";
+    row(ss, "search results", results_.memory_bytes(), std::to_string(results_.size()) + " hits");
+    row(ss, "replace preview", replace_plan_.memory_bytes(), "");
+    row(ss, "minimap tiles", minimap_ ? minimap_->memory_bytes() : 0, "");
+    row(ss, "overview ruler", ruler_ ? ruler_->memory_bytes() : 0, "");
+    row(ss, "bracket index", bracket_matcher_ ? bracket_matcher_->memory_bytes() : 0, "");
+    row(ss, "column checkpoints", column_cache_ ? column_cache_->memory_bytes() : 0, "");
+    row(ss, "pinned terms", pin_matcher_.memory_bytes(), std::to_string(pin_matcher_.term_count()) + " terms");
+    row(ss, "project index", project_index_.loaded() ? project_index_.mapped_bytes() : 0, "mapped");
+
+    size_t parked_bytes = 0;
+    int plain = 0, compressed = 0, on_disk = 0;
+    for (const Document* d : docs_) {
+        if (d == shown_doc_) continue;
+        parked_bytes += d->memory_bytes();
+        switch (d->storage()) {
+        case Document::Storage::Plain:      ++plain; break;
+        case Document::Storage::Compressed: ++compressed; break;
+        case Document::Storage::OnDisk:     ++on_disk; break;
+        case Document::Storage::Shown:      break;
+        }
+    }
+    ss << "\nBackground documents\n";
+    row(ss, "parked text", parked_bytes,
+        std::to_string(plain) + " plain, " + std::to_string(compressed) + " compressed, " +
+        std::to_string(on_disk) + " on disk; budget " + std::to_string(background_mb_) + " MB");
+
+    const ProcessMemory pm = process_memory();
+    ss << "\nProcess\n";
+    row(ss, "resident", pm.rss, "");
+    if (pm.heap_known) {
+        row(ss, "heap in use", pm.heap_in_use, "");
+        row(ss, "heap free", pm.heap_free, "held by malloc");
+        row(ss, "heap mmap", pm.heap_mmap, "");
+    }
+
+    GtkWidget* report = GTK_WIDGET(g_object_get_data(G_OBJECT(memory_dialog_), "report"));
+    if (report) gtk_label_set_text(GTK_LABEL(report), ss.str().c_str());
+}
+
+// Drops what is rebuilt on demand and hands freed heap back to the system.
+void Editor::trim_memory() {
+    trace::Span span("Editor::trim_memory");
+    if (minimap_) minimap_->trim();
+    if (column_cache_) column_cache_->clear();
+    if (!replace_preview_ && !replace_preview_cancel_) replace_plan_.clear();
+    if (!results_tracking()) drop_results();
+    enforce_background_budget(0);
+    trim_heap();
+}
+
 // ───────────────────────────────────────────────
 //  Recent files
 // ───────────────────────────────────────────────
 
 void Editor::add_recent_item(const std::string& path) {
-    if (!recent_mgr_ || path.empty()) return;
+    if (path.empty()) return;
+    recent_files().add(path);
 
-    std::string uri = "file://" + path;
-    gtk_recent_manager_add_item(recent_mgr_, uri.c_str());
+    // optional copy in the desktop-wide list, for file choosers elsewhere
+    if (mirror_recent_) {
+        gchar* uri = g_filename_to_uri(path.c_str(), nullptr, nullptr);
+        if (uri) gtk_recent_manager_add_item(gtk_recent_manager_get_default(), uri);
+        g_free(uri);
+    }
 }
 
 // ───────────────────────────────────────────────
@@ -985,18 +3685,8 @@ void Editor::zoom_step(int delta) {
 //  Config / session
 // ───────────────────────────────────────────────
 
-void Editor::load_config() {
-    ensure_dir_exists(config_dir());
-
-    GKeyFile* kf = g_key_file_new();
-    GError* err = nullptr;
-
-    if (!g_key_file_load_from_file(kf, config_path().c_str(), G_KEY_FILE_NONE, &err)) {
-        if (err) g_error_free(err);
-        g_key_file_free(kf);
-        return;
-    }
-
+void Editor::load_config(GKeyFile* kf) {
+    trace::Span span("Editor::load_config");
     if (g_key_file_has_key(kf, "prefs", "trim_ws_on_save", nullptr))
         trim_ws_on_save_ = g_key_file_get_boolean(kf, "prefs", "trim_ws_on_save", nullptr);
     if (g_key_file_has_key(kf, "prefs", "ensure_newline_eof", nullptr))
@@ -1005,18 +3695,66 @@ void Editor::load_config() {
         tab_width_ = (int)g_key_file_get_integer(kf, "prefs", "tab_width", nullptr);
     if (g_key_file_has_key(kf, "prefs", "font_pt", nullptr))
         font_pt_ = (int)g_key_file_get_integer(kf, "prefs", "font_pt", nullptr);
-
-    g_key_file_free(kf);
+    if (g_key_file_has_key(kf, "prefs", "project_index", nullptr))
+        project_index_enabled_ = g_key_file_get_boolean(kf, "prefs", "project_index", nullptr);
+    if (g_key_file_has_key(kf, "prefs", "index_memory_mb", nullptr))
+        index_memory_mb_ = (int)g_key_file_get_integer(kf, "prefs", "index_memory_mb", nullptr);
+    if (g_key_file_has_key(kf, "prefs", "viewport_highlight_mb", nullptr))
+        viewport_highlight_mb_ = (int)g_key_file_get_integer(kf, "prefs", "viewport_highlight_mb", nullptr);
+    if (g_key_file_has_key(kf, "prefs", "long_line_kb", nullptr))
+        long_line_kb_ = (int)g_key_file_get_integer(kf, "prefs", "long_line_kb", nullptr);
+    if (g_key_file_has_key(kf, "prefs", "bracket_scan_kb", nullptr))
+        bracket_scan_kb_ = (int)g_key_file_get_integer(kf, "prefs", "bracket_scan_kb", nullptr);
+    if (g_key_file_has_key(kf, "prefs", "show_minimap", nullptr))
+        show_minimap_ = g_key_file_get_boolean(kf, "prefs", "show_minimap", nullptr);
+    if (g_key_file_has_key(kf, "prefs", "show_ruler", nullptr))
+        show_ruler_ = g_key_file_get_boolean(kf, "prefs", "show_ruler", nullptr);
+    if (g_key_file_has_key(kf, "prefs", "show_latency_hud", nullptr))
+        show_latency_hud_ = g_key_file_get_boolean(kf, "prefs", "show_latency_hud", nullptr);
+    if (g_key_file_has_key(kf, "prefs", "system_recent", nullptr))
+        mirror_recent_ = g_key_file_get_boolean(kf, "prefs", "system_recent", nullptr);
+    if (g_key_file_has_key(kf, "prefs", "background_mb", nullptr))
+        background_mb_ = (int)g_key_file_get_integer(kf, "prefs", "background_mb", nullptr);
+
+    if (g_key_file_has_key(kf, "search", "last_query", nullptr)) {
+        gchar* q = g_key_file_get_string(kf, "search", "last_query", nullptr);
+        if (q) last_query_ = q;
+        g_free(q);
+    }
+    if (g_key_file_has_key(kf, "search", "case_sensitive", nullptr))
+        search_case_sensitive_ = g_key_file_get_boolean(kf, "search", "case_sensitive", nullptr);
+    if (g_key_file_has_key(kf, "search", "regex", nullptr))
+        search_regex_ = g_key_file_get_boolean(kf, "search", "regex", nullptr);
 }
 
 void Editor::save_config() {
     ensure_dir_exists(config_dir());
 
     GKeyFile* kf = g_key_file_new();
+    GError* err = nullptr;
+
+    // load existing first to preserve session keys
+    g_key_file_load_from_file(kf, config_path().c_str(), G_KEY_FILE_NONE, &err);
+    if (err) { g_error_free(err); err = nullptr; }
+
     g_key_file_set_boolean(kf, "prefs", "trim_ws_on_save", trim_ws_on_save_);
     g_key_file_set_boolean(kf, "prefs", "ensure_newline_eof", ensure_newline_eof_);
     g_key_file_set_integer(kf, "prefs", "tab_width", tab_width_);
     g_key_file_set_integer(kf, "prefs", "font_pt", font_pt_);
+    g_key_file_set_boolean(kf, "prefs", "project_index", project_index_enabled_);
+    g_key_file_set_integer(kf, "prefs", "index_memory_mb", index_memory_mb_);
+    g_key_file_set_integer(kf, "prefs", "viewport_highlight_mb", viewport_highlight_mb_);
+    g_key_file_set_integer(kf, "prefs", "long_line_kb", long_line_kb_);
+    g_key_file_set_integer(kf, "prefs", "bracket_scan_kb", bracket_scan_kb_);
+    g_key_file_set_boolean(kf, "prefs", "show_minimap", show_minimap_);
+    g_key_file_set_boolean(kf, "prefs", "show_ruler", show_ruler_);
+    g_key_file_set_boolean(kf, "prefs", "show_latency_hud", show_latency_hud_);
+    g_key_file_set_boolean(kf, "prefs", "system_recent", mirror_recent_);
+    g_key_file_set_integer(kf, "prefs", "background_mb", background_mb_);
+
+    g_key_file_set_string(kf, "search", "last_query", last_query_.c_str());
+    g_key_file_set_boolean(kf, "search", "case_sensitive", search_case_sensitive_);
+    g_key_file_set_boolean(kf, "search", "regex", search_regex_);
 
     gsize len = 0;
     gchar* data = g_key_file_to_data(kf, &len, nullptr);
@@ -1027,25 +3765,15 @@ void Editor::save_config() {
     g_key_file_free(kf);
 }
 
-void Editor::load_session() {
-    // simple: keep last_file
-    ensure_dir_exists(config_dir());
-
-    GKeyFile* kf = g_key_file_new();
-    GError* err = nullptr;
-    if (!g_key_file_load_from_file(kf, config_path().c_str(), G_KEY_FILE_NONE, &err)) {
-        if (err) g_error_free(err);
-        g_key_file_free(kf);
-        return;
-    }
-
-    if (g_key_file_has_key(kf, "session", "last_file", nullptr)) {
-        gchar* lf = g_key_file_get_string(kf, "session", "last_file", nullptr);
-        if (lf && *lf) current_file_ = lf;
-        if (lf) g_free(lf);
+// The documents themselves are reopened by on_command_line.
+void Editor::load_session(GKeyFile* kf) {
+    trace::Span span("Editor::load_session");
+    if (g_key_file_has_key(kf, "session", "pinned_terms", nullptr)) {
+        gsize n = 0;
+        gchar** terms = g_key_file_get_string_list(kf, "session", "pinned_terms", &n, nullptr);
+        for (gsize i = 0; terms && i < n; ++i) pinned_terms_.push_back(terms[i]);
+        g_strfreev(terms);
     }
-
-    g_key_file_free(kf);
 }
 
 void Editor::save_session() {
@@ -1059,7 +3787,25 @@ void Editor::save_session() {
     g_key_file_load_from_file(kf, config_path().c_str(), G_KEY_FILE_NONE, &err);
     if (err) { g_error_free(err); err = nullptr; }
 
-    g_key_file_set_string(kf, "session", "last_file", current_file_.c_str());
+    // every window's documents in tab order; cursor and scroll are in the
+    // file metadata
+    std::vector<const gchar*> files;
+    gint active = 0;
+    for (Editor* ed : g_editors) {
+        for (Document* d : ed->docs_) {
+            const std::string& path = d == ed->shown_doc_ ? ed->current_file_ : d->path;
+            if (path.empty()) continue;
+            if (ed == g_active_editor && d == ed->shown_doc_) active = (gint)files.size();
+            files.push_back(path.c_str());
+        }
+    }
+    g_key_file_set_string_list(kf, "session", "files", files.data(), files.size());
+    g_key_file_set_integer(kf, "session", "active", active);
+    g_key_file_remove_key(kf, "session", "last_file", nullptr);
+
+    std::vector<const gchar*> terms;
+    for (const std::string& t : pinned_terms_) terms.push_back(t.c_str());
+    g_key_file_set_string_list(kf, "session", "pinned_terms", terms.data(), terms.size());
 
     gsize len = 0;
     gchar* data = g_key_file_to_data(kf, &len, nullptr);
@@ -1067,72 +3813,253 @@ void Editor::save_session() {
         g_file_set_contents(config_path().c_str(), data, (gssize)len, nullptr);
         g_free(data);
     }
-    g_key_file_free(kf);
+    g_key_file_free(kf);
+}
+
+// ───────────────────────────────────────────────
+//  Static callbacks
+// ───────────────────────────────────────────────
+
+// Activation without files: the window used last, or a first one.
+void Editor::on_activate(GtkApplication* app, gpointer) {
+    Editor* ed = g_active_editor ? g_active_editor : new Editor(app);
+    gtk_window_present(GTK_WINDOW(ed->window_));
+}
+
+// Every invocation lands here, in the primary instance: the local one, or
+// a later launch whose arguments came over D-Bus.
+// Each invocation gets a window with its files as tabs; a --wait client
+// keeps its command line object referenced by that window and returns when
+// it closes. A launch without files while no window is open restores the
+// last session: only the shown document is read, the others when chosen.
+int Editor::on_command_line(GApplication* app, GApplicationCommandLine* cmd, gpointer) {
+    GVariantDict* opts = g_application_command_line_get_options_dict(cmd);
+    const bool wait = g_variant_dict_contains(opts, "wait");
+
+    struct Target {
+        std::string path;
+        int line;
+        int column;
+    };
+    std::vector<Target> targets;
+    int line = 0, column = 0;
+
+    gint argc = 0;
+    gchar** argv = g_application_command_line_get_arguments(cmd, &argc);
+    for (gint i = 1; i < argc; ++i) {
+        if (argv[i][0] == '+' && parse_cli_position(argv[i] + 1, &line, &column)) continue;
+        // relative to the client's working directory, not ours
+        GFile* f = g_application_command_line_create_file_for_arg(cmd, argv[i]);
+        char* path = g_file_get_path(f);
+        g_object_unref(f);
+        if (path) targets.push_back(Target{ path, line, column });
+        g_free(path);
+        line = column = 0;
+    }
+    g_strfreev(argv);
+
+    // a resident server opens no window of its own
+    if (g_variant_dict_contains(opts, "server")) {
+        g_application_hold(app);
+        if (targets.empty()) return 0;
+    }
+    const bool restore = targets.empty() && g_editors.empty();
+    Editor* ed = new Editor(GTK_APPLICATION(app));
+    if (wait) ed->waiters_.push_back(G_APPLICATION_COMMAND_LINE(g_object_ref(cmd)));
+
+    if (restore) {
+        size_t active = 0;
+        const std::vector<std::string> files = session_files(&active);
+        if (!files.empty()) {
+            Document* blank = ed->shown_doc_;
+            std::vector<Document*> restored;
+            for (const std::string& path : files) {
+                restored.push_back(ed->add_document(path));
+                restored.back()->drop();
+            }
+            ed->show_document(restored[active]);
+            ed->close_document(blank);
+            startup_profile::mark("open file");
+        }
+    }
+    for (const Target& t : targets) {
+        ed->open_in_tab(t.path);
+        if (t.line > 0) ed->goto_line(t.line, t.column);
+        startup_profile::mark("open file");
+    }
+    gtk_window_present(GTK_WINDOW(ed->window_));
+    return 0;
+}
+
+// Files sent through the Open action, like a command line: a window of
+// their own.
+void Editor::on_open(GtkApplication* app, GFile** files, gint n_files, const gchar*, gpointer) {
+    Editor* ed = new Editor(app);
+    for (gint i = 0; i < n_files; ++i) {
+        char* path = g_file_get_path(files[i]);
+        if (path) {
+            ed->open_in_tab(path);
+            g_free(path);
+        }
+    }
+    gtk_window_present(GTK_WINDOW(ed->window_));
+}
+
+void Editor::s_on_new_activate(GtkWidget*, gpointer ud) { static_cast<Editor*>(ud)->new_file(); }
+void Editor::s_on_open_activate(GtkWidget*, gpointer ud) { static_cast<Editor*>(ud)->open_file(); }
+void Editor::s_on_save_activate(GtkWidget*, gpointer ud) { static_cast<Editor*>(ud)->save_file(); }
+void Editor::s_on_save_as_activate(GtkWidget*, gpointer ud) { static_cast<Editor*>(ud)->save_file_as(); }
+
+void Editor::s_on_reload_activate(GtkWidget*, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    if (self->current_file_.empty()) return;
+    if (self->modified_ && !self->maybe_confirm_discard("reload the file")) return;
+    self->open_file_from_path(self->current_file_);
+}
+
+void Editor::s_on_open_folder_activate(GtkWidget*, gpointer ud) {
+    static_cast<Editor*>(ud)->open_containing_folder();
+}
+
+// The close button: unsaved documents are asked about first, unless Quit
+// already did. TRUE keeps the window open.
+gboolean Editor::s_on_window_delete(GtkWidget*, GdkEvent*, gpointer ud) {
+    if (g_quitting) return FALSE;
+    return !static_cast<Editor*>(ud)->confirm_discard_all("close the window");
+}
+
+void Editor::s_on_window_destroy(GtkWidget*, gpointer ud) {
+    // still inside the window's destruction: every widget is alive
+    delete static_cast<Editor*>(ud);
+}
+
+gboolean Editor::s_on_first_draw(GtkWidget* w, cairo_t*, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    g_signal_handlers_disconnect_by_func(w, (gpointer)Editor::s_on_first_draw, self);
+    startup_profile::mark("first paint");
+    // idle priority: runs once this frame is out
+    if (!self->ui_complete_)
+        self->finish_ui_id_ = g_idle_add(Editor::s_on_finish_ui, self);
+    return FALSE;
+}
+
+gboolean Editor::s_on_finish_ui(gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    self->finish_ui_id_ = 0;
+    self->finish_ui();
+    return G_SOURCE_REMOVE;
+}
+
+void Editor::s_on_file_menu_show(GtkWidget*, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    RecentFiles& recent = recent_files();
+    const std::vector<std::string>& paths = recent.paths();
+    if (self->recent_serial_ == recent.serial()) return;
+    self->recent_serial_ = recent.serial();
+
+    GtkWidget* menu = gtk_menu_new();
+    for (size_t i = 0; i < paths.size() && i < kRecentMenuItems; ++i) {
+        GtkWidget* item = gtk_menu_item_new_with_label(recent_label(paths[i]).c_str());
+        gtk_widget_set_tooltip_text(item, paths[i].c_str());
+        g_object_set_data_full(G_OBJECT(item), "path", g_strdup(paths[i].c_str()), g_free);
+        g_signal_connect(item, "activate", G_CALLBACK(Editor::s_on_recent_activated), self);
+        gtk_menu_shell_append(GTK_MENU_SHELL(menu), item);
+    }
+    if (paths.empty()) {
+        GtkWidget* item = gtk_menu_item_new_with_label("No recent files");
+        gtk_widget_set_sensitive(item, FALSE);
+        gtk_menu_shell_append(GTK_MENU_SHELL(menu), item);
+    }
+    gtk_widget_show_all(menu);
+    // replaces (and destroys) the previous list
+    gtk_menu_item_set_submenu(GTK_MENU_ITEM(self->recent_item_), menu);
 }
 
-// ───────────────────────────────────────────────
-//  Static callbacks
-// ───────────────────────────────────────────────
+// Closes every window, and the session keeps every document.
+void Editor::s_on_quit_activate(GtkWidget*, gpointer ud) {
+    for (Editor* ed : g_editors)
+        if (!ed->confirm_discard_all("quit")) return;
 
-void Editor::on_activate(GtkApplication* app, gpointer) {
-    if (!g_editor_instance) g_editor_instance = new Editor(app);
+    static_cast<Editor*>(ud)->save_session();
+    g_quitting = true;
+    // the windows go from an idle, so the list holds still meanwhile
+    for (Editor* ed : g_editors) gtk_window_close(GTK_WINDOW(ed->window_));
 }
 
-void Editor::on_open(GtkApplication* app, GFile** files, gint n_files, const gchar*, gpointer) {
-    if (!g_editor_instance) g_editor_instance = new Editor(app);
-    g_editor_instance->opened_via_cli_ = true;
+void Editor::s_on_close_tab_activate(GtkWidget*, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    if (self->shown_doc_) self->close_document(self->shown_doc_);
+}
 
-    for (gint i = 0; i < n_files; ++i) {
-        char* path = g_file_get_path(files[i]);
-        if (path) {
-            g_editor_instance->open_file_from_path(path);
-            g_free(path);
-        }
-    }
-    g_editor_instance->opened_via_cli_ = false;
+void Editor::s_on_next_tab_activate(GtkWidget*, gpointer ud) {
+    gtk_notebook_next_page(GTK_NOTEBOOK(static_cast<Editor*>(ud)->tabs_));
 }
 
-void Editor::s_on_new_activate(GtkWidget*, gpointer ud) { static_cast<Editor*>(ud)->new_file(); }
-void Editor::s_on_open_activate(GtkWidget*, gpointer ud) { static_cast<Editor*>(ud)->open_file(); }
-void Editor::s_on_save_activate(GtkWidget*, gpointer ud) { static_cast<Editor*>(ud)->save_file(); }
-void Editor::s_on_save_as_activate(GtkWidget*, gpointer ud) { static_cast<Editor*>(ud)->save_file_as(); }
+void Editor::s_on_prev_tab_activate(GtkWidget*, gpointer ud) {
+    gtk_notebook_prev_page(GTK_NOTEBOOK(static_cast<Editor*>(ud)->tabs_));
+}
 
-void Editor::s_on_reload_activate(GtkWidget*, gpointer ud) {
-    Editor* self = static_cast<Editor*>(ud);
-    if (self->current_file_.empty()) return;
-    if (self->modified_ && !self->maybe_confirm_discard("reload the file")) return;
-    self->open_file_from_path(self->current_file_);
+void Editor::s_on_tab_close_clicked(GtkButton* btn, gpointer ud) {
+    Document* d = static_cast<Document*>(g_object_get_data(G_OBJECT(btn), "document"));
+    static_cast<Editor*>(ud)->close_document(d);
 }
 
-void Editor::s_on_open_folder_activate(GtkWidget*, gpointer ud) {
-    static_cast<Editor*>(ud)->open_containing_folder();
+void Editor::s_on_switch_page(GtkNotebook*, GtkWidget* page, guint, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    if (self->switching_) return;
+    self->show_document(static_cast<Document*>(g_object_get_data(G_OBJECT(page), "document")));
 }
 
-void Editor::s_on_quit_activate(GtkWidget*, gpointer ud) {
+gboolean Editor::s_on_window_focus_in(GtkWidget*, GdkEventFocus*, gpointer ud) {
     Editor* self = static_cast<Editor*>(ud);
-    if (!self->maybe_confirm_discard("quit")) return;
-    gtk_window_close(GTK_WINDOW(self->window_));
+    g_active_editor = self;
+    return FALSE;
 }
 
 void Editor::s_on_cut_activate(GtkWidget*, gpointer ud) { static_cast<Editor*>(ud)->cut(); }
+
 void Editor::s_on_copy_activate(GtkWidget*, gpointer ud) { static_cast<Editor*>(ud)->copy(); }
 void Editor::s_on_paste_activate(GtkWidget*, gpointer ud) { static_cast<Editor*>(ud)->paste(); }
 void Editor::s_on_select_all_activate(GtkWidget*, gpointer ud) { static_cast<Editor*>(ud)->select_all(); }
 
-void Editor::s_on_find_activate(GtkWidget*, gpointer ud) { static_cast<Editor*>(ud)->show_find_dialog(); }
+void Editor::s_on_find_activate(GtkWidget*, gpointer ud) { static_cast<Editor*>(ud)->show_search_bar(); }
 void Editor::s_on_replace_activate(GtkWidget*, gpointer ud) { static_cast<Editor*>(ud)->show_replace_dialog(); }
 void Editor::s_on_goto_line_activate(GtkWidget*, gpointer ud) { static_cast<Editor*>(ud)->show_goto_line_dialog(); }
 
 void Editor::s_on_buffer_changed(GtkTextBuffer*, gpointer ud) {
-    static_cast<Editor*>(ud)->mark_modified(true);
+    Editor* self = static_cast<Editor*>(ud);
+    self->edit_serial_++;
+    self->update_highlight_mode();
+    if (self->manual_highlight()) {
+        self->hl_dirty_ = true;
+        self->schedule_highlight();
+    }
+    if (self->bulk_edit_) return;
+    self->mark_modified(true);
+    if (self->replace_preview_ && !self->replace_plan_.empty()) self->update_replace_preview_status();
 }
 
 void Editor::s_on_cursor_notify(GObject*, GParamSpec*, gpointer ud) {
     static_cast<Editor*>(ud)->update_cursor_status();
 }
 
+// the cursor notify misses selections that only move the other end
+void Editor::s_on_mark_set(GtkTextBuffer* buffer, GtkTextIter*, GtkTextMark* mark, gpointer ud) {
+    if (mark == gtk_text_buffer_get_selection_bound(buffer)) static_cast<Editor*>(ud)->update_cursor_status();
+}
+
+void Editor::s_on_stats_before_insert(GtkTextBuffer*, GtkTextIter* at, gchar* text, gint len, gpointer ud) {
+    static_cast<Editor*>(ud)->stats_before_insert(at, text, len);
+}
+
+void Editor::s_on_stats_before_delete(GtkTextBuffer*, GtkTextIter* start, GtkTextIter* end, gpointer ud) {
+    static_cast<Editor*>(ud)->stats_before_delete(start, end);
+}
+
 gboolean Editor::s_on_key_press(GtkWidget*, GdkEventKey* e, gpointer ud) {
     Editor* self = static_cast<Editor*>(ud);
+    self->latency_.key_pressed(e);
+    self->finish_ui();
 
     const bool ctrl = (e->state & GDK_CONTROL_MASK) != 0;
     if (!ctrl) return FALSE;
@@ -1164,17 +4091,105 @@ gboolean Editor::s_on_key_press(GtkWidget*, GdkEventKey* e, gpointer ud) {
     return FALSE;
 }
 
-void Editor::s_on_find_dialog_response(GtkDialog* dlg, gint resp, gpointer ud) {
+void Editor::s_on_search_entry_changed(GtkEditable*, gpointer ud) {
+    static_cast<Editor*>(ud)->schedule_incremental_search();
+}
+
+void Editor::s_on_search_entry_activate(GtkEntry*, gpointer ud) {
     Editor* self = static_cast<Editor*>(ud);
+    // Enter before the debounce fired: apply the text right away
+    if (self->search_debounce_id_) {
+        g_source_remove(self->search_debounce_id_);
+        self->search_debounce_id_ = 0;
+        self->run_incremental_search();
+        return;
+    }
+    self->search_find_next(false);
+}
 
-    if (resp == GTK_RESPONSE_OK) {
-        self->update_search_from_dialog(GTK_WIDGET(dlg));
-        self->search_find_next(false);
-        return; // keep dialog open
+void Editor::s_on_search_next_match(GtkSearchEntry*, gpointer ud) { static_cast<Editor*>(ud)->search_find_next(false); }
+void Editor::s_on_search_previous_match(GtkSearchEntry*, gpointer ud) { static_cast<Editor*>(ud)->search_find_next(true); }
+void Editor::s_on_search_prev_clicked(GtkButton*, gpointer ud) { static_cast<Editor*>(ud)->search_find_next(true); }
+void Editor::s_on_search_next_clicked(GtkButton*, gpointer ud) { static_cast<Editor*>(ud)->search_find_next(false); }
+
+void Editor::s_on_search_option_toggled(GtkToggleButton*, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    self->search_case_sensitive_ = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(self->search_case_btn_));
+    self->search_regex_ = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(self->search_regex_btn_));
+    self->ensure_search_context();
+    self->apply_search_options();
+    self->schedule_incremental_search();
+}
+
+void Editor::s_on_search_scope_toggled(GtkToggleButton* btn, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    const bool on = gtk_toggle_button_get_active(btn);
+    if (!self->set_search_scope(on)) {
+        // nothing selected to scope to
+        g_signal_handlers_block_by_func(btn, (gpointer)Editor::s_on_search_scope_toggled, self);
+        gtk_toggle_button_set_active(btn, FALSE);
+        g_signal_handlers_unblock_by_func(btn, (gpointer)Editor::s_on_search_scope_toggled, self);
     }
+}
 
-    self->find_dialog_ = nullptr;
-    gtk_widget_destroy(GTK_WIDGET(dlg));
+gboolean Editor::s_on_highlight_timeout(gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    self->highlight_id_ = 0;
+    self->refresh_manual_highlight();
+    self->update_search_count();
+    return G_SOURCE_REMOVE;
+}
+
+void Editor::s_on_search_mode_notify(GObject*, GParamSpec*, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    if (!gtk_search_bar_get_search_mode(GTK_SEARCH_BAR(self->search_bar_)))
+        self->hide_search_bar();
+}
+
+void Editor::s_on_search_count_notify(GObject*, GParamSpec*, gpointer ud) {
+    static_cast<Editor*>(ud)->update_search_count();
+}
+
+gboolean Editor::s_on_search_debounce(gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    self->search_debounce_id_ = 0;
+    self->run_incremental_search();
+    return G_SOURCE_REMOVE;
+}
+
+void Editor::s_on_incremental_search_done(GObject* src, GAsyncResult* res, gpointer ud) {
+    GtkSourceSearchContext* ctx = GTK_SOURCE_SEARCH_CONTEXT(src);
+    GtkTextIter ms, me;
+    GError* err = nullptr;
+    gboolean found = gtk_source_search_context_forward_finish(ctx, res, &ms, &me, &err);
+    if (err) {
+        const bool cancelled = g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+        g_error_free(err);
+        if (cancelled) return;   // superseded by newer text, or editor gone
+    }
+
+    Editor* self = static_cast<Editor*>(ud);
+    if (!found && !self->search_wrapped_) {
+        // nothing below the anchor: wrap to the top once
+        self->search_wrapped_ = true;
+        GtkTextIter start;
+        gtk_text_buffer_get_start_iter(self->buffer_, &start);
+        gtk_source_search_context_forward_async(ctx, &start, self->search_cancel_,
+                                                Editor::s_on_incremental_search_done, self);
+        return;
+    }
+
+    GtkStyleContext* sc = gtk_widget_get_style_context(self->search_entry_);
+    if (!found) {
+        gtk_style_context_add_class(sc, "error");
+        self->update_search_count();
+        return;
+    }
+
+    gtk_style_context_remove_class(sc, "error");
+    gtk_text_buffer_select_range(self->buffer_, &ms, &me);
+    gtk_text_view_scroll_to_iter(GTK_TEXT_VIEW(self->text_view_), &ms, 0.2, FALSE, 0, 0);
+    self->update_search_count();
 }
 
 void Editor::s_on_replace_dialog_response(GtkDialog* dlg, gint resp, gpointer ud) {
@@ -1187,7 +4202,9 @@ void Editor::s_on_replace_dialog_response(GtkDialog* dlg, gint resp, gpointer ud
     const char* r = repl_entry ? gtk_entry_get_text(GTK_ENTRY(repl_entry)) : "";
 
     self->ensure_search_context();
-    gtk_source_search_settings_set_search_text(self->search_settings_, f ? f : "");
+    self->last_query_ = f ? f : "";
+    self->rebuild_search_matcher();
+    self->sync_search_context();
 
     if (resp == GTK_RESPONSE_ACCEPT) {
         // replace one (on selection if exists; else find next then replace)
@@ -1196,7 +4213,12 @@ void Editor::s_on_replace_dialog_response(GtkDialog* dlg, gint resp, gpointer ud
         return;
     }
     if (resp == GTK_RESPONSE_APPLY) {
-        self->search_replace_all(r ? r : "");
+        // review every change before it is made
+        const std::string query = f ? f : "";
+        const std::string repl = r ? r : "";
+        self->replace_dialog_ = nullptr;
+        gtk_widget_destroy(GTK_WIDGET(dlg));
+        self->start_replace_preview(query, repl);
         return;
     }
 
@@ -1204,6 +4226,163 @@ void Editor::s_on_replace_dialog_response(GtkDialog* dlg, gint resp, gpointer ud
     gtk_widget_destroy(GTK_WIDGET(dlg));
 }
 
+void Editor::s_on_results_activate(GtkWidget*, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    self->show_results_panel(!self->results_active());
+}
+
+void Editor::s_on_results_close_clicked(GtkButton*, gpointer ud) {
+    static_cast<Editor*>(ud)->show_results_panel(false);
+}
+
+void Editor::s_on_results_row_activated(GtkTreeView*, GtkTreePath* path, GtkTreeViewColumn*, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    size_t row = 0;
+    if (!HitListModel::row_at(path, &row) || row >= self->results_.size()) return;
+
+    const MatchIndex::Hit h = self->results_[row];
+    self->goto_line(h.line + 1);
+
+    // select the match itself when it is still where the scan saw it: the
+    // line is matched again, so a stale hit never lands inside a character
+    if (!self->results_matcher_) return;
+    GtkTextIter ms, me;
+    gtk_text_buffer_get_iter_at_line(self->buffer_, &ms, h.line);
+    if (h.index + h.length > gtk_text_iter_get_bytes_in_line(&ms)) return;
+    me = ms;
+    if (!gtk_text_iter_ends_line(&me)) gtk_text_iter_forward_to_line_end(&me);
+    gchar* text = gtk_text_buffer_get_slice(self->buffer_, &ms, &me, TRUE);
+    bool still = false;
+    self->results_matcher_->find_all(text, std::strlen(text), [&](size_t s, size_t e) {
+        still = (int)s == h.index && (int)(e - s) == h.length;
+        return (int)s < h.index;
+    });
+    g_free(text);
+    if (!still) return;
+
+    gtk_text_iter_set_line_index(&ms, h.index);
+    me = ms;
+    gtk_text_iter_set_line_index(&me, h.index + h.length);
+    gtk_text_buffer_select_range(self->buffer_, &ms, &me);
+}
+
+void Editor::s_on_results_scan_done(GObject*, GAsyncResult* res, gpointer ud) {
+    MatchScanJob* job = static_cast<MatchScanJob*>(g_task_get_task_data(G_TASK(res)));
+    if (g_cancellable_is_cancelled(job->cancel)) return;   // superseded or editor gone
+
+    Editor* self = static_cast<Editor*>(ud);
+    self->drain_results();
+    self->results_job_ = nullptr;
+    if (self->results_drain_id_) {
+        g_source_remove(self->results_drain_id_);
+        self->results_drain_id_ = 0;
+    }
+    if (self->results_cancel_) {
+        g_object_unref(self->results_cancel_);
+        self->results_cancel_ = nullptr;
+    }
+    self->update_results_label();
+}
+
+gboolean Editor::s_on_results_drain(gpointer ud) {
+    static_cast<Editor*>(ud)->drain_results();
+    return G_SOURCE_CONTINUE;
+}
+
+gboolean Editor::s_on_results_rescan(gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    self->results_rescan_id_ = 0;
+    self->start_results_scan();
+    return G_SOURCE_REMOVE;
+}
+
+void Editor::s_on_results_before_delete(GtkTextBuffer*, GtkTextIter* start, GtkTextIter* end, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    self->results_delete_lines_ = gtk_text_iter_get_line(end) - gtk_text_iter_get_line(start) + 1;
+}
+
+void Editor::s_on_results_after_delete(GtkTextBuffer*, GtkTextIter* start, GtkTextIter*, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    if (!self->results_tracking()) return;
+    self->results_lines_changed(gtk_text_iter_get_line(start), self->results_delete_lines_, 1);
+}
+
+void Editor::s_on_results_insert_text(GtkTextBuffer*, GtkTextIter* location, gchar* text, gint len, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    if (!self->results_tracking()) return;
+
+    // after the default handler, location sits at the end of the insertion
+    GtkTextIter start = *location;
+    gtk_text_iter_backward_chars(&start, (gint)g_utf8_strlen(text, len));
+    const int first = gtk_text_iter_get_line(&start);
+    self->results_lines_changed(first, 1, gtk_text_iter_get_line(location) - first + 1);
+}
+
+void Editor::s_on_replace_preview_done(GObject*, GAsyncResult* res, gpointer ud) {
+    ReplacePreviewJob* job = static_cast<ReplacePreviewJob*>(g_task_get_task_data(G_TASK(res)));
+    if (g_cancellable_is_cancelled(job->cancel)) return;   // superseded or editor gone
+
+    Editor* self = static_cast<Editor*>(ud);
+    if (self->replace_preview_cancel_) {
+        g_object_unref(self->replace_preview_cancel_);
+        self->replace_preview_cancel_ = nullptr;
+    }
+    if (!self->replace_preview_) return;
+
+    std::swap(self->replace_plan_, job->plan);
+    self->replace_plan_serial_ = job->serial;
+    self->replace_base_line_ = job->base_line;
+    self->replace_base_index_ = job->base_index;
+
+    GtkWidget* tree = GTK_WIDGET(g_object_get_data(G_OBJECT(self->replace_preview_), "results"));
+    self->replace_hits_->reset(self->replace_plan_.hunks().size());
+    gtk_tree_view_set_model(GTK_TREE_VIEW(tree), self->replace_hits_->model());
+    self->update_replace_preview_status();
+}
+
+void Editor::s_on_replace_preview_response(GtkDialog*, gint resp, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+
+    if (resp == kResponseAcceptAll || resp == kResponseRejectAll) {
+        self->replace_plan_.set_all_accepted(resp == kResponseAcceptAll);
+        GtkWidget* tree = GTK_WIDGET(g_object_get_data(G_OBJECT(self->replace_preview_), "results"));
+        gtk_widget_queue_draw(tree);
+        self->update_replace_preview_status();
+        return;
+    }
+
+    if (resp == GTK_RESPONSE_APPLY) {
+        if (self->replace_preview_cancel_) return;          // still computing
+        if (self->replace_plan_serial_ != self->edit_serial_) {
+            // the snapshot no longer matches the buffer
+            self->start_replace_preview(self->replace_query_, self->replace_with_);
+            return;
+        }
+        self->apply_replace_plan();
+    }
+
+    self->close_replace_preview();
+}
+
+void Editor::s_on_replace_hunk_toggled(GtkCellRendererToggle*, gchar* path_str, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    GtkTreePath* path = gtk_tree_path_new_from_string(path_str);
+    size_t row = 0;
+    if (HitListModel::row_at(path, &row) && row < self->replace_plan_.hunks().size()) {
+        self->replace_plan_.set_accepted(row, !self->replace_plan_.hunks()[row].accepted);
+        self->replace_hits_->changed(row);
+        self->update_replace_preview_status();
+    }
+    gtk_tree_path_free(path);
+}
+
+void Editor::s_on_replace_preview_row_activated(GtkTreeView*, GtkTreePath* path, GtkTreeViewColumn*, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    size_t row = 0;
+    if (!HitListModel::row_at(path, &row) || row >= self->replace_plan_.hunks().size()) return;
+    self->goto_line(self->replace_base_line_ + self->replace_plan_.hunks()[row].line + 1);
+}
+
 void Editor::s_on_goto_line_response(GtkDialog* dlg, gint resp, gpointer ud) {
     Editor* self = static_cast<Editor*>(ud);
     if (resp == GTK_RESPONSE_OK) {
@@ -1215,19 +4394,208 @@ void Editor::s_on_goto_line_response(GtkDialog* dlg, gint resp, gpointer ud) {
     gtk_widget_destroy(GTK_WIDGET(dlg));
 }
 
-void Editor::s_on_recent_activated(GtkRecentChooser* chooser, gpointer ud) {
+void Editor::s_on_pin_term_activate(GtkWidget*, gpointer ud) {
     Editor* self = static_cast<Editor*>(ud);
-    gchar* uri = gtk_recent_chooser_get_current_uri(chooser);
-    if (!uri) return;
-
-    gchar* path = g_filename_from_uri(uri, nullptr, nullptr);
-    if (path) {
-        self->opened_via_cli_ = true;
-        self->open_file_from_path(path);
-        self->opened_via_cli_ = false;
-        g_free(path);
+    GtkTextIter s, e;
+    if (gtk_text_buffer_get_selection_bounds(self->buffer_, &s, &e) &&
+        gtk_text_iter_get_line(&s) == gtk_text_iter_get_line(&e)) {
+        gchar* sel = gtk_text_buffer_get_text(self->buffer_, &s, &e, TRUE);
+        if (sel) {
+            self->toggle_pinned_term(sel);
+            g_free(sel);
+        }
+        return;
+    }
+    self->show_pin_term_dialog();
+}
+
+void Editor::s_on_clear_pins_activate(GtkWidget*, gpointer ud) {
+    static_cast<Editor*>(ud)->set_pinned_terms({});
+}
+
+void Editor::s_on_pin_term_response(GtkDialog* dlg, gint resp, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    if (resp == GTK_RESPONSE_OK) {
+        GtkWidget* entry = GTK_WIDGET(g_object_get_data(G_OBJECT(dlg), "term_entry"));
+        const char* t = entry ? gtk_entry_get_text(GTK_ENTRY(entry)) : "";
+        if (t && *t) self->toggle_pinned_term(t);
+    }
+    gtk_widget_destroy(GTK_WIDGET(dlg));
+}
+
+void Editor::s_on_pin_insert_text(GtkTextBuffer*, GtkTextIter* location, gchar* text, gint len, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    // after the default handler, location sits at the end of the insertion
+    GtkTextIter start = *location;
+    gtk_text_iter_backward_chars(&start, (gint)g_utf8_strlen(text, len));
+    self->pin_mark_dirty(&start, location);
+}
+
+void Editor::s_on_pin_delete_range(GtkTextBuffer*, GtkTextIter* start, GtkTextIter* end, gpointer ud) {
+    static_cast<Editor*>(ud)->pin_mark_dirty(start, end);
+}
+
+void Editor::s_on_view_scrolled(GtkAdjustment*, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    self->schedule_pin_scan();
+    if (self->viewport_highlight_) self->schedule_highlight(true);
+}
+
+gboolean Editor::s_on_pin_idle(gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    if (self->pin_scan_step()) return G_SOURCE_CONTINUE;
+    self->pin_idle_id_ = 0;
+    return G_SOURCE_REMOVE;
+}
+
+void Editor::s_on_project_search_activate(GtkWidget*, gpointer ud) {
+    static_cast<Editor*>(ud)->show_project_search_dialog();
+}
+
+void Editor::s_on_project_dialog_response(GtkDialog* dlg, gint resp, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+
+    if (resp == GTK_RESPONSE_OK) {
+        GtkWidget* entry = GTK_WIDGET(g_object_get_data(G_OBJECT(dlg), "find_entry"));
+        const char* t = entry ? gtk_entry_get_text(GTK_ENTRY(entry)) : "";
+        self->project_search(t ? t : "");
+        return; // keep dialog open
+    }
+
+    if (self->project_search_cancel_) {
+        g_cancellable_cancel(self->project_search_cancel_);
+        g_object_unref(self->project_search_cancel_);
+        self->project_search_cancel_ = nullptr;
+    }
+    self->project_dialog_ = nullptr;
+    gtk_widget_destroy(GTK_WIDGET(dlg));
+}
+
+void Editor::s_on_project_row_activated(GtkTreeView* tree, GtkTreePath* path, GtkTreeViewColumn*, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    GtkTreeModel* model = gtk_tree_view_get_model(tree);
+    GtkTreeIter it;
+    if (!gtk_tree_model_get_iter(model, &it, path)) return;
+
+    gchar* file = nullptr;
+    gint line = 0;
+    gtk_tree_model_get(model, &it, 0, &file, 1, &line, -1);
+    if (file) {
+        if (self->current_file_ != file) self->open_in_tab(file);
+        if (self->current_file_ == file) self->goto_line(line);
+        g_free(file);
+    }
+}
+
+void Editor::s_on_project_search_done(GObject*, GAsyncResult* res, gpointer ud) {
+    ProjectSearchJob* job = static_cast<ProjectSearchJob*>(g_task_get_task_data(G_TASK(res)));
+    if (g_cancellable_is_cancelled(job->cancel)) return;   // superseded or editor gone
+
+    Editor* self = static_cast<Editor*>(ud);
+    if (!self->project_dialog_) return;
+
+    GtkWidget* tree = GTK_WIDGET(g_object_get_data(G_OBJECT(self->project_dialog_), "results"));
+    GtkWidget* status = GTK_WIDGET(g_object_get_data(G_OBJECT(self->project_dialog_), "status"));
+    GtkListStore* store = GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(tree)));
+
+    // detach while filling so the view does not relayout per row
+    g_object_ref(store);
+    gtk_tree_view_set_model(GTK_TREE_VIEW(tree), nullptr);
+    gtk_list_store_clear(store);
+
+    const size_t root_len = job->root.size() + 1;
+    for (const ProjectHit& h : job->hits) {
+        std::string shown = h.path.size() > root_len ? h.path.substr(root_len) : h.path;
+        gtk_list_store_insert_with_values(store, nullptr, -1,
+                                          0, h.path.c_str(),
+                                          1, h.line,
+                                          2, shown.c_str(),
+                                          3, h.text.c_str(),
+                                          -1);
+    }
+    gtk_tree_view_set_model(GTK_TREE_VIEW(tree), GTK_TREE_MODEL(store));
+    g_object_unref(store);
+
+    std::stringstream ss;
+    ss << job->hits.size() << (job->truncated ? "+" : "") << " matches in "
+       << job->files_scanned << " files scanned";
+    if (!job->walk) ss << " (indexed)";
+    if (status) gtk_label_set_text(GTK_LABEL(status), ss.str().c_str());
+}
+
+void Editor::s_on_index_build_done(GObject*, GAsyncResult* res, gpointer ud) {
+    IndexBuildJob* job = static_cast<IndexBuildJob*>(g_task_get_task_data(G_TASK(res)));
+    if (g_cancellable_is_cancelled(job->cancel)) return;
+
+    Editor* self = static_cast<Editor*>(ud);
+    self->index_building_ = false;
+    if (job->root != self->project_root_) return;
+
+    if (!job->result.error.empty()) {
+        std::cerr << "Project index: " << job->result.error << "\n";
+        return;
+    }
+
+    if (!self->project_index_.load(job->index_path, job->root)) {
+        std::cerr << "Project index: could not load " << job->index_path << "\n";
+        return;
     }
-    g_free(uri);
+
+    // anything changed during the build stays dirty until the next one
+    for (const std::string& p : job->dirty_before) self->project_dirty_.erase(p);
+    self->install_project_monitors(job->result.dirs);
+}
+
+void Editor::s_on_index_validate_done(GObject*, GAsyncResult* res, gpointer ud) {
+    IndexValidateJob* job = static_cast<IndexValidateJob*>(g_task_get_task_data(G_TASK(res)));
+    if (g_cancellable_is_cancelled(job->cancel)) return;
+
+    Editor* self = static_cast<Editor*>(ud);
+    if (job->root != self->project_root_) return;
+
+    self->project_dirty_.insert(job->stale.begin(), job->stale.end());
+    self->install_project_monitors(job->dirs);
+    if (!job->stale.empty()) self->schedule_index_rebuild(job->stale.size() > 256 ? 2 : 30);
+}
+
+void Editor::s_on_project_dir_changed(GFileMonitor*, GFile* file, GFile* other, GFileMonitorEvent ev, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+
+    switch (ev) {
+    case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+    case G_FILE_MONITOR_EVENT_CREATED:
+    case G_FILE_MONITOR_EVENT_DELETED:
+    case G_FILE_MONITOR_EVENT_MOVED_IN:
+    case G_FILE_MONITOR_EVENT_MOVED_OUT:
+    case G_FILE_MONITOR_EVENT_RENAMED:
+        break;
+    default:
+        return;
+    }
+
+    for (GFile* f : { file, other }) {
+        if (!f) continue;
+        gchar* path = g_file_get_path(f);
+        if (path) {
+            self->project_dirty_.insert(path);
+            g_free(path);
+        }
+    }
+    self->schedule_index_rebuild(self->project_dirty_.size() > 256 ? 2 : 30);
+}
+
+gboolean Editor::s_on_index_rebuild_timeout(gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    self->index_rebuild_id_ = 0;
+    if (self->project_index_enabled_) self->start_index_build();
+    return G_SOURCE_REMOVE;
+}
+
+void Editor::s_on_recent_activated(GtkMenuItem* item, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    // a copy: opening the file rebuilds the list this item belongs to
+    const std::string path = static_cast<const char*>(g_object_get_data(G_OBJECT(item), "path"));
+    self->open_in_tab(path);
 }
 
 void Editor::s_on_file_monitor_changed(GFileMonitor*, GFile*, GFile*, GFileMonitorEvent ev, gpointer ud) {
@@ -1266,6 +4634,76 @@ void Editor::s_on_zoom_in_activate(GtkWidget*, gpointer ud) { static_cast<Editor
 void Editor::s_on_zoom_out_activate(GtkWidget*, gpointer ud) { static_cast<Editor*>(ud)->zoom_step(-1); }
 void Editor::s_on_zoom_reset_activate(GtkWidget*, gpointer ud) { static_cast<Editor*>(ud)->zoom_set(11); }
 
+void Editor::s_on_toggle_minimap(GtkWidget* w, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    self->show_minimap_ = gtk_check_menu_item_get_active(GTK_CHECK_MENU_ITEM(w));
+    gtk_widget_set_no_show_all(self->minimap_->widget(), !self->show_minimap_);
+    gtk_widget_set_visible(self->minimap_->widget(), self->show_minimap_);
+}
+
+void Editor::s_on_toggle_ruler(GtkWidget* w, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    self->show_ruler_ = gtk_check_menu_item_get_active(GTK_CHECK_MENU_ITEM(w));
+    gtk_widget_set_no_show_all(self->ruler_->widget(), !self->show_ruler_);
+    gtk_widget_set_visible(self->ruler_->widget(), self->show_ruler_);
+    // the search bar's hits are only gathered while something shows them
+    if (!self->results_tracking()) self->drop_results();
+    else if (!self->results_matcher_) self->start_results_scan();
+}
+
+void Editor::s_on_toggle_latency_hud(GtkWidget* w, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    self->show_latency_hud_ = gtk_check_menu_item_get_active(GTK_CHECK_MENU_ITEM(w));
+    // each showing measures from a clean slate
+    if (self->show_latency_hud_) self->latency_.reset();
+    self->latency_.set_hud_visible(self->show_latency_hud_);
+}
+
+void Editor::s_on_toggle_trace(GtkWidget* w, gpointer) {
+    trace::set_enabled(gtk_check_menu_item_get_active(GTK_CHECK_MENU_ITEM(w)));
+}
+
+void Editor::s_on_save_trace_activate(GtkWidget*, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    GtkWidget* dialog = gtk_file_chooser_dialog_new(
+        "Save Trace",
+        GTK_WINDOW(self->window_),
+        GTK_FILE_CHOOSER_ACTION_SAVE,
+        "_Cancel", GTK_RESPONSE_CANCEL,
+        "_Save", GTK_RESPONSE_ACCEPT,
+        nullptr);
+    gtk_file_chooser_set_do_overwrite_confirmation(GTK_FILE_CHOOSER(dialog), TRUE);
+    gtk_file_chooser_set_current_name(GTK_FILE_CHOOSER(dialog), "colossus-trace.json");
+
+    if (gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_ACCEPT) {
+        char* filename = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog));
+        std::string error;
+        if (filename && !trace::dump(filename, &error))
+            std::cerr << "Error saving trace: " << error << "\n";
+        g_free(filename);
+    }
+    gtk_widget_destroy(dialog);
+}
+
+void Editor::s_on_memory_usage_activate(GtkWidget*, gpointer ud) {
+    static_cast<Editor*>(ud)->show_memory_dialog();
+}
+
+void Editor::s_on_memory_dialog_response(GtkDialog* dlg, gint resp, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    if (resp == kResponseTrim) {
+        self->trim_memory();
+        self->update_memory_report();
+        return;
+    }
+    if (resp == kResponseRefresh) {
+        self->update_memory_report();
+        return;
+    }
+    self->memory_dialog_ = nullptr;
+    gtk_widget_destroy(GTK_WIDGET(dlg));
+}
+
 void Editor::s_on_toggle_trim_ws(GtkWidget* w, gpointer ud) {
     Editor* self = static_cast<Editor*>(ud);
     self->trim_ws_on_save_ = gtk_check_menu_item_get_active(GTK_CHECK_MENU_ITEM(w));
@@ -1274,6 +4712,16 @@ void Editor::s_on_toggle_eof_nl(GtkWidget* w, gpointer ud) {
     Editor* self = static_cast<Editor*>(ud);
     self->ensure_newline_eof_ = gtk_check_menu_item_get_active(GTK_CHECK_MENU_ITEM(w));
 }
+void Editor::s_on_toggle_project_index(GtkWidget* w, gpointer ud) {
+    Editor* self = static_cast<Editor*>(ud);
+    self->project_index_enabled_ = gtk_check_menu_item_get_active(GTK_CHECK_MENU_ITEM(w));
+    if (!self->project_index_enabled_) {
+        self->cancel_project_jobs();
+        self->project_index_.close();
+        self->project_root_.clear();
+        self->project_dirty_.clear();
+    }
+}
 void Editor::s_on_spaces_toggle(GtkWidget* w, gpointer ud) {
     Editor* self = static_cast<Editor*>(ud);
     gboolean on = gtk_check_menu_item_get_active(GTK_CHECK_MENU_ITEM(w));
@@ -1282,17 +4730,17 @@ void Editor::s_on_spaces_toggle(GtkWidget* w, gpointer ud) {
 void Editor::s_on_tab_width_2(GtkWidget*, gpointer ud) {
     Editor* self = static_cast<Editor*>(ud);
     self->tab_width_ = 2;
-    gtk_source_view_set_tab_width(GTK_SOURCE_VIEW(self->text_view_), self->tab_width_);
+    self->set_view_tab_width(self->tab_width_);
 }
 void Editor::s_on_tab_width_4(GtkWidget*, gpointer ud) {
     Editor* self = static_cast<Editor*>(ud);
     self->tab_width_ = 4;
-    gtk_source_view_set_tab_width(GTK_SOURCE_VIEW(self->text_view_), self->tab_width_);
+    self->set_view_tab_width(self->tab_width_);
 }
 void Editor::s_on_tab_width_8(GtkWidget*, gpointer ud) {
     Editor* self = static_cast<Editor*>(ud);
     self->tab_width_ = 8;
-    gtk_source_view_set_tab_width(GTK_SOURCE_VIEW(self->text_view_), self->tab_width_);
+    self->set_view_tab_width(self->tab_width_);
 }
 
 // ───────────────────────────────────────────────
@@ -1300,15 +4748,50 @@ void Editor::s_on_tab_width_8(GtkWidget*, gpointer ud) {
 // ───────────────────────────────────────────────
 
 int run_colossus_editor(int argc, char** argv) {
-    GtkApplication* app = gtk_application_new(
-        "tech.will.colossus_editor",
-        (GApplicationFlags)(G_APPLICATION_HANDLES_OPEN | G_APPLICATION_NON_UNIQUE)
-    );
+    for (int i = 1; i < argc; ++i)
+        if (std::strcmp(argv[i], "--startup-profile") == 0) startup_profile::enable();
+    const std::string trace_path = trace::init_from_env();
+
+    static const char kAppId[] = "tech.will.colossus_editor";
+
+    // a --server instance is always the one others find; any launch hands
+    // its files to a running primary, and without one only single_instance
+    // makes it the primary for later launches
+    bool unique = single_instance_configured();
+    for (int i = 1; i < argc && !unique; ++i) unique = std::strcmp(argv[i], "--server") == 0;
+    if (!unique) unique = primary_running(kAppId);
+
+    // a launch that finds a primary only forwards its command line over
+    // D-Bus and waits for the reply; GTK itself is only initialised in the
+    // primary
+    GApplicationFlags flags = (GApplicationFlags)(G_APPLICATION_HANDLES_OPEN | G_APPLICATION_HANDLES_COMMAND_LINE);
+    if (!unique) flags = (GApplicationFlags)(flags | G_APPLICATION_NON_UNIQUE);
+    GtkApplication* app = gtk_application_new(kAppId, flags);
+
+    static const GOptionEntry kOptions[] = {
+        { "server", 0, 0, G_OPTION_ARG_NONE, nullptr, "Stay resident and open the files later launches send", nullptr },
+        { "wait", 'w', 0, G_OPTION_ARG_NONE, nullptr, "Return only once the opened windows are closed", nullptr },
+        { "startup-profile", 0, 0, G_OPTION_ARG_NONE, nullptr, "Print how long each phase of start-up took", nullptr },
+        { nullptr, 0, 0, G_OPTION_ARG_NONE, nullptr, nullptr, nullptr },
+    };
+    g_application_add_main_option_entries(G_APPLICATION(app), kOptions);
+    g_application_set_option_context_parameter_string(G_APPLICATION(app), "[+LINE[:COLUMN]] [FILE…]");
 
-    g_signal_connect(app, "activate", G_CALLBACK(Editor::on_activate), nullptr);
-    g_signal_connect(app, "open",     G_CALLBACK(Editor::on_open),     nullptr);
+    g_signal_connect(app, "activate",     G_CALLBACK(Editor::on_activate),     nullptr);
+    g_signal_connect(app, "open",         G_CALLBACK(Editor::on_open),         nullptr);
+    g_signal_connect(app, "command-line", G_CALLBACK(Editor::on_command_line), nullptr);
+    g_signal_connect(app, "startup",      G_CALLBACK(on_app_startup),          nullptr);
+    startup_profile::mark("application");
 
     int status = g_application_run(G_APPLICATION(app), argc, argv);
     g_object_unref(app);
+    // a launch that only forwarded its files, or opened no window
+    startup_profile::report();
+    if (g_launch_config) g_key_file_free(g_launch_config);
+    if (g_recent_files) g_recent_files->flush();
+
+    std::string error;
+    if (!trace_path.empty() && !trace::dump(trace_path, &error))
+        std::cerr << "Error saving trace: " << error << "\n";
     return status;
 }
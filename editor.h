@@ -5,7 +5,29 @@
 #include <gtk/gtk.h>
 #include <gtksourceview/gtksource.h>
 #include <gio/gio.h>
+#include <set>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include "aho_corasick.h"
+#include "bracket_matcher.h"
+#include "column_cache.h"
+#include "document.h"
+#include "file_meta.h"
+#include "hit_model.h"
+#include "latency_monitor.h"
+#include "long_line_guard.h"
+#include "match_index.h"
+#include "minimap.h"
+#include "overview_ruler.h"
+#include "replace_plan.h"
+#include "trigram_index.h"
+#include "ui_scheduler.h"
+#include "undo_history.h"
+
+class TextMatcher;
+struct MatchScanJob;
 
 class Editor {
 public:
@@ -19,29 +41,174 @@ public:
                         gint n_files,
                         const gchar* hint,
                         gpointer user_data);
+    static int on_command_line(GApplication* app,
+                               GApplicationCommandLine* cmd,
+                               gpointer user_data);
 
 private:
     GtkApplication* app_ = nullptr;
     GtkWidget* window_ = nullptr;
+    GtkWidget* main_box_ = nullptr;
+    GtkWidget* text_paned_ = nullptr;           // text above, results panel below
     GtkWidget* text_view_ = nullptr;
     GtkWidget* status_bar_ = nullptr;
     GtkTextBuffer* buffer_ = nullptr;
+    UndoHistory* undo_ = nullptr;               // the shown document's; parked ones keep theirs
     GtkSourceLanguageManager* lang_manager_ = nullptr;
 
     std::string current_file_;
     bool modified_ = false;
+    guint64 edit_serial_ = 0;       // bumped on every buffer change
+    bool bulk_edit_ = false;        // batched edit: skip per-change UI refresh
+
+    // title and status bar are redrawn at most once per frame
+    enum : unsigned {
+        kUiTitle  = 1u << 0,
+        kUiStatus = 1u << 1,
+    };
+    UiScheduler ui_;
+    std::string title_text_;        // last text applied, to skip no-op updates
+    std::string status_text_;
+
+    // keystroke-to-paint latency, always recorded; the HUD is optional
+    LatencyMonitor latency_;
+    bool show_latency_hud_ = false;
+
+    // cursor column for the status bar, checkpointed on long lines
+    ColumnCache* column_cache_ = nullptr;
+
+    // document statistics, kept current from edit deltas
+    gint64 word_count_ = 0;
+    gint64 text_bytes_ = 0;         // size of the buffer's text in bytes
 
     // dialogs
-    GtkWidget* find_dialog_ = nullptr;
     GtkWidget* replace_dialog_ = nullptr;
-
-    // recent files
-    GtkRecentManager* recent_mgr_ = nullptr;
+    GtkWidget* memory_dialog_ = nullptr;
+
+    // inline type-ahead search bar
+    GtkWidget* search_bar_ = nullptr;
+    GtkWidget* search_entry_ = nullptr;
+    GtkWidget* search_case_btn_ = nullptr;
+    GtkWidget* search_regex_btn_ = nullptr;
+    GtkWidget* search_count_label_ = nullptr;
+    GtkTextMark* search_anchor_ = nullptr;   // type-ahead restarts from here
+    guint search_debounce_id_ = 0;
+    GCancellable* search_cancel_ = nullptr;  // in-flight async forward search
+    bool search_wrapped_ = false;
+    std::string last_query_;
+    bool search_case_sensitive_ = false;
+    bool search_regex_ = false;
+
+    // "in selection" scope; the marks follow edits
+    GtkWidget* search_scope_btn_ = nullptr;
+    GtkTextMark* scope_start_ = nullptr;
+    GtkTextMark* scope_end_ = nullptr;
+    GtkTextTag* scope_tag_ = nullptr;
+    bool search_in_scope_ = false;
+
+    // range-bounded match highlighting, used instead of the search
+    // context's whole-buffer scan while a scope is active or the buffer is
+    // large enough for viewport-only highlighting
+    TextMatcher* search_matcher_ = nullptr;
+    GtkTextTag* match_tag_ = nullptr;
+    GtkTextMark* hl_start_ = nullptr;          // range currently tagged
+    GtkTextMark* hl_end_ = nullptr;
+    bool hl_valid_ = false;
+    bool hl_dirty_ = false;                    // text changed inside the tagged range
+    guint highlight_id_ = 0;
+    bool viewport_highlight_ = false;
+    int viewport_highlight_mb_ = 8;            // 0 = never
+
+    // Replace All preview (computed on a snapshot by a worker)
+    ReplacePlan replace_plan_;
+    HitListModel* replace_hits_ = nullptr;
+    GtkWidget* replace_preview_ = nullptr;
+    GCancellable* replace_preview_cancel_ = nullptr;
+    guint64 replace_plan_serial_ = 0;
+    int replace_base_line_ = 0;                // where the snapshot started
+    int replace_base_index_ = 0;
+    std::string replace_query_;
+    std::string replace_with_;
+
+    // search results panel: every match, kept current across edits
+    GtkWidget* results_panel_ = nullptr;
+    GtkWidget* results_view_ = nullptr;
+    GtkWidget* results_label_ = nullptr;
+    HitListModel* results_hits_ = nullptr;
+    MatchIndex results_;
+    TextMatcher* results_matcher_ = nullptr;   // rescans edited lines
+    GCancellable* results_cancel_ = nullptr;
+    MatchScanJob* results_job_ = nullptr;      // full scan in flight
+    guint results_drain_id_ = 0;
+    guint results_rescan_id_ = 0;
+    int results_delete_lines_ = 1;             // lines spanned by the pending delete
+
+    // long-line protection: the view shows only slices of the long lines
+    // and wraps them, syntax highlighting is off and search highlighting
+    // stays around the viewport
+    bool long_line_mode_ = false;
+    LongLineGuard* line_guard_ = nullptr;
+    int long_line_kb_ = 64;                    // 0 = never
+
+    // bracket matching: a bounded scan, then a per-chunk depth index
+    BracketMatcher* bracket_matcher_ = nullptr;
+    int bracket_scan_kb_ = 64;
+
+    // document overview beside the text
+    Minimap* minimap_ = nullptr;
+    bool show_minimap_ = true;
+
+    // whole-file markers beside the scrollbar
+    OverviewRuler* ruler_ = nullptr;
+    bool show_ruler_ = true;
+
+    // recent files: our own list, optionally mirrored to the desktop's
+    GtkWidget* recent_item_ = nullptr;
+    guint64 recent_serial_ = 0;                // list version the submenu shows
+    bool mirror_recent_ = false;
+
+    // open documents, one tab each; the shown one lives in buffer_, the
+    // others are parked within background_mb of memory
+    GtkWidget* tabs_ = nullptr;
+    std::vector<Document*> docs_;
+    Document* shown_doc_ = nullptr;
+    guint64 show_clock_ = 0;
+    bool switching_ = false;                   // we are changing the notebook's page
+    int background_mb_ = 64;
+
+    // menus, search bar and results panel are built after the first frame
+    bool ui_complete_ = false;
+    guint finish_ui_id_ = 0;
 
     // search
     GtkSourceSearchSettings* search_settings_ = nullptr;
     GtkSourceSearchContext*  search_context_  = nullptr;
 
+    // pinned terms: one highlight tag per term, matched in one pass
+    std::vector<std::string> pinned_terms_;
+    std::vector<GtkTextTag*> pin_tags_;
+    AhoCorasick pin_matcher_;
+    GtkTextMark* pin_dirty_start_ = nullptr;   // edited lines not yet rescanned
+    GtkTextMark* pin_dirty_end_ = nullptr;
+    bool pin_dirty_ = false;
+    GtkTextMark* pin_view_start_ = nullptr;    // viewport window scanned last
+    GtkTextMark* pin_view_end_ = nullptr;
+    bool pin_view_valid_ = false;
+    guint pin_idle_id_ = 0;
+
+    // project search (optional trigram index, kept current by dir monitors)
+    bool project_index_enabled_ = false;
+    int index_memory_mb_ = 64;
+    TrigramIndex project_index_;
+    std::string project_root_;
+    std::vector<GFileMonitor*> project_monitors_;
+    std::set<std::string> project_dirty_;
+    GCancellable* project_search_cancel_ = nullptr;
+    GCancellable* index_cancel_ = nullptr;
+    bool index_building_ = false;
+    guint index_rebuild_id_ = 0;
+    GtkWidget* project_dialog_ = nullptr;
+
     // file monitor
     GFileMonitor* file_monitor_ = nullptr;
     guint64 file_mtime_utc_us_ = 0;
@@ -50,20 +217,27 @@ private:
     // prefs
     bool trim_ws_on_save_ = true;
     bool ensure_newline_eof_ = true;
-    int tab_width_ = 4;
+    int tab_width_ = 4;                        // default; a reopened file gets its own back
+    GtkWidget* spaces_item_ = nullptr;
+
+    // as found when the file was opened, kept in the file's metadata
+    FileMeta::LineEnding line_ending_ = FileMeta::kEndingUnknown;
+    bool file_shown_ = false;                  // buffer holds current_file_
 
     // zoom
     int font_pt_ = 11;
 
     // session
     bool opened_via_cli_ = false;
+    std::vector<GApplicationCommandLine*> waiters_;   // --wait clients, released on close
 
     // UI setup
     void setup_ui();
+    void finish_ui();
     GtkWidget* create_menu_bar();
     void setup_sourceview_defaults();
     void setup_search();
-    void setup_recent();
+    GtkWidget* create_search_bar();
 
     // File ops
     void new_file();
@@ -71,6 +245,26 @@ private:
     void save_file();
     void save_file_as();
     void open_file_from_path(const std::string& path);
+    void load_text(const char* text, gint len);
+
+    // per-file cursor, scroll and tab settings
+    void remember_file_meta();
+    void restore_file_meta();
+    void set_view_tab_width(int width);
+    void set_view_insert_spaces(bool on);
+    void capture_view_state(FileMeta* meta);
+    void apply_view_state(const FileMeta& meta);
+
+    // documents (tabs)
+    Document* add_document(const std::string& path);
+    Document* find_document(const std::string& path);
+    void open_in_tab(const std::string& path);
+    void show_document(Document* d);
+    void park_shown_document();
+    void close_document(Document* d);
+    bool confirm_discard_all(const char* action_label);
+    void update_tab_label(Document* d);
+    void enforce_background_budget(size_t budget);
 
     // extra file ops
     void open_containing_folder();
@@ -80,7 +274,9 @@ private:
 
     // prompts
     bool maybe_confirm_discard(const char* action_label);
+    bool confirm_discard(const char* action_label);
     bool confirm_reload_external(const char* reason);
+    void report_error(const char* message, const char* detail);
 
     // Edit ops
     void cut();
@@ -89,26 +285,97 @@ private:
     void select_all();
 
     // Find / Replace / Go To
-    void show_find_dialog();
+    void show_search_bar();
+    void hide_search_bar();
     void show_replace_dialog();
     void show_goto_line_dialog();
-    void goto_line(int line);
+    void goto_line(int line, int column = 0);
 
     // search helpers
     void ensure_search_context();
-    void update_search_from_dialog(GtkWidget* dialog);
+    void apply_search_options();
+    void schedule_incremental_search();
+    void run_incremental_search();
+    void update_search_count();
+    void sync_search_context();
+    void rebuild_search_matcher();
+    bool set_search_scope(bool on);
+    bool get_search_scope(GtkTextIter* start, GtkTextIter* end);
+    bool manual_highlight() const;
+    void update_highlight_mode();
+    bool highlight_target(GtkTextIter* start, GtkTextIter* end);
+    bool find_chunked(const GtkTextIter* from, bool backwards, GtkTextIter* ms, GtkTextIter* me);
+    void range_matches(const GtkTextIter* start, const GtkTextIter* end, std::vector<std::pair<int, int>>* out);
+    void highlight_matches_in_range(const GtkTextIter* start, const GtkTextIter* end);
+    void clear_manual_highlight();
+    void refresh_manual_highlight();
+    void schedule_highlight(bool now = false);
     void search_find_next(bool backwards);
     void search_replace_one(const std::string& repl);
-    void search_replace_all(const std::string& repl);
+
+    // Replace All preview
+    void start_replace_preview(const std::string& query, const std::string& repl);
+    void show_replace_preview();
+    void update_replace_preview_status();
+    void apply_replace_plan();
+    void close_replace_preview();
+
+    // search results panel
+    GtkWidget* create_results_panel();
+    void show_results_panel(bool show);
+    bool results_active() const;
+    bool results_tracking() const;
+    void drop_results();
+    void start_results_scan();
+    void stop_results_scan();
+    void drain_results();
+    void results_lines_changed(int line, int old_lines, int new_lines);
+    void schedule_results_rescan();
+    void update_results_label();
+
+    // project search
+    void show_project_search_dialog();
+    void project_search(const std::string& query);
+    void ensure_project_index(const std::string& root);
+    void start_index_build();
+    void schedule_index_rebuild(guint seconds);
+    void install_project_monitors(const std::vector<std::string>& dirs);
+    void remove_project_monitors();
+    void cancel_project_jobs();
+
+    // memory diagnostics
+    void show_memory_dialog();
+    void update_memory_report();
+    void trim_memory();
+
+    // pinned terms
+    void setup_pins();
+    void set_pinned_terms(const std::vector<std::string>& terms);
+    void toggle_pinned_term(const std::string& term);
+    void show_pin_term_dialog();
+    void pins_reset();
+    void pin_mark_dirty(const GtkTextIter* start, const GtkTextIter* end);
+    void schedule_pin_scan();
+    bool pin_scan_step();
+    void pin_scan_lines(const GtkTextIter* start, const GtkTextIter* end);
+    void get_visible_range(int margin_lines, GtkTextIter* start, GtkTextIter* end);
 
     // Syntax highlighting
     void update_language_for_filename(const std::string& filename);
+    void set_long_line_mode(bool on);
 
-    // status + title
+    // status + title: the update_* calls only mark the part dirty
     void update_title();
     void update_status_full();
     void update_cursor_status();
     void mark_modified(bool is_modified);
+    void flush_ui(unsigned dirty);
+    void render_title();
+    void render_status();
+
+    // document statistics
+    void stats_before_insert(const GtkTextIter* at, const char* text, int len);
+    void stats_before_delete(const GtkTextIter* start, const GtkTextIter* end);
 
     // save helpers
     void apply_save_fixes(std::string& text);
@@ -118,9 +385,9 @@ private:
     void add_recent_item(const std::string& path);
 
     // config + session
-    void load_config();
+    void load_config(GKeyFile* kf);
     void save_config();
-    void load_session();
+    void load_session(GKeyFile* kf);
     void save_session();
 
     // zoom
@@ -134,7 +401,18 @@ private:
     static void s_on_save_as_activate(GtkWidget*, gpointer);
     static void s_on_reload_activate(GtkWidget*, gpointer);
     static void s_on_open_folder_activate(GtkWidget*, gpointer);
+    static gboolean s_on_window_delete(GtkWidget*, GdkEvent*, gpointer);
+    static void s_on_window_destroy(GtkWidget*, gpointer);
+    static gboolean s_on_first_draw(GtkWidget*, cairo_t*, gpointer);
+    static gboolean s_on_window_focus_in(GtkWidget*, GdkEventFocus*, gpointer);
+    static gboolean s_on_finish_ui(gpointer);
+    static void s_on_file_menu_show(GtkWidget*, gpointer);
     static void s_on_quit_activate(GtkWidget*, gpointer);
+    static void s_on_close_tab_activate(GtkWidget*, gpointer);
+    static void s_on_next_tab_activate(GtkWidget*, gpointer);
+    static void s_on_prev_tab_activate(GtkWidget*, gpointer);
+    static void s_on_tab_close_clicked(GtkButton*, gpointer);
+    static void s_on_switch_page(GtkNotebook*, GtkWidget*, guint, gpointer);
 
     static void s_on_cut_activate(GtkWidget*, gpointer);
     static void s_on_copy_activate(GtkWidget*, gpointer);
@@ -147,22 +425,73 @@ private:
 
     static void s_on_buffer_changed(GtkTextBuffer*, gpointer);
     static void s_on_cursor_notify(GObject*, GParamSpec*, gpointer);
+    static void s_on_mark_set(GtkTextBuffer*, GtkTextIter*, GtkTextMark*, gpointer);
+    static void s_on_stats_before_insert(GtkTextBuffer*, GtkTextIter*, gchar*, gint, gpointer);
+    static void s_on_stats_before_delete(GtkTextBuffer*, GtkTextIter*, GtkTextIter*, gpointer);
 
     static gboolean s_on_key_press(GtkWidget*, GdkEventKey*, gpointer);
 
-    static void s_on_find_dialog_response(GtkDialog*, gint, gpointer);
+    static void s_on_search_entry_changed(GtkEditable*, gpointer);
+    static void s_on_search_entry_activate(GtkEntry*, gpointer);
+    static void s_on_search_next_match(GtkSearchEntry*, gpointer);
+    static void s_on_search_previous_match(GtkSearchEntry*, gpointer);
+    static void s_on_search_prev_clicked(GtkButton*, gpointer);
+    static void s_on_search_next_clicked(GtkButton*, gpointer);
+    static void s_on_search_option_toggled(GtkToggleButton*, gpointer);
+    static void s_on_search_scope_toggled(GtkToggleButton*, gpointer);
+    static gboolean s_on_highlight_timeout(gpointer);
+    static void s_on_search_mode_notify(GObject*, GParamSpec*, gpointer);
+    static void s_on_search_count_notify(GObject*, GParamSpec*, gpointer);
+    static gboolean s_on_search_debounce(gpointer);
+    static void s_on_incremental_search_done(GObject*, GAsyncResult*, gpointer);
     static void s_on_replace_dialog_response(GtkDialog*, gint, gpointer);
+    static void s_on_replace_preview_done(GObject*, GAsyncResult*, gpointer);
+    static void s_on_replace_preview_response(GtkDialog*, gint, gpointer);
+    static void s_on_replace_hunk_toggled(GtkCellRendererToggle*, gchar*, gpointer);
+    static void s_on_replace_preview_row_activated(GtkTreeView*, GtkTreePath*, GtkTreeViewColumn*, gpointer);
     static void s_on_goto_line_response(GtkDialog*, gint, gpointer);
-
-    static void s_on_recent_activated(GtkRecentChooser*, gpointer);
+    static void s_on_pin_term_activate(GtkWidget*, gpointer);
+    static void s_on_clear_pins_activate(GtkWidget*, gpointer);
+    static void s_on_pin_term_response(GtkDialog*, gint, gpointer);
+    static void s_on_pin_insert_text(GtkTextBuffer*, GtkTextIter*, gchar*, gint, gpointer);
+    static void s_on_pin_delete_range(GtkTextBuffer*, GtkTextIter*, GtkTextIter*, gpointer);
+    static void s_on_view_scrolled(GtkAdjustment*, gpointer);
+    static gboolean s_on_pin_idle(gpointer);
+    static void s_on_results_activate(GtkWidget*, gpointer);
+    static void s_on_results_close_clicked(GtkButton*, gpointer);
+    static void s_on_results_row_activated(GtkTreeView*, GtkTreePath*, GtkTreeViewColumn*, gpointer);
+    static void s_on_results_scan_done(GObject*, GAsyncResult*, gpointer);
+    static gboolean s_on_results_drain(gpointer);
+    static gboolean s_on_results_rescan(gpointer);
+    static void s_on_results_before_delete(GtkTextBuffer*, GtkTextIter*, GtkTextIter*, gpointer);
+    static void s_on_results_after_delete(GtkTextBuffer*, GtkTextIter*, GtkTextIter*, gpointer);
+    static void s_on_results_insert_text(GtkTextBuffer*, GtkTextIter*, gchar*, gint, gpointer);
+    static void s_on_project_search_activate(GtkWidget*, gpointer);
+    static void s_on_project_dialog_response(GtkDialog*, gint, gpointer);
+    static void s_on_project_row_activated(GtkTreeView*, GtkTreePath*, GtkTreeViewColumn*, gpointer);
+    static void s_on_project_search_done(GObject*, GAsyncResult*, gpointer);
+    static void s_on_index_build_done(GObject*, GAsyncResult*, gpointer);
+    static void s_on_index_validate_done(GObject*, GAsyncResult*, gpointer);
+    static void s_on_project_dir_changed(GFileMonitor*, GFile*, GFile*, GFileMonitorEvent, gpointer);
+    static gboolean s_on_index_rebuild_timeout(gpointer);
+
+    static void s_on_recent_activated(GtkMenuItem*, gpointer);
     static void s_on_file_monitor_changed(GFileMonitor*, GFile*, GFile*, GFileMonitorEvent, gpointer);
 
     static void s_on_zoom_in_activate(GtkWidget*, gpointer);
     static void s_on_zoom_out_activate(GtkWidget*, gpointer);
     static void s_on_zoom_reset_activate(GtkWidget*, gpointer);
+    static void s_on_toggle_minimap(GtkWidget*, gpointer);
+    static void s_on_toggle_ruler(GtkWidget*, gpointer);
+    static void s_on_toggle_latency_hud(GtkWidget*, gpointer);
+    static void s_on_toggle_trace(GtkWidget*, gpointer);
+    static void s_on_save_trace_activate(GtkWidget*, gpointer);
+    static void s_on_memory_usage_activate(GtkWidget*, gpointer);
+    static void s_on_memory_dialog_response(GtkDialog*, gint, gpointer);
 
     static void s_on_toggle_trim_ws(GtkWidget*, gpointer);
     static void s_on_toggle_eof_nl(GtkWidget*, gpointer);
+    static void s_on_toggle_project_index(GtkWidget*, gpointer);
     static void s_on_spaces_toggle(GtkWidget*, gpointer);
     static void s_on_tab_width_2(GtkWidget*, gpointer);
     static void s_on_tab_width_4(GtkWidget*, gpointer);
@@ -0,0 +1,26 @@
+// fast_scroll.cpp — jumping the text view to a far-away line without a layout stall
+
+#include "fast_scroll.h"
+
+#include <algorithm>
+
+void fast_scroll_to_line(GtkTextView* view, int line, double yalign) {
+    GtkTextBuffer* buffer = gtk_text_view_get_buffer(view);
+    GtkTextIter it;
+    gtk_text_buffer_get_iter_at_line(buffer, &it, line);
+
+    gint y = 0, height = 0;
+    gtk_text_view_get_line_yrange(view, &it, &y, &height);
+
+    GtkAdjustment* vadj = gtk_scrollable_get_vadjustment(GTK_SCROLLABLE(view));
+    const double lower = gtk_adjustment_get_lower(vadj);
+    const double page = gtk_adjustment_get_page_size(vadj);
+    const double top = std::max(lower, gtk_adjustment_get_upper(vadj) - page);
+    gtk_adjustment_set_value(vadj, std::min(top, std::max(lower, y - (page - height) * yalign)));
+
+    // one mark per buffer, moved on each jump
+    GtkTextMark* mark = gtk_text_buffer_get_mark(buffer, "fast-scroll");
+    if (!mark) mark = gtk_text_buffer_create_mark(buffer, "fast-scroll", &it, TRUE);
+    else gtk_text_buffer_move_mark(buffer, mark, &it);
+    gtk_text_view_scroll_to_mark(view, mark, 0.0, TRUE, 0.0, yalign);
+}
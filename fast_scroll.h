@@ -0,0 +1,14 @@
+// fast_scroll.h — jumping the text view to a far-away line without a layout stall
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+// Scrolls view so line sits at yalign (0 top .. 1 bottom) of the viewport.
+// gtk_text_view_scroll_to_iter lays out the target before scrolling, which
+// on a document of millions of lines can stall for seconds. This sets the
+// adjustment straight from the line's y as GtkTextBTree has it (per-node
+// height sums, estimated for lines never laid out) and then queues
+// gtk_text_view_scroll_to_mark, which corrects the position once the lines
+// on screen have been laid out.
+void fast_scroll_to_line(GtkTextView* view, int line, double yalign);
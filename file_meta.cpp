@@ -0,0 +1,185 @@
+// file_meta.cpp — per-file cursor, scroll and options, in a memory-mapped table
+
+#include "file_meta.h"
+
+#include <glib/gstdio.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+static const char kMagic[8] = { 'C', 'L', 'F', 'M', 'E', 'T', 'A', '2' };
+static const guint32 kSets = 512;            // power of two
+static const guint32 kWays = 8;
+
+// FNV-1a; 0 marks an empty slot
+static guint64 path_hash(const std::string& path) {
+    guint64 h = 14695981039346656037ull;
+    for (unsigned char c : path) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h ? h : 1;
+}
+
+} // namespace
+
+struct FileMetaStore::Header {
+    char magic[8];
+    guint32 sets;
+    guint32 ways;
+    guint64 clock;                           // bumped on every use
+    char reserved[40];
+};
+
+struct FileMetaStore::Record {
+    guint64 hash;                            // 0: empty
+    guint64 dev;
+    guint64 inode;
+    guint64 size;                            // the file's when stored, to tell a
+    gint64 mtime;                            // reused inode from a renamed file
+    guint64 used;                            // clock at last use
+    gint32 cursor_line;
+    gint32 cursor_offset;
+    gint32 top_line;
+    gint16 tab_width;
+    gint8 insert_spaces;
+    gint8 line_ending;
+    char encoding[16];
+};
+
+FileMetaStore::FileMetaStore(std::string file) : file_(std::move(file)) {}
+
+FileMetaStore::~FileMetaStore() {
+    if (header_) munmap(header_, mapped_size_);
+}
+
+// Maps the table on first use, creating or resetting the file when it is
+// missing or not in this format.
+bool FileMetaStore::map() {
+    static_assert(sizeof(Header) == 64 && sizeof(Record) == 80, "on-disk layout");
+    if (header_) return true;
+    if (failed_) return false;
+    failed_ = true;
+
+    gchar* dir = g_path_get_dirname(file_.c_str());
+    g_mkdir_with_parents(dir, 0755);
+    g_free(dir);
+
+    const int fd = open(file_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+
+    const size_t size = sizeof(Header) + (size_t)kSets * kWays * sizeof(Record);
+    GStatBuf st;
+    bool fresh = fstat(fd, &st) != 0 || (size_t)st.st_size != size;
+    if (fresh && (ftruncate(fd, 0) != 0 || ftruncate(fd, (off_t)size) != 0)) {
+        close(fd);
+        return false;
+    }
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return false;
+
+    header_ = static_cast<Header*>(p);
+    records_ = reinterpret_cast<Record*>(header_ + 1);
+    mapped_size_ = size;
+    if (fresh || std::memcmp(header_->magic, kMagic, sizeof(kMagic)) != 0 ||
+        header_->sets != kSets || header_->ways != kWays) {
+        std::memset(p, 0, size);
+        std::memcpy(header_->magic, kMagic, sizeof(kMagic));
+        header_->sets = kSets;
+        header_->ways = kWays;
+    }
+    failed_ = false;
+    return true;
+}
+
+// The slot for path, or the one the file had under another path. Inodes
+// are reused once a file is deleted, so an old name's record is only taken
+// while size and modification time are still the ones it was stored with.
+FileMetaStore::Record* FileMetaStore::find(guint64 hash, const GStatBuf* st) {
+    Record* set = records_ + (size_t)((hash >> 32) & (kSets - 1)) * kWays;
+    for (guint32 i = 0; i < kWays; ++i)
+        if (set[i].hash == hash) return &set[i];
+
+    if (!st) return nullptr;
+    const size_t n = (size_t)kSets * kWays;
+    for (size_t i = 0; i < n; ++i) {
+        const Record& r = records_[i];
+        if (r.hash && r.inode == (guint64)st->st_ino && r.dev == (guint64)st->st_dev &&
+            r.size == (guint64)st->st_size && r.mtime == (gint64)st->st_mtime)
+            return &records_[i];
+    }
+    return nullptr;
+}
+
+// A slot in path's set: its own, an empty one, or the least recently used.
+FileMetaStore::Record* FileMetaStore::claim(guint64 hash) {
+    Record* set = records_ + (size_t)((hash >> 32) & (kSets - 1)) * kWays;
+    Record* victim = set;
+    for (guint32 i = 0; i < kWays; ++i) {
+        if (set[i].hash == hash || !set[i].hash) return &set[i];
+        if (set[i].used < victim->used) victim = &set[i];
+    }
+    return victim;
+}
+
+bool FileMetaStore::lookup(const std::string& path, FileMeta* meta) {
+    if (!map()) return false;
+
+    GStatBuf st;
+    const bool known = g_stat(path.c_str(), &st) == 0;
+    const guint64 hash = path_hash(path);
+    Record* r = find(hash, known ? &st : nullptr);
+    if (!r) return false;
+
+    // found under an old name: move it to this one
+    if (r->hash != hash) {
+        Record* slot = claim(hash);
+        if (slot != r) {
+            *slot = *r;
+            std::memset(r, 0, sizeof(Record));
+            r = slot;
+        }
+        r->hash = hash;
+    }
+    r->used = ++header_->clock;
+
+    meta->cursor_line = r->cursor_line;
+    meta->cursor_offset = r->cursor_offset;
+    meta->top_line = r->top_line;
+    meta->tab_width = r->tab_width;
+    meta->insert_spaces = r->insert_spaces;
+    meta->line_ending = (FileMeta::LineEnding)r->line_ending;
+    meta->encoding.assign(r->encoding, strnlen(r->encoding, sizeof(r->encoding)));
+    return true;
+}
+
+void FileMetaStore::store(const std::string& path, const FileMeta& meta) {
+    if (path.empty() || !map()) return;
+
+    GStatBuf st;
+    const bool known = g_stat(path.c_str(), &st) == 0;
+    Record* r = claim(path_hash(path));
+    std::memset(r, 0, sizeof(Record));
+    r->hash = path_hash(path);
+    // saving replaces the file, so the inode is only a fallback
+    r->dev = known ? (guint64)st.st_dev : 0;
+    r->inode = known ? (guint64)st.st_ino : 0;
+    r->size = known ? (guint64)st.st_size : 0;
+    r->mtime = known ? (gint64)st.st_mtime : 0;
+    r->used = ++header_->clock;
+    r->cursor_line = meta.cursor_line;
+    r->cursor_offset = meta.cursor_offset;
+    r->top_line = meta.top_line;
+    r->tab_width = (gint16)std::max(0, std::min(meta.tab_width, 1000));
+    r->insert_spaces = (gint8)meta.insert_spaces;
+    r->line_ending = meta.line_ending;
+    std::memcpy(r->encoding, meta.encoding.data(), std::min(meta.encoding.size(), sizeof(r->encoding) - 1));
+}
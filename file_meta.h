@@ -0,0 +1,60 @@
+// file_meta.h — per-file cursor, scroll and options, in a memory-mapped table
+
+#pragma once
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// What the editor remembers about a file between visits.
+struct FileMeta {
+    enum LineEnding : int8_t { kEndingUnknown = 0, kEndingLF, kEndingCRLF, kEndingCR };
+
+    int cursor_line = 0;            // 0-based
+    int cursor_offset = 0;          // characters into the line
+    int top_line = 0;               // first line in view
+    int tab_width = 0;              // 0: not recorded
+    int insert_spaces = -1;         // -1: not recorded
+    LineEnding line_ending = kEndingUnknown;
+    std::string encoding;           // at most 15 bytes are kept
+};
+
+// A fixed-size hash table in a file under the config directory, used
+// straight from a shared mapping: a lookup is a stat and a probe of one
+// set of eight slots, with nothing parsed however many files it knows.
+// Slots are found by a 64-bit hash of the path; when that misses, the
+// file's device and inode are searched for, so a file renamed outside
+// the editor keeps its entry as long as its size and modification time
+// are unchanged. Each set evicts its least recently used slot when full,
+// which bounds the file at 320 KiB.
+//
+// Editors in other processes map the same file. Their writes can
+// interleave with ours; the worst outcome is one file forgetting its
+// position.
+class FileMetaStore {
+public:
+    explicit FileMetaStore(std::string file);
+    ~FileMetaStore();
+
+    FileMetaStore(const FileMetaStore&) = delete;
+    FileMetaStore& operator=(const FileMetaStore&) = delete;
+
+    bool lookup(const std::string& path, FileMeta* meta);
+    void store(const std::string& path, const FileMeta& meta);
+
+private:
+    struct Header;
+    struct Record;
+
+    std::string file_;
+    Header* header_ = nullptr;
+    Record* records_ = nullptr;
+    size_t mapped_size_ = 0;
+    bool failed_ = false;                    // mapping is tried once
+
+    bool map();
+    Record* find(guint64 hash, const GStatBuf* st);
+    Record* claim(guint64 hash);
+};
@@ -0,0 +1,248 @@
+// hit_model.cpp — virtualized list model for large result lists
+
+#include "hit_model.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// Row index travels in iter->user_data; the stamp catches iterators kept
+// across a reset().
+struct HitStore {
+    GObject parent;
+    gint stamp;
+    gint n_columns;
+    GType* types;
+    gsize rows;
+    const HitListModel::ValueFunc* value;    // null once the owner is gone
+};
+
+static gint g_next_stamp = 1;
+static GObjectClass* hit_store_parent_class = nullptr;
+
+static GType hit_store_get_type();
+
+static inline HitStore* HIT_STORE(gpointer p) {
+    return reinterpret_cast<HitStore*>(p);
+}
+
+static void hit_store_finalize(GObject* obj) {
+    HitStore* store = HIT_STORE(obj);
+    g_free(store->types);
+    hit_store_parent_class->finalize(obj);
+}
+
+static void hit_store_class_init(gpointer klass, gpointer) {
+    hit_store_parent_class = G_OBJECT_CLASS(g_type_class_peek_parent(klass));
+    G_OBJECT_CLASS(klass)->finalize = hit_store_finalize;
+}
+
+static void hit_store_init(GTypeInstance* instance, gpointer) {
+    HitStore* store = HIT_STORE(instance);
+    store->stamp = g_next_stamp++;
+    store->n_columns = 0;
+    store->types = nullptr;
+    store->rows = 0;
+    store->value = nullptr;
+}
+
+// Not ITERS_PERSIST: an iterator is a row index, which a row inserted or
+// removed above it shifts.
+static GtkTreeModelFlags hit_store_get_flags(GtkTreeModel*) {
+    return GTK_TREE_MODEL_LIST_ONLY;
+}
+
+static gint hit_store_get_n_columns(GtkTreeModel* model) {
+    return HIT_STORE(model)->n_columns;
+}
+
+static GType hit_store_get_column_type(GtkTreeModel* model, gint index) {
+    HitStore* store = HIT_STORE(model);
+    return (index >= 0 && index < store->n_columns) ? store->types[index] : G_TYPE_INVALID;
+}
+
+static gboolean hit_store_set_iter(HitStore* store, GtkTreeIter* iter, gsize row) {
+    if (row >= store->rows) return FALSE;
+    iter->stamp = store->stamp;
+    iter->user_data = GSIZE_TO_POINTER(row);
+    iter->user_data2 = nullptr;
+    iter->user_data3 = nullptr;
+    return TRUE;
+}
+
+static gboolean hit_store_get_iter(GtkTreeModel* model, GtkTreeIter* iter, GtkTreePath* path) {
+    if (gtk_tree_path_get_depth(path) != 1) return FALSE;
+    gint row = gtk_tree_path_get_indices(path)[0];
+    return row >= 0 && hit_store_set_iter(HIT_STORE(model), iter, (gsize)row);
+}
+
+static GtkTreePath* hit_store_get_path(GtkTreeModel*, GtkTreeIter* iter) {
+    return gtk_tree_path_new_from_indices((gint)GPOINTER_TO_SIZE(iter->user_data), -1);
+}
+
+static void hit_store_get_value(GtkTreeModel* model, GtkTreeIter* iter, gint column, GValue* value) {
+    HitStore* store = HIT_STORE(model);
+    g_value_init(value, hit_store_get_column_type(model, column));
+
+    const gsize row = GPOINTER_TO_SIZE(iter->user_data);
+    if (store->value && row < store->rows) (*store->value)(row, column, value);
+}
+
+static gboolean hit_store_iter_next(GtkTreeModel* model, GtkTreeIter* iter) {
+    return hit_store_set_iter(HIT_STORE(model), iter, GPOINTER_TO_SIZE(iter->user_data) + 1);
+}
+
+static gboolean hit_store_iter_previous(GtkTreeModel* model, GtkTreeIter* iter) {
+    const gsize row = GPOINTER_TO_SIZE(iter->user_data);
+    return row > 0 && hit_store_set_iter(HIT_STORE(model), iter, row - 1);
+}
+
+static gboolean hit_store_iter_children(GtkTreeModel* model, GtkTreeIter* iter, GtkTreeIter* parent) {
+    if (parent) return FALSE;
+    return hit_store_set_iter(HIT_STORE(model), iter, 0);
+}
+
+static gboolean hit_store_iter_has_child(GtkTreeModel*, GtkTreeIter*) {
+    return FALSE;
+}
+
+static gint hit_store_iter_n_children(GtkTreeModel* model, GtkTreeIter* iter) {
+    return iter ? 0 : (gint)HIT_STORE(model)->rows;
+}
+
+static gboolean hit_store_iter_nth_child(GtkTreeModel* model, GtkTreeIter* iter, GtkTreeIter* parent, gint n) {
+    if (parent || n < 0) return FALSE;
+    return hit_store_set_iter(HIT_STORE(model), iter, (gsize)n);
+}
+
+static gboolean hit_store_iter_parent(GtkTreeModel*, GtkTreeIter*, GtkTreeIter*) {
+    return FALSE;
+}
+
+static void hit_store_tree_model_init(gpointer g_iface, gpointer) {
+    GtkTreeModelIface* iface = static_cast<GtkTreeModelIface*>(g_iface);
+    iface->get_flags = hit_store_get_flags;
+    iface->get_n_columns = hit_store_get_n_columns;
+    iface->get_column_type = hit_store_get_column_type;
+    iface->get_iter = hit_store_get_iter;
+    iface->get_path = hit_store_get_path;
+    iface->get_value = hit_store_get_value;
+    iface->iter_next = hit_store_iter_next;
+    iface->iter_previous = hit_store_iter_previous;
+    iface->iter_children = hit_store_iter_children;
+    iface->iter_has_child = hit_store_iter_has_child;
+    iface->iter_n_children = hit_store_iter_n_children;
+    iface->iter_nth_child = hit_store_iter_nth_child;
+    iface->iter_parent = hit_store_iter_parent;
+}
+
+static GType hit_store_get_type() {
+    static GType type = 0;
+    if (!type) {
+        static const GTypeInfo info = {
+            sizeof(GObjectClass),
+            nullptr, nullptr,
+            hit_store_class_init,
+            nullptr, nullptr,
+            sizeof(HitStore),
+            0,
+            hit_store_init,
+            nullptr,
+        };
+        type = g_type_register_static(G_TYPE_OBJECT, "ColossusHitStore", &info, (GTypeFlags)0);
+
+        static const GInterfaceInfo tree_model_info = { hit_store_tree_model_init, nullptr, nullptr };
+        g_type_add_interface_static(type, GTK_TYPE_TREE_MODEL, &tree_model_info);
+    }
+    return type;
+}
+
+} // namespace
+
+HitListModel::HitListModel(const std::vector<GType>& column_types, ValueFunc value)
+    : types_(column_types), value_(std::move(value))
+{
+    model_ = create_model(0);
+}
+
+HitListModel::~HitListModel() {
+    release_model();
+}
+
+GtkTreeModel* HitListModel::create_model(size_t rows) {
+    HitStore* store = HIT_STORE(g_object_new(hit_store_get_type(), nullptr));
+    store->n_columns = (gint)types_.size();
+    store->types = g_new(GType, types_.size());
+    for (size_t i = 0; i < types_.size(); ++i) store->types[i] = types_[i];
+    store->rows = rows;
+    store->value = &value_;
+    return GTK_TREE_MODEL(store);
+}
+
+// Views may keep the old object alive; it simply reports no rows from now on.
+void HitListModel::release_model() {
+    if (!model_) return;
+    HitStore* store = HIT_STORE(model_);
+    store->value = nullptr;
+    store->rows = 0;
+    g_object_unref(model_);
+    model_ = nullptr;
+}
+
+size_t HitListModel::size() const {
+    return model_ ? HIT_STORE(model_)->rows : 0;
+}
+
+void HitListModel::reset(size_t rows) {
+    release_model();
+    model_ = create_model(rows);
+}
+
+void HitListModel::insert(size_t at, size_t rows) {
+    HitStore* store = HIT_STORE(model_);
+    if (at > store->rows) at = store->rows;
+    for (size_t i = 0; i < rows; ++i) {
+        const gsize row = at + i;
+        store->rows++;
+        GtkTreeIter iter;
+        hit_store_set_iter(store, &iter, row);
+        GtkTreePath* path = gtk_tree_path_new_from_indices((gint)row, -1);
+        gtk_tree_model_row_inserted(model_, path, &iter);
+        gtk_tree_path_free(path);
+    }
+}
+
+void HitListModel::remove(size_t at, size_t rows) {
+    HitStore* store = HIT_STORE(model_);
+    if (at >= store->rows) return;
+    rows = std::min<size_t>(rows, store->rows - at);
+
+    // from the back, so each announced path is still the row's current one
+    for (size_t i = rows; i-- > 0;) {
+        store->rows--;
+        GtkTreePath* path = gtk_tree_path_new_from_indices((gint)(at + i), -1);
+        gtk_tree_model_row_deleted(model_, path);
+        gtk_tree_path_free(path);
+    }
+}
+
+void HitListModel::changed(size_t row) {
+    GtkTreeIter iter;
+    if (!hit_store_set_iter(HIT_STORE(model_), &iter, row)) return;
+    GtkTreePath* path = gtk_tree_path_new_from_indices((gint)row, -1);
+    gtk_tree_model_row_changed(model_, path, &iter);
+    gtk_tree_path_free(path);
+}
+
+bool HitListModel::row_at(GtkTreePath* path, size_t* row) {
+    if (!path || gtk_tree_path_get_depth(path) != 1) return false;
+    gint i = gtk_tree_path_get_indices(path)[0];
+    if (i < 0) return false;
+    *row = (size_t)i;
+    return true;
+}
+
+size_t HitListModel::row_of(const GtkTreeIter* iter) {
+    return GPOINTER_TO_SIZE(iter->user_data);
+}
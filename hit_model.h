@@ -0,0 +1,54 @@
+// hit_model.h — virtualized list model for large result lists
+
+#pragma once
+
+#include <gtk/gtk.h>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// A flat GtkTreeModel whose rows live in the caller's own storage. The model
+// only knows the row count; cell values are produced on demand by a callback,
+// so a GtkTreeView in fixed-height mode touches just the rows on screen no
+// matter how many there are.
+class HitListModel {
+public:
+    // Fills value (already initialised to the column's type) for one cell.
+    using ValueFunc = std::function<void(size_t row, int column, GValue* value)>;
+
+    HitListModel(const std::vector<GType>& column_types, ValueFunc value);
+    ~HitListModel();
+
+    HitListModel(const HitListModel&) = delete;
+    HitListModel& operator=(const HitListModel&) = delete;
+
+    GtkTreeModel* model() const { return model_; }
+    size_t size() const;
+
+    // Swaps in a fresh model object with the given row count. Re-announcing
+    // every row to an attached view costs O(n) signals, so callers set the
+    // new model() on their views instead.
+    void reset(size_t rows);
+
+    // rows new rows now sit at position at (later rows moved down).
+    void insert(size_t at, size_t rows);
+    void append(size_t rows) { insert(size(), rows); }
+
+    // rows rows starting at position at are gone (later rows moved up).
+    void remove(size_t at, size_t rows);
+
+    // Value of row changed; attached views redraw it.
+    void changed(size_t row);
+
+    // Row index for a path or iterator into one of these models.
+    static bool row_at(GtkTreePath* path, size_t* row);
+    static size_t row_of(const GtkTreeIter* iter);
+
+private:
+    std::vector<GType> types_;
+    ValueFunc value_;
+    GtkTreeModel* model_ = nullptr;
+
+    GtkTreeModel* create_model(size_t rows);
+    void release_model();
+};
@@ -0,0 +1,162 @@
+// latency_monitor.cpp — keystroke-to-paint latency histogram and HUD
+
+#include "latency_monitor.h"
+#include "ui_scheduler.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+static const size_t kMaxPending = 256;   // presses while nothing paints (minimized)
+
+} // namespace
+
+LatencyMonitor::LatencyMonitor() : hist_(kBuckets + 1, 0u) {
+    hud_ = gtk_label_new("");
+    g_object_ref_sink(hud_);
+    gtk_widget_set_halign(hud_, GTK_ALIGN_END);
+    gtk_widget_set_valign(hud_, GTK_ALIGN_START);
+    gtk_widget_set_margin_top(hud_, 6);
+    gtk_widget_set_margin_end(hud_, 6);
+    gtk_widget_set_no_show_all(hud_, TRUE);
+    gtk_style_context_add_class(gtk_widget_get_style_context(hud_), "osd");
+}
+
+LatencyMonitor::~LatencyMonitor() {
+    if (hud_timer_id_) g_source_remove(hud_timer_id_);
+    disconnect_clock();
+    if (owner_) {
+        g_signal_handlers_disconnect_by_data(owner_, this);
+        g_object_remove_weak_pointer(G_OBJECT(owner_), (gpointer*)&owner_);
+    }
+    g_object_unref(hud_);
+}
+
+void LatencyMonitor::attach(GtkWidget* owner) {
+    owner_ = owner;
+    g_object_add_weak_pointer(G_OBJECT(owner_), (gpointer*)&owner_);
+    g_signal_connect(owner_, "realize", G_CALLBACK(LatencyMonitor::s_on_realize), this);
+    g_signal_connect(owner_, "unrealize", G_CALLBACK(LatencyMonitor::s_on_unrealize), this);
+    if (gtk_widget_get_realized(owner_)) connect_clock();
+}
+
+void LatencyMonitor::connect_clock() {
+    disconnect_clock();
+    clock_ = gtk_widget_get_frame_clock(owner_);
+    if (!clock_) return;
+    g_object_ref(clock_);
+    paint_id_ = g_signal_connect(clock_, "after-paint", G_CALLBACK(LatencyMonitor::s_on_after_paint), this);
+}
+
+void LatencyMonitor::disconnect_clock() {
+    if (!clock_) return;
+    g_signal_handler_disconnect(clock_, paint_id_);
+    g_object_unref(clock_);
+    clock_ = nullptr;
+    paint_id_ = 0;
+    pending_.clear();
+}
+
+void LatencyMonitor::key_pressed(const GdkEventKey* e) {
+    // modifiers alone change nothing on screen
+    if (e->is_modifier || !clock_ || pending_.size() >= kMaxPending) return;
+    pending_.push_back(g_get_monotonic_time());
+    // a press that queues no redraw still ends at the next frame
+    gdk_frame_clock_request_phase(clock_, GDK_FRAME_CLOCK_PHASE_PAINT);
+}
+
+void LatencyMonitor::reset() {
+    std::fill(hist_.begin(), hist_.end(), 0u);
+    count_ = 0;
+    over_frame_ = 0;
+    max_us_ = 0;
+    update_hud();
+}
+
+void LatencyMonitor::record(gint64 latency_us) {
+    const size_t b = (size_t)std::min<gint64>(latency_us / kBucketUs, kBuckets);
+    ++hist_[b];
+    ++count_;
+    if (latency_us > frame_us_) ++over_frame_;
+    max_us_ = std::max(max_us_, latency_us);
+}
+
+// Upper edge of the bucket holding the p-th fraction of the samples; the
+// overflow bucket reports the maximum seen.
+double LatencyMonitor::percentile(double p) const {
+    if (!count_) return 0;
+    const guint64 want = std::max<guint64>(1, (guint64)(p * (double)count_ + 0.5));
+    guint64 seen = 0;
+    for (size_t b = 0; b < hist_.size(); ++b) {
+        seen += hist_[b];
+        if (seen < want) continue;
+        if (b == (size_t)kBuckets) break;
+        return std::min((double)(b + 1) * kBucketUs, (double)max_us_) / 1000.0;
+    }
+    return (double)max_us_ / 1000.0;
+}
+
+LatencyMonitor::Summary LatencyMonitor::summary() const {
+    Summary s;
+    s.count = count_;
+    s.p50_ms = percentile(0.50);
+    s.p95_ms = percentile(0.95);
+    s.p99_ms = percentile(0.99);
+    s.max_ms = (double)max_us_ / 1000.0;
+    s.frame_ms = (double)frame_us_ / 1000.0;
+    s.over_frame = over_frame_;
+    return s;
+}
+
+void LatencyMonitor::set_hud_visible(bool visible) {
+    gtk_widget_set_visible(hud_, visible);
+    if (visible && !hud_timer_id_) {
+        update_hud();
+        hud_timer_id_ = g_timeout_add(500, LatencyMonitor::s_on_hud_timer, this);
+    } else if (!visible && hud_timer_id_) {
+        g_source_remove(hud_timer_id_);
+        hud_timer_id_ = 0;
+    }
+}
+
+void LatencyMonitor::update_hud() {
+    const Summary s = summary();
+    char buf[256];
+    if (!s.count) {
+        std::snprintf(buf, sizeof buf, "key→paint: type to measure (frame %.1f ms)", s.frame_ms);
+    } else {
+        std::snprintf(buf, sizeof buf,
+                      "key→paint  p50 %.1f  p95 %.1f  p99 %.1f  max %.1f ms\n"
+                      "%llu keys, %llu over one frame (%.1f ms)",
+                      s.p50_ms, s.p95_ms, s.p99_ms, s.max_ms,
+                      (unsigned long long)s.count, (unsigned long long)s.over_frame, s.frame_ms);
+    }
+    UiScheduler::set_label(hud_, &hud_text_, buf);
+}
+
+void LatencyMonitor::s_on_realize(GtkWidget*, gpointer ud) {
+    static_cast<LatencyMonitor*>(ud)->connect_clock();
+}
+
+void LatencyMonitor::s_on_unrealize(GtkWidget*, gpointer ud) {
+    static_cast<LatencyMonitor*>(ud)->disconnect_clock();
+}
+
+void LatencyMonitor::s_on_after_paint(GdkFrameClock* clock, gpointer ud) {
+    LatencyMonitor* self = static_cast<LatencyMonitor*>(ud);
+    if (self->pending_.empty()) return;
+
+    gint64 interval = 0;
+    gdk_frame_clock_get_refresh_info(clock, gdk_frame_clock_get_frame_time(clock), &interval, nullptr);
+    if (interval > 0) self->frame_us_ = interval;
+
+    const gint64 now = g_get_monotonic_time();
+    for (gint64 t : self->pending_) self->record(now - t);
+    self->pending_.clear();
+}
+
+gboolean LatencyMonitor::s_on_hud_timer(gpointer ud) {
+    static_cast<LatencyMonitor*>(ud)->update_hud();
+    return G_SOURCE_CONTINUE;
+}
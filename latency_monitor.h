@@ -0,0 +1,74 @@
+// latency_monitor.h — keystroke-to-paint latency histogram and HUD
+
+#pragma once
+
+#include <gtk/gtk.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Timestamps each key press and the end of the next frame painted on the
+// owner's frame clock; the difference goes into a fixed-resolution
+// histogram from which the percentiles are read. Recording is a couple of
+// integer updates per key, so it is always on; the HUD is a label meant for
+// an overlay that refreshes itself twice a second while shown.
+class LatencyMonitor {
+public:
+    struct Summary {
+        guint64 count = 0;
+        double p50_ms = 0;
+        double p95_ms = 0;
+        double p99_ms = 0;
+        double max_ms = 0;
+        double frame_ms = 0;        // refresh interval of the display
+        guint64 over_frame = 0;     // presses that took longer than one frame
+    };
+
+    LatencyMonitor();
+    ~LatencyMonitor();
+
+    LatencyMonitor(const LatencyMonitor&) = delete;
+    LatencyMonitor& operator=(const LatencyMonitor&) = delete;
+
+    // Frames are taken from owner's frame clock once it is realized.
+    void attach(GtkWidget* owner);
+
+    // Called first thing in the owner's key-press-event handler.
+    void key_pressed(const GdkEventKey* e);
+
+    void reset();
+    Summary summary() const;
+
+    GtkWidget* hud() const { return hud_; }
+    void set_hud_visible(bool visible);
+
+private:
+    static const int kBucketUs = 100;
+    static const int kBuckets = 1000;   // 0.1 ms steps up to 100 ms, then one overflow bucket
+
+    GtkWidget* owner_ = nullptr;
+    GdkFrameClock* clock_ = nullptr;
+    gulong paint_id_ = 0;
+
+    std::vector<gint64> pending_;       // presses not yet painted
+    std::vector<guint32> hist_;
+    guint64 count_ = 0;
+    guint64 over_frame_ = 0;
+    gint64 max_us_ = 0;
+    gint64 frame_us_ = 16667;
+
+    GtkWidget* hud_ = nullptr;
+    std::string hud_text_;
+    guint hud_timer_id_ = 0;
+
+    void connect_clock();
+    void disconnect_clock();
+    void record(gint64 latency_us);
+    double percentile(double p) const;
+    void update_hud();
+
+    static void s_on_realize(GtkWidget*, gpointer);
+    static void s_on_unrealize(GtkWidget*, gpointer);
+    static void s_on_after_paint(GdkFrameClock*, gpointer);
+    static gboolean s_on_hud_timer(gpointer);
+};
@@ -0,0 +1,95 @@
+// line_set.cpp — set of line numbers that follows edits to the buffer
+
+#include "line_set.h"
+
+#include <algorithm>
+
+namespace {
+
+static const size_t kMaxRanges = 4096;
+
+static void push_merged(std::vector<LineSet::Range>& out, int first, int end) {
+    if (first >= end) return;
+    if (!out.empty() && first <= out.back().second) {
+        out.back().second = std::max(out.back().second, end);
+        return;
+    }
+    out.emplace_back(first, end);
+}
+
+} // namespace
+
+void LineSet::lines_changed(int line, int old_lines, int new_lines) {
+    log_.push_back(Edit{ line, old_lines, new_lines });
+}
+
+void LineSet::clear() {
+    std::vector<Range>().swap(ranges_);
+    std::vector<Edit>().swap(log_);
+}
+
+const std::vector<LineSet::Range>& LineSet::ranges(int gap) {
+    // split the log into runs where each edit ends at or above the start of
+    // the one before it; within a run no edit moves another, so all of them
+    // are in the same coordinates and can be swept together, lowest first
+    size_t i = 0;
+    while (i < log_.size()) {
+        size_t j = i + 1;
+        while (j < log_.size() && log_[j].line + log_[j].old_lines <= log_[j - 1].line) ++j;
+        std::reverse(log_.begin() + (ptrdiff_t)i, log_.begin() + (ptrdiff_t)j);
+        apply(log_.data() + i, j - i);
+        i = j;
+    }
+    log_.clear();
+
+    if (ranges_.size() > kMaxRanges) coarsen(std::max(gap, 1));
+    return ranges_;
+}
+
+void LineSet::apply(const Edit* edits, size_t n) {
+    std::vector<Range> out;
+    out.reserve(ranges_.size() + n);
+
+    int shift = 0;          // line delta of the edits swept so far
+    size_t j = 0;
+    for (size_t k = 0; k < n; ++k) {
+        const Edit& e = edits[k];
+        const int old_end = e.line + e.old_lines;
+
+        while (j < ranges_.size() && ranges_[j].second < e.line) {
+            push_merged(out, ranges_[j].first + shift, ranges_[j].second + shift);
+            ++j;
+        }
+
+        int first = e.line + shift;
+        while (j < ranges_.size() && ranges_[j].first <= old_end) {
+            first = std::min(first, ranges_[j].first + shift);
+            if (ranges_[j].second > old_end) {
+                // the rest lies past the edit; it is swept with the next one
+                ranges_[j].first = old_end;
+                break;
+            }
+            ++j;
+        }
+        push_merged(out, first, e.line + e.new_lines + shift);
+        shift += e.new_lines - e.old_lines;
+    }
+    for (; j < ranges_.size(); ++j) push_merged(out, ranges_[j].first + shift, ranges_[j].second + shift);
+
+    ranges_.swap(out);
+}
+
+// Merges neighbours separated by less than gap lines, widening the gap
+// until the list is short enough.
+void LineSet::coarsen(int gap) {
+    while (ranges_.size() > kMaxRanges) {
+        std::vector<Range> out;
+        out.reserve(ranges_.size());
+        for (const Range& r : ranges_) {
+            if (!out.empty() && r.first - out.back().second < gap) out.back().second = r.second;
+            else out.push_back(r);
+        }
+        ranges_.swap(out);
+        gap *= 2;
+    }
+}
@@ -0,0 +1,42 @@
+// line_set.h — set of line numbers that follows edits to the buffer
+
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Lines touched since the last clear(), as sorted disjoint [first, end)
+// ranges. Edits are logged in O(1) and folded in on the next ranges() call:
+// a run of edits that each land above the previous one (Replace All works
+// back to front) is merged in a single sweep, so a batch of n edits costs
+// O(n + ranges) instead of O(n * ranges).
+class LineSet {
+public:
+    using Range = std::pair<int, int>;
+
+    // Lines [line, line + old_lines) became [line, line + new_lines); the new
+    // lines are in the set.
+    void lines_changed(int line, int old_lines, int new_lines);
+
+    void clear();
+    bool empty() const { return ranges_.empty() && log_.empty(); }
+    size_t memory_bytes() const { return ranges_.capacity() * sizeof(Range) + log_.capacity() * sizeof(Edit); }
+
+    // Ranges closer than gap lines may be merged to keep the list short;
+    // callers that draw at a fixed resolution pass the lines per pixel.
+    const std::vector<Range>& ranges(int gap = 1);
+
+private:
+    struct Edit {
+        int line;
+        int old_lines;
+        int new_lines;
+    };
+
+    std::vector<Range> ranges_;
+    std::vector<Edit> log_;
+
+    void apply(const Edit* edits, size_t n);   // ascending, non-overlapping
+    void coarsen(int gap);
+};
@@ -0,0 +1,303 @@
+// long_line_guard.cpp — shows only a slice of very long lines, so the view never lays one out whole
+
+#include "long_line_guard.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+static const int kHeadChars = 4096;         // shown at the start of the other long lines
+static const int kSliceChars = 32768;       // shown around the cursor on its line
+
+// GtkTextBuffer ends lines at \n, \r, \r\n and U+2029; a \r\n is taken as
+// two ends here, with an empty line between them.
+static const char* next_line_end(const char* p, const char* end, size_t* len) {
+    for (; p < end; ++p) {
+        if (*p == '\n' || *p == '\r') {
+            *len = 1;
+            return p;
+        }
+        if (*p == '\xE2' && end - p >= 3 && p[1] == '\x80' && p[2] == '\xA9') {
+            *len = 3;
+            return p;
+        }
+    }
+    *len = 0;
+    return end;
+}
+
+} // namespace
+
+LongLineGuard::LongLineGuard(GtkTextView* view) : view_(view) {
+    g_object_ref(view_);
+    buffer_ = gtk_text_view_get_buffer(view_);
+    hidden_ = gtk_text_buffer_create_tag(buffer_, nullptr, "invisible", TRUE, nullptr);
+
+    GtkTextIter start;
+    gtk_text_buffer_get_start_iter(buffer_, &start);
+    slice_ = gtk_text_buffer_create_mark(buffer_, nullptr, &start, TRUE);
+
+    text_targets_ = gtk_target_list_new(nullptr, 0);
+    gtk_target_list_add_text_targets(text_targets_, 0);
+    target_table_ = gtk_target_table_new_from_list(text_targets_, &n_targets_);
+
+    g_signal_connect(buffer_, "notify::cursor-position", G_CALLBACK(LongLineGuard::s_on_cursor_notify), this);
+    g_signal_connect_after(buffer_, "insert-text", G_CALLBACK(LongLineGuard::s_on_insert_text), this);
+    g_signal_connect(buffer_, "delete-range", G_CALLBACK(LongLineGuard::s_on_before_delete), this);
+    g_signal_connect_after(buffer_, "delete-range", G_CALLBACK(LongLineGuard::s_on_after_delete), this);
+    g_signal_connect(buffer_, "mark-set", G_CALLBACK(LongLineGuard::s_on_mark_set), this);
+    g_signal_connect_after(view_, "realize", G_CALLBACK(LongLineGuard::s_on_realize), this);
+    // before the view's own handler, which gives PRIMARY back to the buffer
+    g_signal_connect(view_, "unrealize", G_CALLBACK(LongLineGuard::s_on_unrealize), this);
+    g_signal_connect(view_, "copy-clipboard", G_CALLBACK(LongLineGuard::s_on_copy_clipboard), this);
+    g_signal_connect(view_, "cut-clipboard", G_CALLBACK(LongLineGuard::s_on_cut_clipboard), this);
+    // after the view's handler, replacing the visible text it set
+    g_signal_connect_after(view_, "drag-data-get", G_CALLBACK(LongLineGuard::s_on_drag_data_get), this);
+}
+
+LongLineGuard::~LongLineGuard() {
+    set_limit(0);
+    g_signal_handlers_disconnect_by_data(buffer_, this);
+    g_signal_handlers_disconnect_by_data(view_, this);
+    gtk_text_buffer_delete_mark(buffer_, slice_);
+    gtk_target_table_free(target_table_, n_targets_);
+    gtk_target_list_unref(text_targets_);
+    g_object_unref(view_);
+}
+
+void LongLineGuard::set_limit(int chars) {
+    const bool was = active();
+    limit_ = std::max(0, chars);
+    if (active() == was) return;
+
+    if (active()) {
+        // drops come in as text, never as a copy of tagged buffer contents
+        saved_drops_ = gtk_drag_dest_get_target_list(GTK_WIDGET(view_));
+        if (saved_drops_) gtk_target_list_ref(saved_drops_);
+        gtk_drag_dest_set_target_list(GTK_WIDGET(view_), text_targets_);
+        take_primary(gtk_widget_get_realized(GTK_WIDGET(view_)));
+        follow_cursor(true);
+        return;
+    }
+
+    GtkTextIter s, e;
+    gtk_text_buffer_get_bounds(buffer_, &s, &e);
+    gtk_text_buffer_remove_tag(buffer_, hidden_, &s, &e);
+    slice_valid_ = false;
+    take_primary(false);
+    gtk_drag_dest_set_target_list(GTK_WIDGET(view_), saved_drops_);
+    if (saved_drops_) gtk_target_list_unref(saved_drops_);
+    saved_drops_ = nullptr;
+}
+
+void LongLineGuard::clip_to_shown(const GtkTextIter* anchor, GtkTextIter* start, GtkTextIter* end) const {
+    if (!active()) return;
+    if (gtk_text_iter_has_tag(anchor, hidden_)) {
+        *start = *end = *anchor;
+        return;
+    }
+    GtkTextIter it = *anchor;
+    if (gtk_text_iter_ends_tag(&it, hidden_) || gtk_text_iter_backward_to_tag_toggle(&it, hidden_)) {
+        if (gtk_text_iter_compare(&it, start) > 0) *start = it;
+    }
+    it = *anchor;
+    if (gtk_text_iter_forward_to_tag_toggle(&it, hidden_) && gtk_text_iter_compare(&it, end) < 0) *end = it;
+}
+
+bool LongLineGuard::copy(GtkClipboard* cb, bool cut) {
+    if (!active()) return false;
+    gchar* text = selection_text();
+    if (!text) return false;
+    gtk_clipboard_set_text(cb, text, -1);
+    g_free(text);
+    if (cut) gtk_text_buffer_delete_selection(buffer_, TRUE, gtk_text_view_get_editable(view_));
+    return true;
+}
+
+// ───── shaping ─────
+
+void LongLineGuard::hide(int from, int to) {
+    if (from >= to) return;
+    GtkTextIter a, b;
+    gtk_text_buffer_get_iter_at_offset(buffer_, &a, from);
+    gtk_text_buffer_get_iter_at_offset(buffer_, &b, to);
+    gtk_text_buffer_apply_tag(buffer_, hidden_, &a, &b);
+}
+
+// A long line shows its head, or with center >= 0 (a line offset) the
+// window around it; a line under the limit shows whole.
+void LongLineGuard::shape_line(int line, int center) {
+    GtkTextIter ls, le;
+    gtk_text_buffer_get_iter_at_line(buffer_, &ls, line);
+    le = ls;
+    if (!gtk_text_iter_ends_line(&le)) gtk_text_iter_forward_to_line_end(&le);
+    gtk_text_buffer_remove_tag(buffer_, hidden_, &ls, &le);
+
+    const int chars = gtk_text_iter_get_line_offset(&le);
+    if (chars <= limit_) return;
+    const int base = gtk_text_iter_get_offset(&ls);
+    if (center < 0) {
+        hide(base + kHeadChars, base + chars);
+        return;
+    }
+    hide(base, base + center - kSliceChars / 2);
+    hide(base + center + kSliceChars / 2, base + chars);
+}
+
+// Recentres the window once the cursor is half way from its centre to an
+// edge, so moving by rows or pages never runs into hidden text; a line the
+// cursor leaves goes back to its head. reshape lays the window again where
+// it is, after an edit may have shown or hidden text under it.
+void LongLineGuard::follow_cursor(bool reshape) {
+    GtkTextIter at;
+    gtk_text_buffer_get_iter_at_mark(buffer_, &at, gtk_text_buffer_get_insert(buffer_));
+    const int line = gtk_text_iter_get_line(&at);
+    const int offset = gtk_text_iter_get_line_offset(&at);
+
+    if (slice_valid_) {
+        GtkTextIter c;
+        gtk_text_buffer_get_iter_at_mark(buffer_, &c, slice_);
+        const int slice_line = gtk_text_iter_get_line(&c);
+        if (slice_line == line) {
+            const int center = gtk_text_iter_get_line_offset(&c);
+            if (std::abs(offset - center) <= kSliceChars / 4) {
+                if (reshape) shape_line(line, center);
+                return;
+            }
+        } else {
+            shape_line(slice_line, -1);
+        }
+        slice_valid_ = false;
+    }
+
+    if (gtk_text_iter_get_chars_in_line(&at) <= limit_) return;
+    shape_line(line, offset);
+    gtk_text_buffer_move_mark(buffer_, slice_, &at);
+    slice_valid_ = true;
+}
+
+// New long lines in inserted text keep only their heads. Lines the text
+// joins onto at either end are left to the cursor's window.
+void LongLineGuard::guard_text(int offset, const char* text, size_t bytes) {
+    const char* end = text + bytes;
+    int at = offset;
+    for (const char* p = text; p < end;) {
+        size_t eol = 0;
+        const char* q = next_line_end(p, end, &eol);
+        const int chars = (int)g_utf8_strlen(p, (gssize)(q - p));
+        if (chars > limit_) hide(at + kHeadChars, at + chars);
+        at += chars + (eol ? 1 : 0);
+        p = q + eol;
+    }
+}
+
+// ───── selections ─────
+
+gchar* LongLineGuard::selection_text() const {
+    GtkTextIter s, e;
+    if (!gtk_text_buffer_get_selection_bounds(buffer_, &s, &e)) return nullptr;
+    return gtk_text_buffer_get_text(buffer_, &s, &e, TRUE);
+}
+
+// The buffer serves PRIMARY for the view while it is realized; taken, the
+// selection is offered from here instead.
+void LongLineGuard::take_primary(bool on) {
+    if (on == primary_taken_) return;
+    GtkClipboard* primary = gtk_widget_get_clipboard(GTK_WIDGET(view_), GDK_SELECTION_PRIMARY);
+    primary_taken_ = on;
+    if (on) {
+        gtk_text_buffer_remove_selection_clipboard(buffer_, primary);
+        update_primary();
+    } else {
+        if (owns_primary_) gtk_clipboard_clear(primary);
+        gtk_text_buffer_add_selection_clipboard(buffer_, primary);
+    }
+}
+
+void LongLineGuard::update_primary() {
+    if (!primary_taken_) return;
+    GtkClipboard* primary = gtk_widget_get_clipboard(GTK_WIDGET(view_), GDK_SELECTION_PRIMARY);
+    if (gtk_text_buffer_get_selection_bounds(buffer_, nullptr, nullptr)) {
+        // the text is fetched when asked for, not on every mark move
+        if (!owns_primary_)
+            owns_primary_ = gtk_clipboard_set_with_data(primary, target_table_, (guint)n_targets_,
+                                                        LongLineGuard::s_on_primary_get,
+                                                        LongLineGuard::s_on_primary_clear, this);
+    } else if (owns_primary_) {
+        gtk_clipboard_clear(primary);
+    }
+}
+
+// ───── signals ─────
+
+void LongLineGuard::s_on_cursor_notify(GObject*, GParamSpec*, gpointer ud) {
+    LongLineGuard* self = static_cast<LongLineGuard*>(ud);
+    if (self->active()) self->follow_cursor(false);
+}
+
+void LongLineGuard::s_on_insert_text(GtkTextBuffer*, GtkTextIter* end, gchar* text, gint len, gpointer ud) {
+    LongLineGuard* self = static_cast<LongLineGuard*>(ud);
+    if (!self->active()) return;
+    const size_t bytes = len < 0 ? std::strlen(text) : (size_t)len;
+    if (bytes <= (size_t)self->limit_) return;        // cannot hold a long line of its own
+    self->guard_text(gtk_text_iter_get_offset(end) - (int)g_utf8_strlen(text, (gssize)bytes), text, bytes);
+    self->follow_cursor(true);
+}
+
+void LongLineGuard::s_on_before_delete(GtkTextBuffer*, GtkTextIter* start, GtkTextIter* end, gpointer ud) {
+    static_cast<LongLineGuard*>(ud)->joins_lines_ = gtk_text_iter_get_line(start) != gtk_text_iter_get_line(end);
+}
+
+void LongLineGuard::s_on_after_delete(GtkTextBuffer*, GtkTextIter*, GtkTextIter*, gpointer ud) {
+    LongLineGuard* self = static_cast<LongLineGuard*>(ud);
+    if (!self->active()) return;
+    if (self->joins_lines_) self->follow_cursor(true);
+    self->update_primary();
+}
+
+void LongLineGuard::s_on_mark_set(GtkTextBuffer* buffer, GtkTextIter*, GtkTextMark* mark, gpointer ud) {
+    if (mark == gtk_text_buffer_get_insert(buffer) || mark == gtk_text_buffer_get_selection_bound(buffer))
+        static_cast<LongLineGuard*>(ud)->update_primary();
+}
+
+void LongLineGuard::s_on_realize(GtkWidget*, gpointer ud) {
+    LongLineGuard* self = static_cast<LongLineGuard*>(ud);
+    if (self->active()) self->take_primary(true);
+}
+
+void LongLineGuard::s_on_unrealize(GtkWidget*, gpointer ud) {
+    static_cast<LongLineGuard*>(ud)->take_primary(false);
+}
+
+void LongLineGuard::s_on_copy_clipboard(GtkTextView* view, gpointer ud) {
+    LongLineGuard* self = static_cast<LongLineGuard*>(ud);
+    if (self->copy(gtk_widget_get_clipboard(GTK_WIDGET(view), GDK_SELECTION_CLIPBOARD), false))
+        g_signal_stop_emission_by_name(view, "copy-clipboard");
+}
+
+void LongLineGuard::s_on_cut_clipboard(GtkTextView* view, gpointer ud) {
+    LongLineGuard* self = static_cast<LongLineGuard*>(ud);
+    if (self->copy(gtk_widget_get_clipboard(GTK_WIDGET(view), GDK_SELECTION_CLIPBOARD), true))
+        g_signal_stop_emission_by_name(view, "cut-clipboard");
+}
+
+void LongLineGuard::s_on_drag_data_get(GtkWidget*, GdkDragContext*, GtkSelectionData* data, guint, guint, gpointer ud) {
+    LongLineGuard* self = static_cast<LongLineGuard*>(ud);
+    if (!self->active() || !gtk_target_list_find(self->text_targets_, gtk_selection_data_get_target(data), nullptr))
+        return;
+    gchar* text = self->selection_text();
+    if (text) gtk_selection_data_set_text(data, text, -1);
+    g_free(text);
+}
+
+void LongLineGuard::s_on_primary_get(GtkClipboard*, GtkSelectionData* data, guint, gpointer ud) {
+    gchar* text = static_cast<LongLineGuard*>(ud)->selection_text();
+    if (text) gtk_selection_data_set_text(data, text, -1);
+    g_free(text);
+}
+
+void LongLineGuard::s_on_primary_clear(GtkClipboard*, gpointer ud) {
+    static_cast<LongLineGuard*>(ud)->owns_primary_ = false;
+}
@@ -0,0 +1,76 @@
+// long_line_guard.h — shows only a slice of very long lines, so the view never lays one out whole
+
+#pragma once
+
+#include <gtk/gtk.h>
+#include <cstddef>
+
+// GtkTextView lays out each buffer line as one Pango paragraph, and a
+// multi-megabyte minified line makes that (and every row measured for
+// wrapping) hang the window. While a limit is set, every line longer than
+// it is hidden with an invisible tag past a short head, and the line with
+// the cursor shows a window of characters around it instead, which moves
+// along once the cursor wanders towards its edges. Only the layout loses
+// the hidden text: the buffer keeps it unchanged, so positions, search and
+// saving see the file as it is. GTK hands out only visible text on copy,
+// the PRIMARY selection and drag-and-drop, so while active those take the
+// whole selection from here instead, as plain text.
+class LongLineGuard {
+public:
+    explicit LongLineGuard(GtkTextView* view);
+    ~LongLineGuard();
+
+    LongLineGuard(const LongLineGuard&) = delete;
+    LongLineGuard& operator=(const LongLineGuard&) = delete;
+
+    // Lines over chars characters are guarded; 0 shows everything. Only
+    // text inserted from then on is checked (a load inserts it all), plus
+    // the cursor's line.
+    void set_limit(int chars);
+    bool active() const { return limit_ > 0; }
+
+    // Narrows [start, end] to the run of shown text around anchor, for
+    // work bounded to what is on screen.
+    void clip_to_shown(const GtkTextIter* anchor, GtkTextIter* start, GtkTextIter* end) const;
+
+    // The whole selection to cb, deleting it for a cut; false when
+    // inactive or nothing is selected, for GTK's own handling.
+    bool copy(GtkClipboard* cb, bool cut);
+
+private:
+    GtkTextView* view_ = nullptr;
+    GtkTextBuffer* buffer_ = nullptr;
+    GtkTextTag* hidden_ = nullptr;
+    GtkTextMark* slice_ = nullptr;           // centre of the window on the cursor's line
+    bool slice_valid_ = false;
+    int limit_ = 0;
+    bool joins_lines_ = false;               // the deletion in progress spans a line end
+
+    GtkTargetList* text_targets_ = nullptr;
+    GtkTargetEntry* target_table_ = nullptr;
+    gint n_targets_ = 0;
+    GtkTargetList* saved_drops_ = nullptr;   // the view's own, while ours is set
+    bool primary_taken_ = false;             // the buffer no longer serves PRIMARY
+    bool owns_primary_ = false;
+
+    void hide(int from, int to);
+    void shape_line(int line, int center);
+    void follow_cursor(bool reshape);
+    void guard_text(int offset, const char* text, size_t bytes);
+    gchar* selection_text() const;
+    void take_primary(bool on);
+    void update_primary();
+
+    static void s_on_cursor_notify(GObject*, GParamSpec*, gpointer);
+    static void s_on_insert_text(GtkTextBuffer*, GtkTextIter*, gchar*, gint, gpointer);
+    static void s_on_before_delete(GtkTextBuffer*, GtkTextIter*, GtkTextIter*, gpointer);
+    static void s_on_after_delete(GtkTextBuffer*, GtkTextIter*, GtkTextIter*, gpointer);
+    static void s_on_mark_set(GtkTextBuffer*, GtkTextIter*, GtkTextMark*, gpointer);
+    static void s_on_realize(GtkWidget*, gpointer);
+    static void s_on_unrealize(GtkWidget*, gpointer);
+    static void s_on_copy_clipboard(GtkTextView*, gpointer);
+    static void s_on_cut_clipboard(GtkTextView*, gpointer);
+    static void s_on_drag_data_get(GtkWidget*, GdkDragContext*, GtkSelectionData*, guint, guint, gpointer);
+    static void s_on_primary_get(GtkClipboard*, GtkSelectionData*, guint, gpointer);
+    static void s_on_primary_clear(GtkClipboard*, gpointer);
+};
@@ -0,0 +1,62 @@
+// match_index.cpp — line-addressed list of search matches, kept current across edits
+
+#include "match_index.h"
+#include "text_search.h"
+
+#include <algorithm>
+#include <cstring>
+
+void MatchIndex::clear() {
+    std::vector<Hit>().swap(hits_);
+}
+
+void MatchIndex::append(const std::vector<Hit>& hits) {
+    hits_.insert(hits_.end(), hits.begin(), hits.end());
+}
+
+size_t MatchIndex::lower_bound(int line) const {
+    auto it = std::lower_bound(hits_.begin(), hits_.end(), line,
+                               [](const Hit& h, int l) { return h.line < l; });
+    return (size_t)(it - hits_.begin());
+}
+
+MatchIndex::Splice MatchIndex::replace_lines(int line, int old_lines, int new_lines, std::vector<Hit> hits) {
+    const size_t first = lower_bound(line);
+    const size_t last = lower_bound(line + old_lines);
+
+    const int delta = new_lines - old_lines;
+    if (delta != 0) {
+        for (size_t i = last; i < hits_.size(); ++i) hits_[i].line += delta;
+    }
+
+    const size_t removed = last - first;
+    const size_t inserted = hits.size();
+    const size_t common = std::min(removed, inserted);
+
+    // overwrite in place, then grow or shrink by the difference
+    std::copy(hits.begin(), hits.begin() + (ptrdiff_t)common, hits_.begin() + (ptrdiff_t)first);
+    if (inserted > removed) {
+        hits_.insert(hits_.begin() + (ptrdiff_t)last, hits.begin() + (ptrdiff_t)common, hits.end());
+    } else if (removed > inserted) {
+        hits_.erase(hits_.begin() + (ptrdiff_t)(first + common), hits_.begin() + (ptrdiff_t)last);
+    }
+
+    return Splice{ first, removed, inserted };
+}
+
+void MatchIndex::scan(const TextMatcher& matcher, const char* data, size_t len, int first_line,
+                      const std::function<bool(const Hit&)>& cb, GCancellable* cancel) {
+    int line = first_line;
+    size_t line_start = 0;
+    size_t counted_to = 0;
+
+    matcher.find_all(data, len, [&](size_t s, size_t e) {
+        for (const char* p = data + counted_to;
+             (p = (const char*)std::memchr(p, '\n', s - (size_t)(p - data))) != nullptr; ++p) {
+            ++line;
+            line_start = (size_t)(p - data) + 1;
+        }
+        counted_to = s;
+        return cb(Hit{ line, (int)(s - line_start), (int)(e - s) });
+    }, cancel);
+}
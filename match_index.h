@@ -0,0 +1,55 @@
+// match_index.h — line-addressed list of search matches, kept current across edits
+
+#pragma once
+
+#include <gio/gio.h>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+class TextMatcher;
+
+// Every match of the current search, sorted by position. Hits are addressed
+// by line so an edit only has to rescan the lines it touched: hits on those
+// lines are replaced and the line numbers of everything after are shifted.
+class MatchIndex {
+public:
+    struct Hit {
+        int line;        // 0-based
+        int index;       // byte offset within the line
+        int length;      // bytes (may run past the end of the line for regex matches)
+    };
+
+    // Where a replace_lines() call changed the list, for model updates.
+    struct Splice {
+        size_t at;
+        size_t removed;
+        size_t inserted;
+    };
+
+    const std::vector<Hit>& hits() const { return hits_; }
+    size_t size() const { return hits_.size(); }
+    bool empty() const { return hits_.empty(); }
+    const Hit& operator[](size_t i) const { return hits_[i]; }
+    size_t memory_bytes() const { return hits_.capacity() * sizeof(Hit); }
+
+    void clear();
+
+    // Appends hits that follow all existing ones (streaming a full scan).
+    void append(const std::vector<Hit>& hits);
+
+    // Lines [line, line + old_lines) were replaced by [line, line + new_lines);
+    // hits are the matches found in the new lines.
+    Splice replace_lines(int line, int old_lines, int new_lines, std::vector<Hit> hits);
+
+    // First hit on or after line.
+    size_t lower_bound(int line) const;
+
+    // Finds matches in text whose first byte starts line first_line and calls
+    // cb for each, in order; cb returns false to stop. Thread-safe.
+    static void scan(const TextMatcher& matcher, const char* data, size_t len, int first_line,
+                     const std::function<bool(const Hit&)>& cb, GCancellable* cancel);
+
+private:
+    std::vector<Hit> hits_;
+};
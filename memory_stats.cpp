@@ -0,0 +1,59 @@
+// memory_stats.cpp — process memory figures for the diagnostics window
+
+#include "memory_stats.h"
+
+#include <cstdio>
+#include <unistd.h>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+ProcessMemory process_memory() {
+    ProcessMemory m;
+
+    if (FILE* f = std::fopen("/proc/self/statm", "r")) {
+        unsigned long size = 0, resident = 0;
+        if (std::fscanf(f, "%lu %lu", &size, &resident) == 2)
+            m.rss = (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+        std::fclose(f);
+    }
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    const struct mallinfo2 mi = mallinfo2();
+    m.heap_known = true;
+    m.heap_arena = mi.arena;
+    m.heap_mmap = mi.hblkhd;
+    m.heap_in_use = mi.uordblks + mi.hblkhd;
+    m.heap_free = mi.fordblks;
+#elif defined(__GLIBC__)
+    // the int fields wrap past 2 GB; better than nothing on old glibc
+    const struct mallinfo mi = mallinfo();
+    m.heap_known = true;
+    m.heap_arena = (unsigned)mi.arena;
+    m.heap_mmap = (unsigned)mi.hblkhd;
+    m.heap_in_use = (size_t)(unsigned)mi.uordblks + (unsigned)mi.hblkhd;
+    m.heap_free = (unsigned)mi.fordblks;
+#endif
+    return m;
+}
+
+void trim_heap() {
+#if defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+}
+
+std::string format_bytes(size_t bytes) {
+    static const char* const units[] = { "B", "KB", "MB", "GB", "TB" };
+    double v = (double)bytes;
+    size_t u = 0;
+    while (v >= 1024.0 && u + 1 < sizeof units / sizeof units[0]) {
+        v /= 1024.0;
+        ++u;
+    }
+    char buf[32];
+    if (u == 0) std::snprintf(buf, sizeof buf, "%zu B", bytes);
+    else std::snprintf(buf, sizeof buf, "%.1f %s", v, units[u]);
+    return buf;
+}
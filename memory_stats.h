@@ -0,0 +1,23 @@
+// memory_stats.h — process memory figures for the diagnostics window
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+struct ProcessMemory {
+    size_t rss = 0;             // resident set, from /proc/self/statm
+    bool heap_known = false;    // malloc statistics available (glibc)
+    size_t heap_arena = 0;      // bytes obtained with brk/sbrk
+    size_t heap_mmap = 0;       // bytes in mmap'd chunks
+    size_t heap_in_use = 0;     // allocated and not freed
+    size_t heap_free = 0;       // freed but still held by malloc
+};
+
+ProcessMemory process_memory();
+
+// Returns freed heap memory to the system where malloc supports it.
+void trim_heap();
+
+// "12.3 MB" style, binary units.
+std::string format_bytes(size_t bytes);
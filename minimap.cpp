@@ -0,0 +1,351 @@
+// minimap.cpp — downsampled overview of the document beside the text view
+
+#include "minimap.h"
+#include "fast_scroll.h"
+
+#include <algorithm>
+#include <string>
+
+namespace {
+
+static const int kTileLines = 256;
+static const int kLinePx = 2;                // vertical pixels per line
+static const int kColumns = 96;              // one pixel per column
+static const int kPadding = 4;
+static const int kWidth = kColumns + 2 * kPadding;
+static const int kTileHeight = kTileLines * kLinePx;
+static const size_t kMaxTiles = 48;          // about 10 MB of surfaces
+
+// colossus-mono: mono-bg-alt, mono-dim, mono-soft
+static const double kBackground[3] = { 0x22 / 255.0, 0x22 / 255.0, 0x22 / 255.0 };
+static const double kInk[3]        = { 0x80 / 255.0, 0x80 / 255.0, 0x80 / 255.0 };
+static const double kViewport[3]   = { 0xB0 / 255.0, 0xB0 / 255.0, 0xB0 / 255.0 };
+
+// Text of one tile's lines (at most kColumns characters each), copied on the
+// UI thread; the surface is filled in on a worker.
+struct MinimapTileJob {
+    GCancellable* cancel = nullptr;
+    size_t index = 0;
+    guint64 gen = 0;
+    int tab_width = 4;
+    std::vector<std::string> lines;
+    cairo_surface_t* surface = nullptr;
+
+    ~MinimapTileJob() {
+        if (surface) cairo_surface_destroy(surface);
+        if (cancel) g_object_unref(cancel);
+    }
+};
+
+static void render_tile_thread(GTask* task, gpointer, gpointer task_data, GCancellable* cancel) {
+    MinimapTileJob* job = static_cast<MinimapTileJob*>(task_data);
+
+    cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, kWidth, kTileHeight);
+    cairo_t* cr = cairo_create(surface);
+    cairo_set_source_rgb(cr, kBackground[0], kBackground[1], kBackground[2]);
+    cairo_paint(cr);
+    cairo_set_source_rgb(cr, kInk[0], kInk[1], kInk[2]);
+
+    // one block per run of non-blank columns; a one-pixel gap between lines
+    const double h = kLinePx > 1 ? kLinePx - 1 : 1;
+    for (size_t i = 0; i < job->lines.size(); ++i) {
+        if (g_cancellable_is_cancelled(cancel)) break;
+        const double y = (double)i * kLinePx;
+        const char* p = job->lines[i].c_str();
+
+        int col = 0, run = -1;
+        for (; *p && col < kColumns; p = g_utf8_next_char(p)) {
+            const bool blank = *p == ' ' || *p == '\t' || *p == '\r';
+            if (blank && run >= 0) {
+                cairo_rectangle(cr, kPadding + run, y, col - run, h);
+                run = -1;
+            } else if (!blank && run < 0) {
+                run = col;
+            }
+            col = *p == '\t' ? (col / job->tab_width + 1) * job->tab_width : col + 1;
+        }
+        if (run >= 0) cairo_rectangle(cr, kPadding + run, y, std::min(col, kColumns) - run, h);
+    }
+    cairo_fill(cr);
+    cairo_destroy(cr);
+
+    job->surface = surface;
+    g_task_return_boolean(task, TRUE);
+}
+
+} // namespace
+
+Minimap::Minimap(GtkSourceView* view) : view_(view) {
+    buffer_ = gtk_text_view_get_buffer(GTK_TEXT_VIEW(view_));
+    vadj_ = gtk_scrollable_get_vadjustment(GTK_SCROLLABLE(view_));
+    g_object_ref(buffer_);
+    g_object_ref(vadj_);
+
+    area_ = gtk_drawing_area_new();
+    g_object_ref_sink(area_);
+    gtk_widget_set_size_request(area_, kWidth, -1);
+    gtk_widget_add_events(area_, GDK_BUTTON_PRESS_MASK | GDK_BUTTON_RELEASE_MASK |
+                                 GDK_POINTER_MOTION_MASK | GDK_SCROLL_MASK | GDK_SMOOTH_SCROLL_MASK);
+
+    g_signal_connect(area_, "draw", G_CALLBACK(Minimap::s_on_draw), this);
+    g_signal_connect(area_, "button-press-event", G_CALLBACK(Minimap::s_on_button_press), this);
+    g_signal_connect(area_, "button-release-event", G_CALLBACK(Minimap::s_on_button_release), this);
+    g_signal_connect(area_, "motion-notify-event", G_CALLBACK(Minimap::s_on_motion), this);
+    g_signal_connect(area_, "scroll-event", G_CALLBACK(Minimap::s_on_scroll), this);
+    g_signal_connect(vadj_, "value-changed", G_CALLBACK(Minimap::s_on_adjustment_changed), this);
+    g_signal_connect(vadj_, "changed", G_CALLBACK(Minimap::s_on_adjustment_changed), this);
+    g_signal_connect(buffer_, "insert-text", G_CALLBACK(Minimap::s_on_before_insert), this);
+    g_signal_connect_after(buffer_, "insert-text", G_CALLBACK(Minimap::s_on_insert_text), this);
+    g_signal_connect(buffer_, "delete-range", G_CALLBACK(Minimap::s_on_before_delete), this);
+    g_signal_connect_after(buffer_, "delete-range", G_CALLBACK(Minimap::s_on_after_delete), this);
+
+    cancel_ = g_cancellable_new();
+    sync_tile_count();
+}
+
+Minimap::~Minimap() {
+    g_cancellable_cancel(cancel_);         // in-flight tiles are dropped on completion
+    g_object_unref(cancel_);
+
+    g_signal_handlers_disconnect_by_data(area_, this);
+    g_signal_handlers_disconnect_by_data(vadj_, this);
+    g_signal_handlers_disconnect_by_data(buffer_, this);
+    for (Tile& t : tiles_) if (t.surface) cairo_surface_destroy(t.surface);
+
+    g_object_unref(area_);
+    g_object_unref(vadj_);
+    g_object_unref(buffer_);
+}
+
+void Minimap::sync_tile_count() {
+    const size_t want = (size_t)(gtk_text_buffer_get_line_count(buffer_) + kTileLines - 1) / kTileLines;
+    for (size_t i = want; i < tiles_.size(); ++i) drop_surface(tiles_[i]);
+    const size_t had = tiles_.size();
+    tiles_.resize(want);
+    for (size_t i = had; i < want; ++i) tiles_[i].gen = next_gen_++;
+}
+
+void Minimap::invalidate() {
+    for (Tile& t : tiles_) t.gen = next_gen_++;
+    gtk_widget_queue_draw(area_);
+}
+
+void Minimap::trim() {
+    for (Tile& t : tiles_) drop_surface(t);
+    gtk_widget_queue_draw(area_);
+}
+
+void Minimap::drop_surface(Tile& tile) {
+    if (!tile.surface) return;
+    cairo_surface_destroy(tile.surface);
+    tile.surface = nullptr;
+    tile.surface_gen = 0;
+    --surfaces_;
+}
+
+// Least recently drawn first; what is on screen was drawn last.
+void Minimap::evict() {
+    while (surfaces_ > kMaxTiles) {
+        Tile* lru = nullptr;
+        for (Tile& t : tiles_)
+            if (t.surface && (!lru || t.used < lru->used)) lru = &t;
+        if (!lru) break;
+        drop_surface(*lru);
+    }
+}
+
+size_t Minimap::memory_bytes() const {
+    size_t n = tiles_.capacity() * sizeof(Tile);
+    for (const Tile& t : tiles_)
+        if (t.surface) n += (size_t)cairo_image_surface_get_stride(t.surface) * kTileHeight;
+    return n;
+}
+
+// Lines [line, line + old_lines) became [line, line + new_lines).
+void Minimap::lines_changed(int line, int old_lines, int new_lines) {
+    sync_tile_count();
+
+    const size_t first = (size_t)(line / kTileLines);
+    // a changed line count shifts everything below; those tiles keep showing
+    // their old picture until they are on screen and re-rendered
+    const size_t last = old_lines == new_lines ? (size_t)((line + new_lines - 1) / kTileLines) + 1 : tiles_.size();
+    for (size_t i = first; i < std::min(last, tiles_.size()); ++i) tiles_[i].gen = next_gen_++;
+    gtk_widget_queue_draw(area_);
+}
+
+void Minimap::request_tile(size_t index) {
+    Tile& tile = tiles_[index];
+    if (tile.busy || (tile.surface && tile.surface_gen == tile.gen)) return;
+    tile.busy = true;
+
+    MinimapTileJob* job = new MinimapTileJob;
+    job->cancel = G_CANCELLABLE(g_object_ref(cancel_));
+    job->index = index;
+    job->gen = tile.gen;
+    job->tab_width = (int)gtk_source_view_get_tab_width(view_);
+
+    const int first = (int)index * kTileLines;
+    const int last = std::min<int>(first + kTileLines, gtk_text_buffer_get_line_count(buffer_));
+    job->lines.reserve((size_t)(last - first));
+    for (int line = first; line < last; ++line) {
+        GtkTextIter s, e;
+        gtk_text_buffer_get_iter_at_line(buffer_, &s, line);
+        e = s;
+        // only what fits is copied, however long the line
+        if (!gtk_text_iter_ends_line(&e)) {
+            gtk_text_iter_forward_chars(&e, kColumns);
+            if (gtk_text_iter_get_line(&e) != line) {
+                e = s;
+                gtk_text_iter_forward_to_line_end(&e);
+            }
+        }
+        gchar* text = gtk_text_buffer_get_slice(buffer_, &s, &e, FALSE);
+        job->lines.emplace_back(text);
+        g_free(text);
+    }
+
+    GTask* task = g_task_new(nullptr, cancel_, Minimap::s_on_tile_done, this);
+    g_task_set_task_data(task, job, [](gpointer p) { delete static_cast<MinimapTileJob*>(p); });
+    g_task_run_in_thread(task, render_tile_thread);
+    g_object_unref(task);
+}
+
+// How far the minimap itself is scrolled: it tracks the view proportionally
+// once the document is taller than the widget.
+double Minimap::scroll_offset(int height) const {
+    const double total = (double)gtk_text_buffer_get_line_count(buffer_) * kLinePx;
+    if (total <= height) return 0;
+    const double range = gtk_adjustment_get_upper(vadj_) - gtk_adjustment_get_page_size(vadj_);
+    const double frac = range > 0 ? gtk_adjustment_get_value(vadj_) / range : 0;
+    return frac * (total - height);
+}
+
+void Minimap::scroll_to_y(double y) {
+    const int height = gtk_widget_get_allocated_height(area_);
+    const int lines = gtk_text_buffer_get_line_count(buffer_);
+    const int line = std::max(0, std::min(lines - 1, (int)((y + scroll_offset(height)) / kLinePx)));
+
+    fast_scroll_to_line(GTK_TEXT_VIEW(view_), line, 0.5);
+}
+
+gboolean Minimap::s_on_draw(GtkWidget* widget, cairo_t* cr, gpointer ud) {
+    Minimap* self = static_cast<Minimap*>(ud);
+    const int height = gtk_widget_get_allocated_height(widget);
+    const double offset = self->scroll_offset(height);
+
+    cairo_set_source_rgb(cr, kBackground[0], kBackground[1], kBackground[2]);
+    cairo_paint(cr);
+
+    if (!self->tiles_.empty()) {
+        const size_t first = (size_t)(offset / kTileHeight);
+        const size_t last = std::min(self->tiles_.size(), (size_t)((offset + height) / kTileHeight) + 1);
+        for (size_t i = first; i < last; ++i) {
+            self->tiles_[i].used = ++self->clock_;
+            self->request_tile(i);
+            const Tile& tile = self->tiles_[i];
+            if (!tile.surface) continue;
+            cairo_set_source_surface(cr, tile.surface, 0, (double)i * kTileHeight - offset);
+            cairo_paint(cr);
+        }
+    }
+
+    // the part the text view shows
+    GdkRectangle r;
+    GtkTextIter top, bottom;
+    gtk_text_view_get_visible_rect(GTK_TEXT_VIEW(self->view_), &r);
+    gtk_text_view_get_line_at_y(GTK_TEXT_VIEW(self->view_), &top, r.y, nullptr);
+    gtk_text_view_get_line_at_y(GTK_TEXT_VIEW(self->view_), &bottom, r.y + r.height, nullptr);
+    const double y0 = gtk_text_iter_get_line(&top) * kLinePx - offset;
+    const double y1 = (gtk_text_iter_get_line(&bottom) + 1) * kLinePx - offset;
+
+    cairo_rectangle(cr, 0.5, y0 + 0.5, kWidth - 1, std::max(y1 - y0, 2.0) - 1);
+    cairo_set_source_rgba(cr, kViewport[0], kViewport[1], kViewport[2], 0.12);
+    cairo_fill_preserve(cr);
+    cairo_set_source_rgba(cr, kViewport[0], kViewport[1], kViewport[2], 0.5);
+    cairo_set_line_width(cr, 1.0);
+    cairo_stroke(cr);
+    return TRUE;
+}
+
+gboolean Minimap::s_on_button_press(GtkWidget*, GdkEventButton* e, gpointer ud) {
+    Minimap* self = static_cast<Minimap*>(ud);
+    if (e->button != GDK_BUTTON_PRIMARY) return FALSE;
+    self->dragging_ = true;
+    self->scroll_to_y(e->y);
+    return TRUE;
+}
+
+gboolean Minimap::s_on_button_release(GtkWidget*, GdkEventButton* e, gpointer ud) {
+    if (e->button == GDK_BUTTON_PRIMARY) static_cast<Minimap*>(ud)->dragging_ = false;
+    return FALSE;
+}
+
+gboolean Minimap::s_on_motion(GtkWidget*, GdkEventMotion* e, gpointer ud) {
+    Minimap* self = static_cast<Minimap*>(ud);
+    if (!self->dragging_) return FALSE;
+    self->scroll_to_y(e->y);
+    return TRUE;
+}
+
+// wheel over the minimap scrolls the text
+gboolean Minimap::s_on_scroll(GtkWidget*, GdkEventScroll* e, gpointer ud) {
+    Minimap* self = static_cast<Minimap*>(ud);
+    double dy = 0;
+    if (e->direction == GDK_SCROLL_UP) dy = -1;
+    else if (e->direction == GDK_SCROLL_DOWN) dy = 1;
+    else if (e->direction == GDK_SCROLL_SMOOTH) dy = e->delta_y;
+    if (dy == 0) return FALSE;
+
+    const double step = gtk_adjustment_get_page_size(self->vadj_) / 4;
+    gtk_adjustment_set_value(self->vadj_, gtk_adjustment_get_value(self->vadj_) + dy * step);
+    return TRUE;
+}
+
+void Minimap::s_on_adjustment_changed(GtkAdjustment*, gpointer ud) {
+    gtk_widget_queue_draw(static_cast<Minimap*>(ud)->area_);
+}
+
+void Minimap::s_on_before_insert(GtkTextBuffer*, GtkTextIter* at, gchar*, gint, gpointer ud) {
+    static_cast<Minimap*>(ud)->insert_line_ = gtk_text_iter_get_line(at);
+}
+
+void Minimap::s_on_insert_text(GtkTextBuffer*, GtkTextIter* end, gchar*, gint, gpointer ud) {
+    Minimap* self = static_cast<Minimap*>(ud);
+    // the buffer's own line ends, \r and U+2029 as much as \n
+    const int first = self->insert_line_;
+    self->lines_changed(first, 1, gtk_text_iter_get_line(end) - first + 1);
+}
+
+void Minimap::s_on_before_delete(GtkTextBuffer*, GtkTextIter* start, GtkTextIter* end, gpointer ud) {
+    Minimap* self = static_cast<Minimap*>(ud);
+    self->delete_line_ = gtk_text_iter_get_line(start);
+    self->delete_lines_ = gtk_text_iter_get_line(end) - self->delete_line_ + 1;
+}
+
+void Minimap::s_on_after_delete(GtkTextBuffer*, GtkTextIter*, GtkTextIter*, gpointer ud) {
+    Minimap* self = static_cast<Minimap*>(ud);
+    self->lines_changed(self->delete_line_, self->delete_lines_, 1);
+}
+
+void Minimap::s_on_tile_done(GObject*, GAsyncResult* res, gpointer ud) {
+    MinimapTileJob* job = static_cast<MinimapTileJob*>(g_task_get_task_data(G_TASK(res)));
+    if (g_cancellable_is_cancelled(job->cancel)) return;   // minimap gone
+
+    Minimap* self = static_cast<Minimap*>(ud);
+    if (job->index >= self->tiles_.size()) return;
+    Tile& tile = self->tiles_[job->index];
+    tile.busy = false;
+
+    // edited again while rendering: keep what is shown, the next draw asks anew
+    if (job->gen != tile.gen && tile.surface) {
+        gtk_widget_queue_draw(self->area_);
+        return;
+    }
+    if (tile.surface) cairo_surface_destroy(tile.surface);
+    else ++self->surfaces_;
+    tile.surface = job->surface;
+    tile.surface_gen = job->gen;
+    job->surface = nullptr;
+    self->evict();
+    gtk_widget_queue_draw(self->area_);
+}
@@ -0,0 +1,78 @@
+// minimap.h — downsampled overview of the document beside the text view
+
+#pragma once
+
+#include <gtk/gtk.h>
+#include <gtksourceview/gtksource.h>
+#include <cstddef>
+#include <vector>
+
+// Draws every line of the buffer as a couple of pixels of grey blocks. The
+// picture is cut into tiles of a fixed number of lines, each rendered once
+// on a worker thread into an image surface and kept. An edit only
+// invalidates the tiles holding the lines it touched (and, when it adds or
+// removes lines, the ones after it); scrolling just blits what is cached,
+// and only tiles on screen are ever rendered. At most a few dozen tiles
+// are kept, the least recently drawn going first.
+class Minimap {
+public:
+    explicit Minimap(GtkSourceView* view);
+    ~Minimap();
+
+    Minimap(const Minimap&) = delete;
+    Minimap& operator=(const Minimap&) = delete;
+
+    GtkWidget* widget() const { return area_; }
+
+    // Re-renders everything (tab width or other layout change).
+    void invalidate();
+
+    // Drops every rendered tile; those on screen are rendered again.
+    void trim();
+    size_t memory_bytes() const;
+
+private:
+    struct Tile {
+        cairo_surface_t* surface = nullptr;  // may be stale while a newer one renders
+        guint64 surface_gen = 0;
+        guint64 gen = 0;
+        guint64 used = 0;                    // last drawn, for eviction
+        bool busy = false;
+    };
+
+    GtkSourceView* view_ = nullptr;
+    GtkTextBuffer* buffer_ = nullptr;
+    GtkAdjustment* vadj_ = nullptr;
+    GtkWidget* area_ = nullptr;
+
+    std::vector<Tile> tiles_;
+    size_t surfaces_ = 0;                    // tiles holding a surface
+    guint64 clock_ = 0;
+    guint64 next_gen_ = 1;
+    GCancellable* cancel_ = nullptr;
+
+    int insert_line_ = 0;                    // line of the insertion in progress
+    int delete_line_ = 0;                    // span of the deletion in progress
+    int delete_lines_ = 0;
+    bool dragging_ = false;
+
+    void sync_tile_count();
+    void lines_changed(int line, int old_lines, int new_lines);
+    void request_tile(size_t index);
+    void drop_surface(Tile& tile);
+    void evict();
+    double scroll_offset(int height) const;
+    void scroll_to_y(double y);
+
+    static gboolean s_on_draw(GtkWidget*, cairo_t*, gpointer);
+    static gboolean s_on_button_press(GtkWidget*, GdkEventButton*, gpointer);
+    static gboolean s_on_button_release(GtkWidget*, GdkEventButton*, gpointer);
+    static gboolean s_on_motion(GtkWidget*, GdkEventMotion*, gpointer);
+    static gboolean s_on_scroll(GtkWidget*, GdkEventScroll*, gpointer);
+    static void s_on_adjustment_changed(GtkAdjustment*, gpointer);
+    static void s_on_before_insert(GtkTextBuffer*, GtkTextIter*, gchar*, gint, gpointer);
+    static void s_on_insert_text(GtkTextBuffer*, GtkTextIter*, gchar*, gint, gpointer);
+    static void s_on_before_delete(GtkTextBuffer*, GtkTextIter*, GtkTextIter*, gpointer);
+    static void s_on_after_delete(GtkTextBuffer*, GtkTextIter*, GtkTextIter*, gpointer);
+    static void s_on_tile_done(GObject*, GAsyncResult*, gpointer);
+};
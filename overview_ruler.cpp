@@ -0,0 +1,214 @@
+// overview_ruler.cpp — whole-file strip of search hits, modified lines and the cursor
+
+#include "overview_ruler.h"
+#include "fast_scroll.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+static const int kWidth = 14;
+static const int kPadding = 2;               // above and below the track
+static const int kModifiedX = 2;             // modified lines: left column
+static const int kModifiedW = 3;
+static const int kHitX = 6;                  // search hits: right column
+static const int kHitW = 6;
+static const int kMarkPx = 2;                // shortest marker drawn
+
+// colossus-mono: mono-bg-alt, mono-dim, mono-bright, mono-fg
+static const double kBackground[3] = { 0x22 / 255.0, 0x22 / 255.0, 0x22 / 255.0 };
+static const double kModified[3]   = { 0x80 / 255.0, 0x80 / 255.0, 0x80 / 255.0 };
+static const double kHit[3]        = { 0xD0 / 255.0, 0xD0 / 255.0, 0xD0 / 255.0 };
+static const double kCursor[3]     = { 0xFF / 255.0, 0xFF / 255.0, 0xFF / 255.0 };
+
+} // namespace
+
+OverviewRuler::OverviewRuler(GtkSourceView* view, const MatchIndex* hits) : view_(view), hits_(hits) {
+    buffer_ = gtk_text_view_get_buffer(GTK_TEXT_VIEW(view_));
+    g_object_ref(buffer_);
+
+    area_ = gtk_drawing_area_new();
+    g_object_ref_sink(area_);
+    gtk_widget_set_size_request(area_, kWidth, -1);
+    gtk_widget_add_events(area_, GDK_BUTTON_PRESS_MASK | GDK_BUTTON1_MOTION_MASK);
+
+    g_signal_connect(area_, "draw", G_CALLBACK(OverviewRuler::s_on_draw), this);
+    g_signal_connect(area_, "button-press-event", G_CALLBACK(OverviewRuler::s_on_button_press), this);
+    g_signal_connect(area_, "motion-notify-event", G_CALLBACK(OverviewRuler::s_on_motion), this);
+    g_signal_connect(buffer_, "notify::cursor-position", G_CALLBACK(OverviewRuler::s_on_cursor_notify), this);
+    g_signal_connect(buffer_, "insert-text", G_CALLBACK(OverviewRuler::s_on_before_insert), this);
+    g_signal_connect_after(buffer_, "insert-text", G_CALLBACK(OverviewRuler::s_on_insert_text), this);
+    g_signal_connect(buffer_, "delete-range", G_CALLBACK(OverviewRuler::s_on_before_delete), this);
+    g_signal_connect_after(buffer_, "delete-range", G_CALLBACK(OverviewRuler::s_on_after_delete), this);
+}
+
+OverviewRuler::~OverviewRuler() {
+    g_signal_handlers_disconnect_by_data(area_, this);
+    g_signal_handlers_disconnect_by_data(buffer_, this);
+    g_object_unref(area_);
+    g_object_unref(buffer_);
+}
+
+void OverviewRuler::hits_reset() {
+    buckets_valid_ = false;
+    gtk_widget_queue_draw(area_);
+}
+
+void OverviewRuler::hits_appended(size_t from) {
+    if (buckets_valid_ && bucket_lines_ == gtk_text_buffer_get_line_count(buffer_))
+        count_hits(from, hits_->size(), bucket_lines_, (int)buckets_.size());
+    else
+        buckets_valid_ = false;
+    gtk_widget_queue_draw(area_);
+}
+
+void OverviewRuler::hits_changed(int line, int old_lines, int new_lines) {
+    const int lines = gtk_text_buffer_get_line_count(buffer_);
+    const int height = (int)buckets_.size();
+
+    // a changed line count moves every line to another pixel: rebuilt on draw
+    if (!buckets_valid_ || old_lines != new_lines || bucket_lines_ != lines || height == 0) {
+        buckets_valid_ = false;
+        gtk_widget_queue_draw(area_);
+        return;
+    }
+
+    // recount just the rows holding the rescanned lines
+    const int b0 = bucket_of(line, lines, height);
+    const int b1 = bucket_of(line + new_lines - 1, lines, height);
+    const int first = (int)(((gint64)b0 * lines + height - 1) / height);
+    const int end = (int)(((gint64)(b1 + 1) * lines + height - 1) / height);
+    std::fill(buckets_.begin() + b0, buckets_.begin() + b1 + 1, 0u);
+    count_hits(hits_->lower_bound(first), hits_->lower_bound(end), lines, height);
+    gtk_widget_queue_draw(area_);
+}
+
+void OverviewRuler::clear_modified() {
+    modified_.clear();
+    gtk_widget_queue_draw(area_);
+}
+
+LineSet OverviewRuler::take_modified() {
+    LineSet lines = std::move(modified_);
+    modified_ = LineSet();
+    gtk_widget_queue_draw(area_);
+    return lines;
+}
+
+void OverviewRuler::restore_modified(LineSet lines) {
+    modified_ = std::move(lines);
+    gtk_widget_queue_draw(area_);
+}
+
+size_t OverviewRuler::memory_bytes() const {
+    return buckets_.capacity() * sizeof(guint32) + modified_.memory_bytes();
+}
+
+int OverviewRuler::track_height() const {
+    return std::max(1, gtk_widget_get_allocated_height(area_) - 2 * kPadding);
+}
+
+int OverviewRuler::bucket_of(int line, int lines, int height) const {
+    line = std::max(0, std::min(line, lines - 1));   // stale hits past the end
+    return (int)((gint64)line * height / lines);
+}
+
+void OverviewRuler::rebuild_buckets(int lines, int height) {
+    buckets_.assign((size_t)height, 0u);
+    bucket_lines_ = lines;
+    buckets_valid_ = true;
+    count_hits(0, hits_->size(), lines, height);
+}
+
+void OverviewRuler::count_hits(size_t from, size_t to, int lines, int height) {
+    for (size_t i = from; i < to; ++i) ++buckets_[(size_t)bucket_of((*hits_)[i].line, lines, height)];
+}
+
+void OverviewRuler::scroll_to_y(double y) {
+    const int lines = gtk_text_buffer_get_line_count(buffer_);
+    const int line = std::max(0, std::min(lines - 1, (int)((y - kPadding) * lines / track_height())));
+
+    fast_scroll_to_line(GTK_TEXT_VIEW(view_), line, 0.5);
+}
+
+gboolean OverviewRuler::s_on_draw(GtkWidget*, cairo_t* cr, gpointer ud) {
+    OverviewRuler* self = static_cast<OverviewRuler*>(ud);
+    const int lines = gtk_text_buffer_get_line_count(self->buffer_);
+    const int height = self->track_height();
+
+    cairo_set_source_rgb(cr, kBackground[0], kBackground[1], kBackground[2]);
+    cairo_paint(cr);
+
+    auto y_of = [&](gint64 line) { return kPadding + (double)(line * height / lines); };
+
+    // modified lines, merged at the ruler's resolution
+    const int gap = std::max(1, lines / height);
+    for (const LineSet::Range& r : self->modified_.ranges(gap)) {
+        const double y0 = y_of(r.first);
+        cairo_rectangle(cr, kModifiedX, y0, kModifiedW, std::max(y_of(r.second) - y0, (double)kMarkPx));
+    }
+    cairo_set_source_rgb(cr, kModified[0], kModified[1], kModified[2]);
+    cairo_fill(cr);
+
+    // search hits: one rectangle per run of non-empty rows
+    if (!self->buckets_valid_ || self->bucket_lines_ != lines || (int)self->buckets_.size() != height)
+        self->rebuild_buckets(lines, height);
+    const std::vector<guint32>& b = self->buckets_;
+    for (size_t i = 0; i < b.size(); ++i) {
+        if (!b[i]) continue;
+        size_t j = i + 1;
+        while (j < b.size() && b[j]) ++j;
+        cairo_rectangle(cr, kHitX, kPadding + (double)i, kHitW, std::max<double>((double)(j - i), kMarkPx));
+        i = j;
+    }
+    cairo_set_source_rgb(cr, kHit[0], kHit[1], kHit[2]);
+    cairo_fill(cr);
+
+    // cursor
+    GtkTextIter it;
+    gtk_text_buffer_get_iter_at_mark(self->buffer_, &it, gtk_text_buffer_get_insert(self->buffer_));
+    cairo_rectangle(cr, 0, y_of(gtk_text_iter_get_line(&it)) - 1, kWidth, kMarkPx);
+    cairo_set_source_rgb(cr, kCursor[0], kCursor[1], kCursor[2]);
+    cairo_fill(cr);
+    return TRUE;
+}
+
+gboolean OverviewRuler::s_on_button_press(GtkWidget*, GdkEventButton* e, gpointer ud) {
+    if (e->button != GDK_BUTTON_PRIMARY) return FALSE;
+    static_cast<OverviewRuler*>(ud)->scroll_to_y(e->y);
+    return TRUE;
+}
+
+gboolean OverviewRuler::s_on_motion(GtkWidget*, GdkEventMotion* e, gpointer ud) {
+    static_cast<OverviewRuler*>(ud)->scroll_to_y(e->y);
+    return TRUE;
+}
+
+void OverviewRuler::s_on_cursor_notify(GObject*, GParamSpec*, gpointer ud) {
+    gtk_widget_queue_draw(static_cast<OverviewRuler*>(ud)->area_);
+}
+
+void OverviewRuler::s_on_before_insert(GtkTextBuffer*, GtkTextIter* at, gchar*, gint, gpointer ud) {
+    static_cast<OverviewRuler*>(ud)->insert_line_ = gtk_text_iter_get_line(at);
+}
+
+void OverviewRuler::s_on_insert_text(GtkTextBuffer*, GtkTextIter* end, gchar*, gint, gpointer ud) {
+    OverviewRuler* self = static_cast<OverviewRuler*>(ud);
+    // the buffer's own line ends, \r and U+2029 as much as \n
+    const int first = self->insert_line_;
+    self->modified_.lines_changed(first, 1, gtk_text_iter_get_line(end) - first + 1);
+    gtk_widget_queue_draw(self->area_);
+}
+
+void OverviewRuler::s_on_before_delete(GtkTextBuffer*, GtkTextIter* start, GtkTextIter* end, gpointer ud) {
+    OverviewRuler* self = static_cast<OverviewRuler*>(ud);
+    self->delete_line_ = gtk_text_iter_get_line(start);
+    self->delete_lines_ = gtk_text_iter_get_line(end) - self->delete_line_ + 1;
+}
+
+void OverviewRuler::s_on_after_delete(GtkTextBuffer*, GtkTextIter*, GtkTextIter*, gpointer ud) {
+    OverviewRuler* self = static_cast<OverviewRuler*>(ud);
+    self->modified_.lines_changed(self->delete_line_, self->delete_lines_, 1);
+    gtk_widget_queue_draw(self->area_);
+}
@@ -0,0 +1,75 @@
+// overview_ruler.h — whole-file strip of search hits, modified lines and the cursor
+
+#pragma once
+
+#include <gtk/gtk.h>
+#include <gtksourceview/gtksource.h>
+#include <cstddef>
+#include <vector>
+
+#include "line_set.h"
+#include "match_index.h"
+
+// A narrow strip beside the vertical scrollbar that maps the whole document
+// onto its height. Search hits are counted into one bucket per pixel row, so
+// drawing costs O(height) however many hits there are; the buckets are kept
+// up to date from the match index's own edits and only rebuilt (one pass over
+// the hits) when the line count or the height changes. Modified lines come
+// from a LineSet fed by the buffer's edits and cleared on load and save;
+// a tab switch takes it along with the document.
+class OverviewRuler {
+public:
+    OverviewRuler(GtkSourceView* view, const MatchIndex* hits);
+    ~OverviewRuler();
+
+    OverviewRuler(const OverviewRuler&) = delete;
+    OverviewRuler& operator=(const OverviewRuler&) = delete;
+
+    GtkWidget* widget() const { return area_; }
+
+    // The match index was cleared or replaced.
+    void hits_reset();
+    // Hits [from, size()) were appended.
+    void hits_appended(size_t from);
+    // MatchIndex::replace_lines(line, old_lines, new_lines, ...) just ran.
+    void hits_changed(int line, int old_lines, int new_lines);
+
+    // The buffer now matches the file on disk.
+    void clear_modified();
+    // The modified lines of a document going to the background, and back
+    // once it is shown again.
+    LineSet take_modified();
+    void restore_modified(LineSet lines);
+
+    size_t memory_bytes() const;
+
+private:
+    GtkSourceView* view_ = nullptr;
+    GtkTextBuffer* buffer_ = nullptr;
+    GtkWidget* area_ = nullptr;
+    const MatchIndex* hits_ = nullptr;
+
+    std::vector<guint32> buckets_;           // hits per pixel row
+    int bucket_lines_ = -1;                  // line count the buckets were made for
+    bool buckets_valid_ = false;
+
+    LineSet modified_;
+    int insert_line_ = 0;                    // line of the insertion in progress
+    int delete_line_ = 0;                    // span of the deletion in progress
+    int delete_lines_ = 0;
+
+    int track_height() const;
+    int bucket_of(int line, int lines, int height) const;
+    void rebuild_buckets(int lines, int height);
+    void count_hits(size_t from, size_t to, int lines, int height);
+    void scroll_to_y(double y);
+
+    static gboolean s_on_draw(GtkWidget*, cairo_t*, gpointer);
+    static gboolean s_on_button_press(GtkWidget*, GdkEventButton*, gpointer);
+    static gboolean s_on_motion(GtkWidget*, GdkEventMotion*, gpointer);
+    static void s_on_cursor_notify(GObject*, GParamSpec*, gpointer);
+    static void s_on_before_insert(GtkTextBuffer*, GtkTextIter*, gchar*, gint, gpointer);
+    static void s_on_insert_text(GtkTextBuffer*, GtkTextIter*, gchar*, gint, gpointer);
+    static void s_on_before_delete(GtkTextBuffer*, GtkTextIter*, GtkTextIter*, gpointer);
+    static void s_on_after_delete(GtkTextBuffer*, GtkTextIter*, GtkTextIter*, gpointer);
+};
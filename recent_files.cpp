@@ -0,0 +1,127 @@
+// recent_files.cpp — the editor's own list of recently opened files
+
+#include "recent_files.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+static const size_t kMaxFiles = 30;
+static const guint kSaveDelayMs = 500;
+
+struct RecentSaveJob {
+    RecentFiles* store;
+    guint64 seq;
+    std::string text;
+};
+
+static void push_front_unique(std::vector<std::string>& list, const std::string& path) {
+    list.erase(std::remove(list.begin(), list.end(), path), list.end());
+    list.insert(list.begin(), path);
+    if (list.size() > kMaxFiles) list.resize(kMaxFiles);
+}
+
+} // namespace
+
+RecentFiles::RecentFiles(std::string file) : file_(std::move(file)) {
+    g_mutex_init(&write_lock_);
+}
+
+const std::vector<std::string>& RecentFiles::paths() {
+    load();
+    return paths_;
+}
+
+void RecentFiles::add(const std::string& path) {
+    if (path.empty() || path.find('\n') != std::string::npos) return;
+    push_front_unique(loaded_ ? paths_ : added_, path);
+    ++serial_;
+    schedule_save();
+}
+
+void RecentFiles::load() {
+    if (loaded_) return;
+    loaded_ = true;
+
+    gchar* data = nullptr;
+    gsize len = 0;
+    if (g_file_get_contents(file_.c_str(), &data, &len, nullptr)) {
+        const char* p = data;
+        const char* end = data + len;
+        while (p < end && paths_.size() < kMaxFiles) {
+            const char* nl = static_cast<const char*>(std::memchr(p, '\n', (size_t)(end - p)));
+            const char* stop = nl ? nl : end;
+            std::string path(p, stop);
+            if (!path.empty() && std::find(paths_.begin(), paths_.end(), path) == paths_.end())
+                paths_.push_back(std::move(path));
+            p = stop + 1;
+        }
+        g_free(data);
+    }
+
+    // what was opened meanwhile is newer than anything on disk
+    for (auto it = added_.rbegin(); it != added_.rend(); ++it) push_front_unique(paths_, *it);
+    added_.clear();
+    added_.shrink_to_fit();
+}
+
+std::string RecentFiles::contents() const {
+    std::string text;
+    for (const std::string& p : paths_) {
+        text += p;
+        text += '\n';
+    }
+    return text;
+}
+
+// On a worker thread, or on the UI thread from flush().
+void RecentFiles::write(guint64 seq, const std::string& text) {
+    g_mutex_lock(&write_lock_);
+    if (seq > written_) {
+        gchar* dir = g_path_get_dirname(file_.c_str());
+        g_mkdir_with_parents(dir, 0755);
+        g_free(dir);
+        g_file_set_contents(file_.c_str(), text.data(), (gssize)text.size(), nullptr);
+        written_ = seq;
+    }
+    g_mutex_unlock(&write_lock_);
+}
+
+void RecentFiles::schedule_save() {
+    if (!save_id_) save_id_ = g_timeout_add(kSaveDelayMs, RecentFiles::s_on_save, this);
+}
+
+void RecentFiles::flush() {
+    if (!save_id_ && !jobs_) return;
+    if (save_id_) g_source_remove(save_id_);
+    save_id_ = 0;
+    // supersedes any write still queued
+    load();
+    write(next_write_++, contents());
+}
+
+gboolean RecentFiles::s_on_save(gpointer ud) {
+    RecentFiles* self = static_cast<RecentFiles*>(ud);
+    self->save_id_ = 0;
+    self->load();
+
+    RecentSaveJob* job = new RecentSaveJob{ self, self->next_write_++, self->contents() };
+    ++self->jobs_;
+    GTask* task = g_task_new(nullptr, nullptr, RecentFiles::s_on_saved, self);
+    g_task_set_task_data(task, job, [](gpointer p) { delete static_cast<RecentSaveJob*>(p); });
+    g_task_run_in_thread(task, RecentFiles::s_save_thread);
+    g_object_unref(task);
+    return G_SOURCE_REMOVE;
+}
+
+void RecentFiles::s_save_thread(GTask* task, gpointer, gpointer task_data, GCancellable*) {
+    RecentSaveJob* job = static_cast<RecentSaveJob*>(task_data);
+    job->store->write(job->seq, job->text);
+    g_task_return_boolean(task, TRUE);
+}
+
+void RecentFiles::s_on_saved(GObject*, GAsyncResult*, gpointer ud) {
+    --static_cast<RecentFiles*>(ud)->jobs_;
+}
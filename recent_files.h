@@ -0,0 +1,56 @@
+// recent_files.h — the editor's own list of recently opened files
+
+#pragma once
+
+#include <gio/gio.h>
+#include <string>
+#include <vector>
+
+// A short most-recently-used list, newest first, kept in a small file of
+// its own (one path per line) instead of the desktop-wide
+// recently-used.xbel, which can hold thousands of entries and is watched
+// for changes. Nothing is read until the list is first asked for; files
+// added before then are merged in front of what the file holds. Changes
+// are written a moment later on a worker thread, so a burst of opens
+// costs one write; flush() writes whatever is still pending, at exit.
+//
+// Meant to live as long as the process: a write in flight refers to it.
+class RecentFiles {
+public:
+    explicit RecentFiles(std::string file);
+
+    RecentFiles(const RecentFiles&) = delete;
+    RecentFiles& operator=(const RecentFiles&) = delete;
+
+    // Newest first; reads the file on first use.
+    const std::vector<std::string>& paths();
+    void add(const std::string& path);
+
+    // Changes with every add, so menus know when to rebuild.
+    guint64 serial() const { return serial_; }
+
+    void flush();
+
+private:
+    std::string file_;
+    std::vector<std::string> paths_;
+    std::vector<std::string> added_;         // before the file was read, newest first
+    bool loaded_ = false;
+    guint64 serial_ = 1;
+    guint save_id_ = 0;
+    int jobs_ = 0;                           // writes in flight
+
+    // writes are numbered; an older one never replaces a newer file
+    GMutex write_lock_;
+    guint64 next_write_ = 1;
+    guint64 written_ = 0;
+
+    void load();
+    void schedule_save();
+    std::string contents() const;
+    void write(guint64 seq, const std::string& text);
+
+    static gboolean s_on_save(gpointer);
+    static void s_save_thread(GTask*, gpointer, gpointer, GCancellable*);
+    static void s_on_saved(GObject*, GAsyncResult*, gpointer);
+};
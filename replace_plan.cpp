@@ -0,0 +1,133 @@
+// replace_plan.cpp — Replace All preview computed off the UI thread
+
+#include "replace_plan.h"
+#include "text_search.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+// shown in place of newlines inside a one-line preview
+static const char kReturnSymbol[] = "\xe2\x86\xb5";   // U+21B5
+
+static void append_display(std::string& out, const char* p, size_t len, size_t max_bytes) {
+    for (size_t i = 0; i < len && out.size() < max_bytes; ++i) {
+        if (p[i] == '\n') out += kReturnSymbol;
+        else if (p[i] == '\t') out += ' ';
+        else if (p[i] != '\r') out += p[i];
+    }
+}
+
+static std::string make_valid(std::string s) {
+    if (g_utf8_validate(s.c_str(), (gssize)s.size(), nullptr)) return s;
+    gchar* fixed = g_utf8_make_valid(s.c_str(), (gssize)s.size());
+    std::string out = fixed;
+    g_free(fixed);
+    return out;
+}
+
+} // namespace
+
+size_t ReplacePlan::memory_bytes() const {
+    size_t n = text_.capacity() + edits_.capacity() * sizeof(Edit) + hunks_.capacity() * sizeof(Hunk);
+    for (const Edit& e : edits_) n += e.text.capacity();
+    return n;
+}
+
+void ReplacePlan::clear() {
+    std::string().swap(text_);
+    std::vector<Edit>().swap(edits_);
+    std::vector<Hunk>().swap(hunks_);
+    error_.clear();
+}
+
+bool ReplacePlan::compute(std::string text,
+                          const std::string& query, bool case_sensitive, bool regex,
+                          const std::string& repl,
+                          GCancellable* cancel) {
+    clear();
+    text_ = std::move(text);
+
+    TextMatcher matcher(query, case_sensitive, regex);
+    if (!matcher.valid()) {
+        error_ = matcher.error().empty() ? "nothing to replace" : matcher.error();
+        return false;
+    }
+
+    const char* data = text_.data();
+    const size_t len = text_.size();
+
+    int line = 0;
+    size_t counted_to = 0;
+
+    matcher.find_all(data, len, [&](size_t s, size_t e) {
+        line += (int)std::count(data + counted_to, data + s, '\n');
+        counted_to = s;
+
+        const uint32_t id = (uint32_t)edits_.size();
+        edits_.push_back(Edit{ s, e, regex ? matcher.expand(data, len, s, e, repl) : repl });
+
+        // extend the previous hunk when this match starts on a line it covers
+        if (!hunks_.empty() && s <= hunks_.back().end) {
+            Hunk& h = hunks_.back();
+            h.n_edits++;
+            if (e > h.end) {
+                const char* nl = (const char*)std::memchr(data + e, '\n', len - e);
+                h.end = nl ? (size_t)(nl - data) : len;
+            }
+            return true;
+        }
+
+        size_t b = s;
+        while (b > 0 && data[b - 1] != '\n') --b;
+        const char* nl = (const char*)std::memchr(data + e, '\n', len - e);
+        hunks_.push_back(Hunk{ line, b, nl ? (size_t)(nl - data) : len, id, 1, true });
+        return true;
+    }, cancel);
+
+    if (cancel && g_cancellable_is_cancelled(cancel)) {
+        clear();
+        error_ = "cancelled";
+        return false;
+    }
+    return true;
+}
+
+void ReplacePlan::set_accepted(size_t hunk, bool accepted) {
+    if (hunk < hunks_.size()) hunks_[hunk].accepted = accepted;
+}
+
+void ReplacePlan::set_all_accepted(bool accepted) {
+    for (Hunk& h : hunks_) h.accepted = accepted;
+}
+
+size_t ReplacePlan::accepted_edits() const {
+    size_t n = 0;
+    for (const Hunk& h : hunks_) if (h.accepted) n += h.n_edits;
+    return n;
+}
+
+std::string ReplacePlan::before(size_t hunk, size_t max_bytes) const {
+    if (hunk >= hunks_.size()) return std::string();
+    const Hunk& h = hunks_[hunk];
+    std::string out;
+    append_display(out, text_.data() + h.begin, h.end - h.begin, max_bytes);
+    return make_valid(std::move(out));
+}
+
+std::string ReplacePlan::after(size_t hunk, size_t max_bytes) const {
+    if (hunk >= hunks_.size()) return std::string();
+    const Hunk& h = hunks_[hunk];
+    std::string out;
+    size_t at = h.begin;
+    for (uint32_t i = h.first_edit; i < h.first_edit + h.n_edits && out.size() < max_bytes; ++i) {
+        const Edit& ed = edits_[i];
+        append_display(out, text_.data() + at, ed.start - at, max_bytes);
+        append_display(out, ed.text.data(), ed.text.size(), max_bytes);
+        at = ed.end;
+    }
+    append_display(out, text_.data() + at, h.end - at, max_bytes);
+    return make_valid(std::move(out));
+}
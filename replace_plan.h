@@ -0,0 +1,63 @@
+// replace_plan.h — Replace All preview computed off the UI thread
+
+#pragma once
+
+#include <gio/gio.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Every replacement a Replace All would make, grouped into hunks of whole
+// lines so each affected line (or run of lines, for multi-line regex
+// matches) can be reviewed and accepted or rejected on its own.
+// Offsets are bytes into the snapshot the plan was computed from.
+class ReplacePlan {
+public:
+    struct Edit {
+        size_t start;
+        size_t end;
+        std::string text;          // replacement, with regex references expanded
+    };
+
+    struct Hunk {
+        int line;                  // 0-based line of begin
+        size_t begin;              // start of the first line
+        size_t end;                // end of the last line (before its newline)
+        uint32_t first_edit;
+        uint32_t n_edits;
+        bool accepted;
+    };
+
+    // Scans text for query and records one edit per match. Blocking; meant
+    // for a worker thread. Returns false (with error set) if the pattern is
+    // invalid or cancel fired.
+    bool compute(std::string text,
+                 const std::string& query, bool case_sensitive, bool regex,
+                 const std::string& repl,
+                 GCancellable* cancel);
+
+    void clear();
+    bool empty() const { return hunks_.empty(); }
+
+    const std::string& text() const { return text_; }
+    const std::vector<Edit>& edits() const { return edits_; }
+    const std::vector<Hunk>& hunks() const { return hunks_; }
+    const std::string& error() const { return error_; }
+    size_t memory_bytes() const;
+
+    void set_accepted(size_t hunk, bool accepted);
+    void set_all_accepted(bool accepted);
+    size_t accepted_edits() const;
+
+    // Display strings for a hunk: one line, capped at max_bytes, with
+    // embedded newlines shown as a return symbol.
+    std::string before(size_t hunk, size_t max_bytes) const;
+    std::string after(size_t hunk, size_t max_bytes) const;
+
+private:
+    std::string text_;
+    std::vector<Edit> edits_;
+    std::vector<Hunk> hunks_;
+    std::string error_;
+};
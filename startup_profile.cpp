@@ -0,0 +1,58 @@
+// startup_profile.cpp — per-phase timing of start-up, printed with --startup-profile
+
+#include "startup_profile.h"
+#include "trace.h"
+
+#include <glib.h>
+
+#include <cstdio>
+#include <vector>
+
+namespace startup_profile {
+
+namespace {
+
+struct Phase {
+    const char* name;
+    gint64 start_us;
+    gint64 end_us;
+};
+
+// start-up is single threaded: no locking
+static bool g_on = false;
+static gint64 g_launch_us = 0;
+static gint64 g_last_us = 0;
+static std::vector<Phase> g_phases;
+
+} // namespace
+
+void enable() {
+    if (g_on) return;
+    g_on = true;
+    g_launch_us = g_last_us = g_get_monotonic_time();
+}
+
+bool enabled() { return g_on; }
+
+void mark(const char* phase) {
+    if (!g_on) return;
+    const gint64 now = g_get_monotonic_time();
+    g_phases.push_back(Phase{ phase, g_last_us, now });
+    if (trace::enabled()) trace::record(phase, g_last_us, now);
+    g_last_us = now;
+}
+
+void report() {
+    if (!g_on) return;
+    g_on = false;
+
+    std::fprintf(stderr, "  %-28s %8s %13s\n", "startup phase", "ms", "since launch");
+    for (const Phase& p : g_phases) {
+        std::fprintf(stderr, "  %-28s %8.1f %13.1f\n", p.name,
+                     (p.end_us - p.start_us) / 1000.0, (p.end_us - g_launch_us) / 1000.0);
+    }
+    g_phases.clear();
+    g_phases.shrink_to_fit();
+}
+
+} // namespace startup_profile
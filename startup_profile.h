@@ -0,0 +1,21 @@
+// startup_profile.h — per-phase timing of start-up, printed with --startup-profile
+
+#pragma once
+
+// Each phase of start-up is marked as it ends; the breakdown (time spent
+// in the phase, time since launch) goes to stderr once, after the deferred
+// part of the UI is built. Marks also land in the trace when one is being
+// recorded. While the profile is off a mark is a single branch.
+namespace startup_profile {
+
+// Starts the clock: call as early as possible.
+void enable();
+bool enabled();
+
+// phase must outlive the profile (a string literal).
+void mark(const char* phase);
+
+// Prints the phases marked so far and turns the profile off.
+void report();
+
+} // namespace startup_profile
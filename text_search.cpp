@@ -0,0 +1,160 @@
+// text_search.cpp — thread-safe plain/regex matcher used by background searches
+
+#include "text_search.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace {
+
+// check the cancellable roughly once per this many scanned bytes
+static const size_t kCancelStride = 1 << 20;
+
+static inline char ascii_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+struct FoldHash {
+    size_t operator()(char c) const { return (unsigned char)ascii_lower(c); }
+};
+
+struct FoldEq {
+    bool operator()(char a, char b) const { return ascii_lower(a) == ascii_lower(b); }
+};
+
+static bool is_ascii(const std::string& s) {
+    for (unsigned char c : s) if (c >= 0x80) return false;
+    return true;
+}
+
+} // namespace
+
+TextMatcher::TextMatcher(const std::string& pattern, bool case_sensitive, bool regex)
+    : pattern_(pattern), case_sensitive_(case_sensitive)
+{
+    if (pattern_.empty()) return;
+
+    // Non-ASCII caseless search needs Unicode folding, which GRegex provides.
+    if (regex || (!case_sensitive_ && !is_ascii(pattern_))) {
+        int flags = G_REGEX_MULTILINE | G_REGEX_OPTIMIZE;
+        if (!case_sensitive_) flags |= G_REGEX_CASELESS;
+
+        gchar* escaped = regex ? nullptr : g_regex_escape_string(pattern_.c_str(), -1);
+        GError* err = nullptr;
+        regex_ = g_regex_new(escaped ? escaped : pattern_.c_str(),
+                             (GRegexCompileFlags)flags, (GRegexMatchFlags)0, &err);
+        g_free(escaped);
+
+        if (!regex_) {
+            error_ = err ? err->message : "invalid regular expression";
+            if (err) g_error_free(err);
+            return;
+        }
+        valid_ = true;
+        return;
+    }
+
+    folded_ = pattern_;
+    for (char& c : folded_) c = ascii_lower(c);
+    valid_ = true;
+}
+
+TextMatcher::~TextMatcher() {
+    if (regex_) g_regex_unref(regex_);
+}
+
+size_t TextMatcher::find_all(const char* data, size_t len,
+                             const std::function<bool(size_t, size_t)>& cb,
+                             GCancellable* cancel) const {
+    if (!valid_ || !data || len == 0) return 0;
+
+    size_t count = 0;
+
+    if (regex_) {
+        GMatchInfo* info = nullptr;
+        GError* err = nullptr;
+        g_regex_match_full(regex_, data, (gssize)len, 0, (GRegexMatchFlags)0, &info, &err);
+
+        size_t last_check = 0;
+        while (info && g_match_info_matches(info)) {
+            gint s = 0, e = 0;
+            if (g_match_info_fetch_pos(info, 0, &s, &e) && e > s) {
+                ++count;
+                if (!cb((size_t)s, (size_t)e)) break;
+            }
+            if ((size_t)e - last_check > kCancelStride) {
+                last_check = (size_t)e;
+                if (cancel && g_cancellable_is_cancelled(cancel)) break;
+            }
+            if (!g_match_info_next(info, &err)) break;
+        }
+
+        if (info) g_match_info_free(info);
+        if (err) g_error_free(err);
+        return count;
+    }
+
+    const char* end = data + len;
+    const char* p = data;
+    const size_t plen = pattern_.size();
+    size_t last_check = 0;
+
+    if (case_sensitive_) {
+        while (p < end) {
+            const char* hit = (const char*)memmem(p, (size_t)(end - p), pattern_.data(), plen);
+            if (!hit) break;
+            ++count;
+            size_t s = (size_t)(hit - data);
+            if (!cb(s, s + plen)) break;
+            p = hit + plen;
+            if (s - last_check > kCancelStride) {
+                last_check = s;
+                if (cancel && g_cancellable_is_cancelled(cancel)) break;
+            }
+        }
+        return count;
+    }
+
+    std::boyer_moore_horspool_searcher<std::string::const_iterator, FoldHash, FoldEq>
+        searcher(folded_.begin(), folded_.end(), FoldHash(), FoldEq());
+
+    while (p < end) {
+        // scan in bounded windows so cancellation is noticed on huge inputs
+        const char* window_end = std::min(end, p + kCancelStride + plen);
+        const char* hit = std::search(p, window_end, searcher);
+        if (hit == window_end) {
+            if (window_end == end) break;
+            p = window_end - (plen - 1);
+            if (cancel && g_cancellable_is_cancelled(cancel)) break;
+            continue;
+        }
+        ++count;
+        size_t s = (size_t)(hit - data);
+        if (!cb(s, s + plen)) break;
+        p = hit + plen;
+    }
+    return count;
+}
+
+std::string TextMatcher::expand(const char* data, size_t len,
+                                size_t start, size_t end,
+                                const std::string& repl) const {
+    if (!regex_ || !data) return repl;
+
+    std::string out = repl;
+    GMatchInfo* info = nullptr;
+    if (g_regex_match_full(regex_, data, (gssize)len, (gint)start,
+                           G_REGEX_MATCH_ANCHORED, &info, nullptr)) {
+        gint s = 0, e = 0;
+        if (g_match_info_fetch_pos(info, 0, &s, &e) && (size_t)s == start && (size_t)e == end) {
+            gchar* expanded = g_match_info_expand_references(info, repl.c_str(), nullptr);
+            if (expanded) {
+                out = expanded;
+                g_free(expanded);
+            }
+        }
+    }
+    if (info) g_match_info_free(info);
+    return out;
+}
@@ -0,0 +1,45 @@
+// text_search.h — thread-safe plain/regex matcher used by background searches
+
+#pragma once
+
+#include <gio/gio.h>
+#include <cstddef>
+#include <functional>
+#include <string>
+
+// GtkSourceSearchContext is bound to a buffer and must stay on the main
+// thread. TextMatcher works on raw UTF-8 bytes instead, so workers can scan
+// snapshots and files without touching GTK.
+class TextMatcher {
+public:
+    TextMatcher(const std::string& pattern, bool case_sensitive, bool regex);
+    ~TextMatcher();
+
+    TextMatcher(const TextMatcher&) = delete;
+    TextMatcher& operator=(const TextMatcher&) = delete;
+
+    bool valid() const { return valid_; }
+    const std::string& error() const { return error_; }
+    const std::string& pattern() const { return pattern_; }
+
+    // Calls cb(start, end) with byte offsets for each match in data[0, len).
+    // Stops early when cb returns false or the cancellable fires.
+    // Returns the number of matches reported.
+    size_t find_all(const char* data, size_t len,
+                    const std::function<bool(size_t, size_t)>& cb,
+                    GCancellable* cancel = nullptr) const;
+
+    // Replacement text for the match at data[start, end). For regex searches
+    // this expands \0..\9 and \g<name> references, otherwise returns repl.
+    std::string expand(const char* data, size_t len,
+                       size_t start, size_t end,
+                       const std::string& repl) const;
+
+private:
+    std::string pattern_;
+    std::string folded_;          // lowercase pattern for ASCII caseless search
+    bool case_sensitive_ = false;
+    bool valid_ = false;
+    GRegex* regex_ = nullptr;     // set for regex or non-ASCII caseless search
+    std::string error_;
+};
@@ -0,0 +1,150 @@
+// trace.cpp — scoped timing spans exported as Chrome trace JSON
+
+#include "trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+namespace trace {
+
+std::atomic<bool> g_enabled{ false };
+
+namespace {
+
+static const size_t kRingSize = 8192;   // spans kept per thread
+
+struct Event {
+    const char* name;
+    gint64 start_us;
+    gint64 dur_us;
+};
+
+// Written only by its own thread; head counts every span ever written, so
+// a reader can tell which slots were overwritten while it copied them.
+struct Ring {
+    int tid = 0;
+    std::atomic<guint64> head{ 0 };
+    Event events[kRingSize];
+};
+
+// Worker threads come and go from GLib's pool and their spans must survive
+// them until the next dump, so a ring outlives its thread: on exit it is
+// handed to the next new thread, which carries on writing into it under
+// the same tid. There are never more rings than threads alive at once.
+static std::mutex g_rings_lock;
+static std::vector<Ring*> g_rings;
+static std::vector<Ring*> g_free_rings;
+static gint64 g_epoch_us = 0;
+
+static void release_ring(gpointer ring) {
+    std::lock_guard<std::mutex> lock(g_rings_lock);
+    g_free_rings.push_back(static_cast<Ring*>(ring));
+}
+
+static GPrivate g_ring_key = G_PRIVATE_INIT(release_ring);
+
+static Ring* thread_ring() {
+    static thread_local Ring* ring = nullptr;
+    if (ring) return ring;
+
+    {
+        std::lock_guard<std::mutex> lock(g_rings_lock);
+        if (!g_free_rings.empty()) {
+            ring = g_free_rings.back();
+            g_free_rings.pop_back();
+        } else {
+            ring = new Ring;
+            ring->tid = (int)g_rings.size() + 1;
+            g_rings.push_back(ring);
+        }
+    }
+    g_private_set(&g_ring_key, ring);        // released when the thread exits
+    return ring;
+}
+
+static void append_json_string(std::string& out, const char* s) {
+    out += '"';
+    for (; *s; ++s) {
+        const unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += (char)c;
+        } else if (c < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof buf, "\\u%04x", c);
+            out += buf;
+        } else {
+            out += (char)c;
+        }
+    }
+    out += '"';
+}
+
+} // namespace
+
+void set_enabled(bool on) {
+    if (on && !g_epoch_us) g_epoch_us = g_get_monotonic_time();
+    g_enabled.store(on, std::memory_order_relaxed);
+}
+
+std::string init_from_env() {
+    const char* path = g_getenv("COLOSSUS_TRACE");
+    if (!path || !*path) return "";
+    set_enabled(true);
+    return path;
+}
+
+void record(const char* name, gint64 start_us, gint64 end_us) {
+    Ring* ring = thread_ring();
+    const guint64 h = ring->head.load(std::memory_order_relaxed);
+    ring->events[h % kRingSize] = Event{ name, start_us, end_us - start_us };
+    ring->head.store(h + 1, std::memory_order_release);
+}
+
+bool dump(const std::string& path, std::string* error) {
+    std::vector<Ring*> rings;
+    {
+        std::lock_guard<std::mutex> lock(g_rings_lock);
+        rings = g_rings;
+    }
+
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"COLOSSUS Editor\"}}";
+
+    std::vector<Event> copy;
+    for (Ring* ring : rings) {
+        const guint64 h1 = ring->head.load(std::memory_order_acquire);
+        const guint64 first = h1 > kRingSize ? h1 - kRingSize : 0;
+        copy.clear();
+        for (guint64 i = first; i < h1; ++i) copy.push_back(ring->events[i % kRingSize]);
+
+        // drop whatever the thread overwrote while we were copying, and the
+        // slot at h2, which it may be writing right now
+        const guint64 h2 = ring->head.load(std::memory_order_acquire);
+        const guint64 valid = h2 + 1 > kRingSize ? h2 + 1 - kRingSize : 0;
+        const size_t skip = valid > first ? (size_t)std::min<guint64>(valid - first, copy.size()) : 0;
+
+        for (size_t i = skip; i < copy.size(); ++i) {
+            const Event& e = copy[i];
+            char buf[128];
+            std::snprintf(buf, sizeof buf, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%lld,\"dur\":%lld}",
+                          ring->tid, (long long)(e.start_us - g_epoch_us), (long long)e.dur_us);
+            out += ",\n{\"name\":";
+            append_json_string(out, e.name);
+            out += buf;
+        }
+    }
+    out += "\n]}\n";
+
+    GError* err = nullptr;
+    if (!g_file_set_contents(path.c_str(), out.data(), (gssize)out.size(), &err)) {
+        if (error) *error = err ? err->message : "write failed";
+        if (err) g_error_free(err);
+        return false;
+    }
+    return true;
+}
+
+} // namespace trace
@@ -0,0 +1,49 @@
+// trace.h — scoped timing spans exported as Chrome trace JSON
+
+#pragma once
+
+#include <glib.h>
+#include <atomic>
+#include <string>
+
+// Spans are written into a fixed ring per thread (single writer, no locks);
+// when a ring is full the oldest spans are overwritten. While tracing is off
+// a span costs one relaxed atomic load. The rings can be dumped at any time
+// as Chrome trace JSON ("X" events), which Perfetto and chrome://tracing open.
+//
+// Setting COLOSSUS_TRACE=<file> turns tracing on from startup and writes the
+// trace to that file when the editor exits.
+namespace trace {
+
+extern std::atomic<bool> g_enabled;
+
+inline bool enabled() { return g_enabled.load(std::memory_order_relaxed); }
+void set_enabled(bool on);
+
+// Reads COLOSSUS_TRACE; returns the file to dump to at exit, or "".
+std::string init_from_env();
+
+// Writes every ring as trace JSON; false with error set on failure.
+bool dump(const std::string& path, std::string* error);
+
+void record(const char* name, gint64 start_us, gint64 end_us);
+
+// name must outlive the trace (a string literal).
+class Span {
+public:
+    explicit Span(const char* name) : name_(enabled() ? name : nullptr) {
+        if (name_) start_ = g_get_monotonic_time();
+    }
+    ~Span() {
+        if (name_) record(name_, start_, g_get_monotonic_time());
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    const char* name_;
+    gint64 start_ = 0;
+};
+
+} // namespace trace
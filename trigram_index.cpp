@@ -0,0 +1,500 @@
+// trigram_index.cpp — persistent, memory-mapped trigram index for project search
+
+#include "trigram_index.h"
+
+#include <glib/gstdio.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <queue>
+#include <utility>
+
+namespace {
+
+static const char kMagic[8] = { 'C', 'L', 'T', 'R', 'I', 'D', 'X', '1' };
+static const uint32_t kVersion = 1;
+
+// files larger than this are left out of the index (and of project search)
+static const guint64 kMaxFileBytes = 16ull << 20;
+static const uint32_t kTrigramSpace = 1u << 24;
+
+struct IndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t n_files;
+    uint32_t n_trigrams;
+    uint32_t root_len;
+    uint64_t files_off;
+    uint64_t strings_off;
+    uint64_t strings_len;
+    uint64_t postings_off;
+    uint64_t table_off;
+};
+
+struct FileEntry {
+    uint64_t mtime_us;
+    uint64_t size;
+    uint64_t path_off;     // relative to strings_off
+    uint32_t path_len;
+    uint32_t pad;
+};
+
+struct TrigramEntry {
+    uint32_t trigram;
+    uint32_t count;
+    uint64_t first;        // index into the uint32 postings array
+};
+
+static inline unsigned char ascii_lower(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c - 'A' + 'a') : c;
+}
+
+static inline uint32_t make_trigram(const unsigned char* p) {
+    return ((uint32_t)ascii_lower(p[0]) << 16) |
+           ((uint32_t)ascii_lower(p[1]) << 8) |
+            (uint32_t)ascii_lower(p[2]);
+}
+
+static bool write_all(FILE* f, const void* data, size_t len) {
+    return len == 0 || std::fwrite(data, 1, len, f) == len;
+}
+
+static bool write_padding(FILE* f, uint64_t* pos) {
+    static const char zeros[8] = {};
+    size_t pad = (size_t)((8 - (*pos % 8)) % 8);
+    *pos += pad;
+    return write_all(f, zeros, pad);
+}
+
+// Sorted run of (trigram << 32 | file id) pairs spilled to disk.
+class RunReader {
+public:
+    explicit RunReader(const std::string& path) : f_(std::fopen(path.c_str(), "rb")) {}
+    ~RunReader() { if (f_) std::fclose(f_); }
+
+    bool next(uint64_t* out) {
+        if (pos_ == buf_.size()) {
+            if (!f_) return false;
+            buf_.resize(1 << 16);
+            size_t n = std::fread(buf_.data(), sizeof(uint64_t), buf_.size(), f_);
+            buf_.resize(n);
+            pos_ = 0;
+            if (n == 0) return false;
+        }
+        *out = buf_[pos_++];
+        return true;
+    }
+
+private:
+    FILE* f_;
+    std::vector<uint64_t> buf_;
+    size_t pos_ = 0;
+};
+
+// Streams sorted pairs into the postings section and collects the table.
+class PostingsWriter {
+public:
+    explicit PostingsWriter(FILE* f) : f_(f) {}
+
+    bool add(uint64_t pair) {
+        uint32_t tri = (uint32_t)(pair >> 32);
+        uint32_t id = (uint32_t)(pair & 0xffffffffu);
+        if (table.empty() || table.back().trigram != tri)
+            table.push_back(TrigramEntry{ tri, 0, written_ });
+        table.back().count++;
+        buf_.push_back(id);
+        ++written_;
+        return buf_.size() < (1 << 16) || flush();
+    }
+
+    bool flush() {
+        bool ok = write_all(f_, buf_.data(), buf_.size() * sizeof(uint32_t));
+        buf_.clear();
+        return ok;
+    }
+
+    uint64_t bytes() const { return written_ * sizeof(uint32_t); }
+
+    std::vector<TrigramEntry> table;
+
+private:
+    FILE* f_;
+    std::vector<uint32_t> buf_;
+    uint64_t written_ = 0;
+};
+
+static const char* const kSkipDirs[] = { "node_modules", "__pycache__" };
+
+static const char* const kBinaryExts[] = {
+    "o", "a", "so", "obj", "lib", "dll", "exe", "bin", "class", "jar", "pyc",
+    "png", "jpg", "jpeg", "gif", "bmp", "ico", "webp", "pdf", "woff", "woff2",
+    "ttf", "otf", "zip", "gz", "xz", "bz2", "zst", "tar", "7z", "mp3", "mp4",
+    "ogg", "wav", "flac", "mkv", "webm", "iso", "gresource",
+};
+
+} // namespace
+
+TrigramIndex::~TrigramIndex() {
+    close();
+}
+
+void TrigramIndex::close() {
+    if (mapped_) {
+        g_mapped_file_unref(mapped_);
+        mapped_ = nullptr;
+    }
+    root_.clear();
+}
+
+bool TrigramIndex::load(const std::string& index_path, const std::string& root) {
+    close();
+
+    GError* err = nullptr;
+    GMappedFile* mf = g_mapped_file_new(index_path.c_str(), FALSE, &err);
+    if (!mf) {
+        if (err) g_error_free(err);
+        return false;
+    }
+
+    const char* base = g_mapped_file_get_contents(mf);
+    const uint64_t size = g_mapped_file_get_length(mf);
+    const IndexHeader* h = (const IndexHeader*)base;
+
+    bool ok = base && size >= sizeof(IndexHeader) &&
+              std::memcmp(h->magic, kMagic, sizeof(kMagic)) == 0 &&
+              h->version == kVersion &&
+              h->files_off + (uint64_t)h->n_files * sizeof(FileEntry) <= size &&
+              h->strings_off + h->strings_len <= size &&
+              h->root_len <= h->strings_len &&
+              h->table_off + (uint64_t)h->n_trigrams * sizeof(TrigramEntry) <= size &&
+              h->postings_off <= h->table_off;
+
+    if (ok) ok = root.size() == h->root_len &&
+                 std::memcmp(base + h->strings_off, root.data(), root.size()) == 0;
+
+    if (!ok) {
+        g_mapped_file_unref(mf);
+        return false;
+    }
+
+    mapped_ = mf;
+    root_ = root;
+    return true;
+}
+
+size_t TrigramIndex::file_count() const {
+    if (!mapped_) return 0;
+    return ((const IndexHeader*)g_mapped_file_get_contents(mapped_))->n_files;
+}
+
+size_t TrigramIndex::mapped_bytes() const {
+    return mapped_ ? g_mapped_file_get_length(mapped_) : 0;
+}
+
+std::vector<TrigramIndex::FileInfo> TrigramIndex::files() const {
+    std::vector<FileInfo> out;
+    if (!mapped_) return out;
+
+    const char* base = g_mapped_file_get_contents(mapped_);
+    const IndexHeader* h = (const IndexHeader*)base;
+    const FileEntry* entries = (const FileEntry*)(base + h->files_off);
+    out.reserve(h->n_files);
+    for (uint32_t id = 0; id < h->n_files; ++id)
+        out.push_back(FileInfo{ file_path(id), entries[id].mtime_us });
+    return out;
+}
+
+std::string TrigramIndex::file_path(uint32_t id) const {
+    const char* base = g_mapped_file_get_contents(mapped_);
+    const IndexHeader* h = (const IndexHeader*)base;
+    const FileEntry* files = (const FileEntry*)(base + h->files_off);
+    const FileEntry& fe = files[id];
+    if (fe.path_off + fe.path_len > h->strings_len) return std::string();
+    return root_ + "/" + std::string(base + h->strings_off + fe.path_off, fe.path_len);
+}
+
+std::vector<std::string> TrigramIndex::candidates(const std::string& needle) const {
+    std::vector<std::string> out;
+    if (!mapped_) return out;
+
+    const char* base = g_mapped_file_get_contents(mapped_);
+    const IndexHeader* h = (const IndexHeader*)base;
+    const TrigramEntry* table = (const TrigramEntry*)(base + h->table_off);
+    const TrigramEntry* table_end = table + h->n_trigrams;
+    const uint32_t* postings = (const uint32_t*)(base + h->postings_off);
+    const uint64_t n_postings = (h->table_off - h->postings_off) / sizeof(uint32_t);
+
+    // Only all-ASCII trigrams are safe to narrow on: caseless matching of
+    // other characters may match different bytes than the needle's.
+    std::vector<uint32_t> tris;
+    const unsigned char* p = (const unsigned char*)needle.data();
+    for (size_t i = 0; i + 3 <= needle.size(); ++i) {
+        if (p[i] >= 0x80 || p[i + 1] >= 0x80 || p[i + 2] >= 0x80) continue;
+        tris.push_back(make_trigram(p + i));
+    }
+    std::sort(tris.begin(), tris.end());
+    tris.erase(std::unique(tris.begin(), tris.end()), tris.end());
+
+    if (tris.empty()) {
+        out.reserve(h->n_files);
+        for (uint32_t id = 0; id < h->n_files; ++id) out.push_back(file_path(id));
+        return out;
+    }
+
+    std::vector<const TrigramEntry*> lists;
+    for (uint32_t t : tris) {
+        const TrigramEntry* e = std::lower_bound(
+            table, table_end, t,
+            [](const TrigramEntry& a, uint32_t v) { return a.trigram < v; });
+        if (e == table_end || e->trigram != t) return out;   // no file has it
+        if (e->first + e->count > n_postings) return out;
+        lists.push_back(e);
+    }
+
+    std::sort(lists.begin(), lists.end(),
+              [](const TrigramEntry* a, const TrigramEntry* b) { return a->count < b->count; });
+
+    std::vector<uint32_t> ids(postings + lists[0]->first,
+                              postings + lists[0]->first + lists[0]->count);
+    std::vector<uint32_t> next;
+    for (size_t i = 1; i < lists.size() && !ids.empty(); ++i) {
+        const uint32_t* b = postings + lists[i]->first;
+        next.clear();
+        std::set_intersection(ids.begin(), ids.end(), b, b + lists[i]->count,
+                              std::back_inserter(next));
+        ids.swap(next);
+    }
+
+    out.reserve(ids.size());
+    for (uint32_t id : ids) {
+        if (id < h->n_files) out.push_back(file_path(id));
+    }
+    return out;
+}
+
+bool TrigramIndex::is_indexable_name(const std::string& name) {
+    auto dot = name.find_last_of('.');
+    if (dot == std::string::npos) return true;
+
+    std::string ext = name.substr(dot + 1);
+    for (char& c : ext) c = (char)ascii_lower((unsigned char)c);
+    for (const char* b : kBinaryExts) {
+        if (ext == b) return false;
+    }
+    return true;
+}
+
+void TrigramIndex::walk(const std::string& root,
+                        std::vector<std::string>* files,
+                        std::vector<std::string>* dirs,
+                        GCancellable* cancel) {
+    std::vector<std::string> stack{ root };
+
+    while (!stack.empty()) {
+        if (cancel && g_cancellable_is_cancelled(cancel)) return;
+
+        std::string dir = stack.back();
+        stack.pop_back();
+
+        GDir* d = g_dir_open(dir.c_str(), 0, nullptr);
+        if (!d) continue;
+        if (dirs) dirs->push_back(dir);
+
+        while (const gchar* name = g_dir_read_name(d)) {
+            if (name[0] == '.') continue;
+
+            std::string path = dir + "/" + name;
+            GStatBuf st;
+            if (g_lstat(path.c_str(), &st) != 0) continue;
+
+            if (S_ISDIR(st.st_mode)) {
+                bool skip = false;
+                for (const char* s : kSkipDirs) skip = skip || std::strcmp(name, s) == 0;
+                if (!skip) stack.push_back(path);
+            } else if (S_ISREG(st.st_mode)) {
+                if ((guint64)st.st_size <= kMaxFileBytes && is_indexable_name(name))
+                    files->push_back(path);
+            }
+        }
+        g_dir_close(d);
+    }
+}
+
+TrigramIndex::BuildResult TrigramIndex::build(const std::string& root,
+                                              const std::string& index_path,
+                                              size_t memory_budget,
+                                              GCancellable* cancel) {
+    BuildResult r;
+
+    std::vector<std::string> paths;
+    walk(root, &paths, &r.dirs, cancel);
+    std::sort(paths.begin(), paths.end());
+
+    struct FileRec { uint64_t mtime_us; uint64_t size; std::string rel; };
+    std::vector<FileRec> recs;
+
+    const size_t max_pairs = std::max<size_t>(memory_budget / sizeof(uint64_t), 1 << 16);
+    std::vector<uint64_t> pairs;
+    std::vector<std::string> runs;
+
+    // per-file dedupe: 2 MiB bitmap plus the list of bits to clear afterwards
+    std::vector<uint8_t> seen(kTrigramSpace / 8, 0);
+    std::vector<uint32_t> file_tris;
+
+    auto cleanup_runs = [&]() {
+        for (const std::string& run : runs) g_remove(run.c_str());
+        runs.clear();
+    };
+
+    auto spill = [&]() -> bool {
+        std::sort(pairs.begin(), pairs.end());
+        std::string run = index_path + ".run" + std::to_string(runs.size());
+        FILE* f = std::fopen(run.c_str(), "wb");
+        if (!f) return false;
+        bool ok = write_all(f, pairs.data(), pairs.size() * sizeof(uint64_t));
+        ok = (std::fclose(f) == 0) && ok;
+        runs.push_back(run);
+        pairs.clear();
+        return ok;
+    };
+
+    for (const std::string& path : paths) {
+        if (cancel && g_cancellable_is_cancelled(cancel)) {
+            cleanup_runs();
+            r.error = "cancelled";
+            return r;
+        }
+
+        GStatBuf st;
+        if (g_stat(path.c_str(), &st) != 0 || (guint64)st.st_size > kMaxFileBytes) continue;
+
+        gchar* data = nullptr;
+        gsize len = 0;
+        if (!g_file_get_contents(path.c_str(), &data, &len, nullptr)) continue;
+
+        // skip binaries
+        if (std::memchr(data, 0, std::min<gsize>(len, 8192))) {
+            g_free(data);
+            continue;
+        }
+
+        const uint32_t id = (uint32_t)recs.size();
+        recs.push_back(FileRec{ (uint64_t)st.st_mtime * 1000000ull, (uint64_t)len,
+                                path.substr(root.size() + 1) });
+
+        const unsigned char* p = (const unsigned char*)data;
+        for (gsize i = 0; i + 3 <= len; ++i) {
+            uint32_t t = make_trigram(p + i);
+            uint8_t bit = (uint8_t)(1u << (t & 7));
+            if (seen[t >> 3] & bit) continue;
+            seen[t >> 3] |= bit;
+            file_tris.push_back(t);
+        }
+        g_free(data);
+
+        for (uint32_t t : file_tris) {
+            pairs.push_back(((uint64_t)t << 32) | id);
+            seen[t >> 3] = 0;
+        }
+        file_tris.clear();
+
+        if (pairs.size() >= max_pairs && !spill()) {
+            cleanup_runs();
+            r.error = "could not write index run file";
+            return r;
+        }
+    }
+
+    if (!runs.empty() && !pairs.empty() && !spill()) {
+        cleanup_runs();
+        r.error = "could not write index run file";
+        return r;
+    }
+    r.spilled_runs = runs.size();
+
+    // ── write: header | files | strings | postings | table ──
+    std::string tmp = index_path + ".tmp";
+    FILE* out = std::fopen(tmp.c_str(), "wb");
+    if (!out) {
+        cleanup_runs();
+        r.error = "could not create " + tmp;
+        return r;
+    }
+
+    IndexHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kVersion;
+    h.n_files = (uint32_t)recs.size();
+    h.root_len = (uint32_t)root.size();
+
+    uint64_t pos = sizeof(IndexHeader);
+    bool ok = write_all(out, &h, sizeof(h));
+
+    h.files_off = pos;
+    uint64_t path_off = root.size();
+    for (const FileRec& fr : recs) {
+        FileEntry fe{ fr.mtime_us, fr.size, path_off, (uint32_t)fr.rel.size(), 0 };
+        ok = ok && write_all(out, &fe, sizeof(fe));
+        path_off += fr.rel.size();
+    }
+    pos += recs.size() * sizeof(FileEntry);
+
+    h.strings_off = pos;
+    ok = ok && write_all(out, root.data(), root.size());
+    for (const FileRec& fr : recs) ok = ok && write_all(out, fr.rel.data(), fr.rel.size());
+    h.strings_len = path_off;
+    pos += path_off;
+    ok = ok && write_padding(out, &pos);
+
+    h.postings_off = pos;
+    PostingsWriter pw(out);
+
+    if (runs.empty()) {
+        std::sort(pairs.begin(), pairs.end());
+        for (uint64_t v : pairs) ok = ok && pw.add(v);
+    } else {
+        // k-way merge of the spilled runs
+        std::vector<std::unique_ptr<RunReader>> readers;
+        using Head = std::pair<uint64_t, size_t>;
+        std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heap;
+        for (size_t i = 0; i < runs.size(); ++i) {
+            readers.emplace_back(new RunReader(runs[i]));
+            uint64_t v;
+            if (readers.back()->next(&v)) heap.push(Head(v, i));
+        }
+        while (!heap.empty() && ok) {
+            Head top = heap.top();
+            heap.pop();
+            ok = pw.add(top.first);
+            uint64_t v;
+            if (readers[top.second]->next(&v)) heap.push(Head(v, top.second));
+        }
+    }
+    std::vector<uint64_t>().swap(pairs);
+    ok = ok && pw.flush();
+    pos += pw.bytes();
+    ok = ok && write_padding(out, &pos);
+
+    h.table_off = pos;
+    h.n_trigrams = (uint32_t)pw.table.size();
+    ok = ok && write_all(out, pw.table.data(), pw.table.size() * sizeof(TrigramEntry));
+
+    ok = ok && std::fseek(out, 0, SEEK_SET) == 0 && write_all(out, &h, sizeof(h));
+    ok = (std::fclose(out) == 0) && ok;
+    cleanup_runs();
+
+    if (!ok || g_rename(tmp.c_str(), index_path.c_str()) != 0) {
+        g_remove(tmp.c_str());
+        r.error = "could not write " + index_path;
+        return r;
+    }
+
+    r.files = recs.size();
+    r.trigrams = h.n_trigrams;
+    return r;
+}
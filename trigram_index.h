@@ -0,0 +1,73 @@
+// trigram_index.h — persistent, memory-mapped trigram index for project search
+
+#pragma once
+
+#include <gio/gio.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One index per project root. Every indexable file contributes the set of
+// (ASCII-lowercased) byte trigrams it contains; a query is narrowed to the
+// files whose posting lists contain every trigram of the needle, and the
+// caller verifies those few candidates for real matches.
+//
+// The on-disk file is laid out so it can be used straight from a read-only
+// mapping: no parsing happens on load beyond a header check.
+class TrigramIndex {
+public:
+    struct BuildResult {
+        size_t files = 0;
+        size_t trigrams = 0;
+        size_t spilled_runs = 0;           // > 0 when the memory budget forced spills
+        std::vector<std::string> dirs;     // directories walked (for watchers)
+        std::string error;
+    };
+
+    TrigramIndex() = default;
+    ~TrigramIndex();
+
+    TrigramIndex(const TrigramIndex&) = delete;
+    TrigramIndex& operator=(const TrigramIndex&) = delete;
+
+    // Maps an index written by build(). Returns false if the file is missing,
+    // truncated, from another format version or for another root.
+    bool load(const std::string& index_path, const std::string& root);
+    void close();
+
+    bool loaded() const { return mapped_ != nullptr; }
+    const std::string& root() const { return root_; }
+    size_t file_count() const;
+    size_t mapped_bytes() const;
+
+    // Absolute path and mtime of every indexed file, for staleness checks.
+    struct FileInfo { std::string path; guint64 mtime_us; };
+    std::vector<FileInfo> files() const;
+
+    // Files (absolute paths) that may contain needle, compared caselessly.
+    // Needles shorter than three bytes cannot be narrowed and return every file.
+    std::vector<std::string> candidates(const std::string& needle) const;
+
+    // Walks root, indexes every text file and atomically replaces index_path.
+    // Blocking; meant for a worker thread. Posting pairs are kept in memory up
+    // to memory_budget bytes, then spilled to sorted run files and merged.
+    static BuildResult build(const std::string& root,
+                             const std::string& index_path,
+                             size_t memory_budget,
+                             GCancellable* cancel);
+
+    // Directory listing shared with the non-indexed scan path.
+    static void walk(const std::string& root,
+                     std::vector<std::string>* files,
+                     std::vector<std::string>* dirs,
+                     GCancellable* cancel);
+
+    static bool is_indexable_name(const std::string& name);
+
+private:
+    GMappedFile* mapped_ = nullptr;
+    std::string root_;
+
+    std::string file_path(uint32_t id) const;
+};
@@ -0,0 +1,70 @@
+// ui_scheduler.cpp — coalesces UI refreshes to at most one per frame
+
+#include "ui_scheduler.h"
+
+#include <utility>
+
+UiScheduler::~UiScheduler() {
+    cancel();
+    if (owner_) g_object_remove_weak_pointer(G_OBJECT(owner_), (gpointer*)&owner_);
+}
+
+void UiScheduler::attach(GtkWidget* owner, FlushFunc flush) {
+    cancel();
+    if (owner_) g_object_remove_weak_pointer(G_OBJECT(owner_), (gpointer*)&owner_);
+    owner_ = owner;
+    if (owner_) g_object_add_weak_pointer(G_OBJECT(owner_), (gpointer*)&owner_);
+    flush_ = std::move(flush);
+}
+
+void UiScheduler::cancel() {
+    if (tick_id_ && owner_) gtk_widget_remove_tick_callback(owner_, tick_id_);
+    tick_id_ = 0;
+    if (idle_id_) g_source_remove(idle_id_);
+    idle_id_ = 0;
+}
+
+void UiScheduler::mark(unsigned bits) {
+    dirty_ |= bits;
+    if (!dirty_ || tick_id_ || idle_id_ || !flush_) return;
+
+    if (owner_ && gtk_widget_get_mapped(owner_)) {
+        tick_id_ = gtk_widget_add_tick_callback(owner_, UiScheduler::s_on_tick, this, nullptr);
+    } else {
+        idle_id_ = g_idle_add_full(G_PRIORITY_HIGH_IDLE, UiScheduler::s_on_idle, this, nullptr);
+    }
+}
+
+void UiScheduler::flush() {
+    cancel();
+    if (!dirty_ || !flush_) return;
+    const unsigned dirty = dirty_;
+    dirty_ = 0;         // the flush may mark again; that lands in the next frame
+    flush_(dirty);
+}
+
+void UiScheduler::set_label(GtkWidget* label, std::string* cache, const std::string& text) {
+    if (!label || *cache == text) return;
+    *cache = text;
+    gtk_label_set_text(GTK_LABEL(label), text.c_str());
+}
+
+void UiScheduler::set_title(GtkWidget* window, std::string* cache, const std::string& text) {
+    if (!window || *cache == text) return;
+    *cache = text;
+    gtk_window_set_title(GTK_WINDOW(window), text.c_str());
+}
+
+gboolean UiScheduler::s_on_tick(GtkWidget*, GdkFrameClock*, gpointer ud) {
+    UiScheduler* self = static_cast<UiScheduler*>(ud);
+    self->tick_id_ = 0;
+    self->flush();
+    return G_SOURCE_REMOVE;
+}
+
+gboolean UiScheduler::s_on_idle(gpointer ud) {
+    UiScheduler* self = static_cast<UiScheduler*>(ud);
+    self->idle_id_ = 0;
+    self->flush();
+    return G_SOURCE_REMOVE;
+}
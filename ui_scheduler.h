@@ -0,0 +1,46 @@
+// ui_scheduler.h — coalesces UI refreshes to at most one per frame
+
+#pragma once
+
+#include <gtk/gtk.h>
+#include <functional>
+#include <string>
+
+// Parts of the UI mark themselves dirty as often as they like; one callback
+// on the owner widget's frame clock hands the accumulated bits to the flush
+// function before the next frame is painted. Until the widget is mapped (no
+// frame clock yet) an idle source stands in.
+class UiScheduler {
+public:
+    using FlushFunc = std::function<void(unsigned dirty)>;
+
+    UiScheduler() = default;
+    ~UiScheduler();
+
+    UiScheduler(const UiScheduler&) = delete;
+    UiScheduler& operator=(const UiScheduler&) = delete;
+
+    void attach(GtkWidget* owner, FlushFunc flush);
+
+    void mark(unsigned bits);
+    bool pending(unsigned bits) const { return (dirty_ & bits) != 0; }
+
+    // Runs the flush now if anything is dirty (before blocking work, on exit).
+    void flush();
+
+    // Setters that skip the widget call when the text is unchanged; the
+    // cache holds the last text applied.
+    static void set_label(GtkWidget* label, std::string* cache, const std::string& text);
+    static void set_title(GtkWidget* window, std::string* cache, const std::string& text);
+
+private:
+    GtkWidget* owner_ = nullptr;
+    FlushFunc flush_;
+    unsigned dirty_ = 0;
+    guint tick_id_ = 0;
+    guint idle_id_ = 0;
+
+    void cancel();
+    static gboolean s_on_tick(GtkWidget* widget, GdkFrameClock* clock, gpointer ud);
+    static gboolean s_on_idle(gpointer ud);
+};
@@ -0,0 +1,279 @@
+// undo_history.cpp — undo and redo that the documents of a window take turns with
+
+#include "undo_history.h"
+
+#include <cstring>
+#include <utility>
+
+namespace {
+
+// The GtkSourceUndoManager the buffer holds; it forwards to the history,
+// and does nothing once that is gone.
+struct UndoStore {
+    GObject parent;
+    UndoHistory* owner;
+};
+
+static inline UndoStore* UNDO_STORE(gpointer p) {
+    return reinterpret_cast<UndoStore*>(p);
+}
+
+static void undo_store_init(GTypeInstance* instance, gpointer) {
+    UNDO_STORE(instance)->owner = nullptr;
+}
+
+static gboolean undo_store_can_undo(GtkSourceUndoManager* manager) {
+    UndoHistory* h = UNDO_STORE(manager)->owner;
+    return h && h->can_undo();
+}
+
+static gboolean undo_store_can_redo(GtkSourceUndoManager* manager) {
+    UndoHistory* h = UNDO_STORE(manager)->owner;
+    return h && h->can_redo();
+}
+
+static void undo_store_undo(GtkSourceUndoManager* manager) {
+    if (UndoHistory* h = UNDO_STORE(manager)->owner) h->undo();
+}
+
+static void undo_store_redo(GtkSourceUndoManager* manager) {
+    if (UndoHistory* h = UNDO_STORE(manager)->owner) h->redo();
+}
+
+static void undo_store_begin_not_undoable(GtkSourceUndoManager* manager) {
+    if (UndoHistory* h = UNDO_STORE(manager)->owner) h->begin_not_undoable();
+}
+
+static void undo_store_end_not_undoable(GtkSourceUndoManager* manager) {
+    if (UndoHistory* h = UNDO_STORE(manager)->owner) h->end_not_undoable();
+}
+
+static void undo_store_undo_manager_init(gpointer g_iface, gpointer) {
+    GtkSourceUndoManagerIface* iface = static_cast<GtkSourceUndoManagerIface*>(g_iface);
+    iface->can_undo = undo_store_can_undo;
+    iface->can_redo = undo_store_can_redo;
+    iface->undo = undo_store_undo;
+    iface->redo = undo_store_redo;
+    iface->begin_not_undoable_action = undo_store_begin_not_undoable;
+    iface->end_not_undoable_action = undo_store_end_not_undoable;
+}
+
+static GType undo_store_get_type() {
+    static GType type = 0;
+    if (!type) {
+        static const GTypeInfo info = {
+            sizeof(GObjectClass),
+            nullptr, nullptr,
+            nullptr,
+            nullptr, nullptr,
+            sizeof(UndoStore),
+            0,
+            undo_store_init,
+            nullptr,
+        };
+        type = g_type_register_static(G_TYPE_OBJECT, "ColossusUndoManager", &info, (GTypeFlags)0);
+
+        static const GInterfaceInfo undo_manager_info = { undo_store_undo_manager_init, nullptr, nullptr };
+        g_type_add_interface_static(type, GTK_SOURCE_TYPE_UNDO_MANAGER, &undo_manager_info);
+    }
+    return type;
+}
+
+static int char_count(const std::string& text) {
+    return (int)g_utf8_strlen(text.data(), (gssize)text.size());
+}
+
+static size_t group_bytes(const UndoHistory::Group& group) {
+    size_t n = 0;
+    for (const UndoHistory::Step& s : group) n += s.text.size();
+    return n;
+}
+
+} // namespace
+
+UndoHistory::UndoHistory(GtkSourceBuffer* buffer) : buffer_(GTK_TEXT_BUFFER(buffer)) {
+    UndoStore* store = UNDO_STORE(g_object_new(undo_store_get_type(), nullptr));
+    store->owner = this;
+    manager_ = G_OBJECT(store);
+
+    // before the default handlers, while the positions are the old text's
+    g_signal_connect(buffer_, "insert-text", G_CALLBACK(UndoHistory::s_on_insert_text), this);
+    g_signal_connect(buffer_, "delete-range", G_CALLBACK(UndoHistory::s_on_delete_range), this);
+    g_signal_connect(buffer_, "begin-user-action", G_CALLBACK(UndoHistory::s_on_begin_user_action), this);
+    g_signal_connect(buffer_, "end-user-action", G_CALLBACK(UndoHistory::s_on_end_user_action), this);
+    gtk_source_buffer_set_undo_manager(buffer, GTK_SOURCE_UNDO_MANAGER(manager_));
+}
+
+UndoHistory::~UndoHistory() {
+    g_signal_handlers_disconnect_by_data(buffer_, this);
+    // the buffer may hold the manager a moment longer
+    UNDO_STORE(manager_)->owner = nullptr;
+    g_object_unref(manager_);
+}
+
+UndoHistory::State UndoHistory::take() {
+    State out = std::move(state_);
+    state_ = State();
+    open_.clear();
+    can_join_ = false;
+    notify(!out.undo.empty(), !out.redo.empty());
+    return out;
+}
+
+void UndoHistory::restore(State state) {
+    const bool could_undo = can_undo(), could_redo = can_redo();
+    state_ = std::move(state);
+    open_.clear();
+    can_join_ = false;
+    notify(could_undo, could_redo);
+}
+
+void UndoHistory::begin_not_undoable() {
+    ++not_undoable_;
+}
+
+void UndoHistory::end_not_undoable() {
+    if (not_undoable_ == 0 || --not_undoable_ > 0) return;
+    restore(State());
+}
+
+// ───── recording ─────
+
+void UndoHistory::record(Step step) {
+    open_.push_back(std::move(step));
+    if (action_depth_ == 0) commit();
+}
+
+// The user action just ended becomes one undo step, or continues the last.
+void UndoHistory::commit() {
+    if (open_.empty()) return;
+    const bool could_undo = can_undo(), could_redo = can_redo();
+
+    for (const Group& g : state_.redo) state_.bytes -= group_bytes(g);
+    state_.redo.clear();
+    state_.bytes += group_bytes(open_);
+
+    const bool single = open_.size() == 1 && char_count(open_[0].text) == 1;
+    if (!(single && can_join_ && join(open_[0]))) {
+        state_.undo.push_back(std::move(open_));
+        const gint levels = gtk_source_buffer_get_max_undo_levels(GTK_SOURCE_BUFFER(buffer_));
+        while (levels >= 0 && state_.undo.size() > (size_t)levels) {
+            state_.bytes -= group_bytes(state_.undo.front());
+            state_.undo.pop_front();
+        }
+    }
+    open_.clear();
+    can_join_ = single;
+    notify(could_undo, could_redo);
+}
+
+// Typing or deleting a character at a time: the step continues the last
+// group when it lands right next to it, until a space follows a word.
+bool UndoHistory::join(const Step& step) {
+    if (state_.undo.empty() || state_.undo.back().size() != 1) return false;
+    Step& last = state_.undo.back()[0];
+    if (last.insert != step.insert) return false;
+
+    const bool backspace = !step.insert && step.offset + 1 == last.offset;
+    const char* p = last.text.c_str();
+    const gunichar neighbour = backspace ? g_utf8_get_char(p) : g_utf8_get_char(g_utf8_prev_char(p + last.text.size()));
+    if (g_unichar_isspace(g_utf8_get_char(step.text.c_str())) && !g_unichar_isspace(neighbour)) return false;
+
+    if (step.insert) {
+        if (step.offset != last.offset + char_count(last.text)) return false;
+        last.text += step.text;
+    } else if (backspace) {
+        last.text.insert(0, step.text);
+        last.offset = step.offset;
+    } else if (step.offset == last.offset) {
+        last.text += step.text;              // Delete, forwards
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// ───── undo and redo ─────
+
+void UndoHistory::undo() {
+    if (state_.undo.empty()) return;
+    const bool could_redo = can_redo();
+    Group group = std::move(state_.undo.back());
+    state_.undo.pop_back();
+    apply(group, true);
+    state_.redo.push_back(std::move(group));
+    can_join_ = false;
+    notify(true, could_redo);
+}
+
+void UndoHistory::redo() {
+    if (state_.redo.empty()) return;
+    const bool could_undo = can_undo();
+    Group group = std::move(state_.redo.back());
+    state_.redo.pop_back();
+    apply(group, false);
+    state_.undo.push_back(std::move(group));
+    can_join_ = false;
+    notify(could_undo, true);
+}
+
+// Replays a group, or reverses it back to front; the cursor ends up where
+// the last change was made.
+void UndoHistory::apply(const Group& group, bool backwards) {
+    applying_ = true;
+    gtk_text_buffer_begin_user_action(buffer_);
+    int cursor = 0;
+    const size_t n = group.size();
+    for (size_t k = 0; k < n; ++k) {
+        const Step& s = group[backwards ? n - 1 - k : k];
+        GtkTextIter at;
+        gtk_text_buffer_get_iter_at_offset(buffer_, &at, s.offset);
+        if (s.insert != backwards) {
+            gtk_text_buffer_insert(buffer_, &at, s.text.data(), (gint)s.text.size());
+            cursor = s.offset + char_count(s.text);
+        } else {
+            GtkTextIter end = at;
+            gtk_text_iter_forward_chars(&end, char_count(s.text));
+            gtk_text_buffer_delete(buffer_, &at, &end);
+            cursor = s.offset;
+        }
+    }
+    gtk_text_buffer_end_user_action(buffer_);
+    applying_ = false;
+
+    GtkTextIter at;
+    gtk_text_buffer_get_iter_at_offset(buffer_, &at, cursor);
+    gtk_text_buffer_place_cursor(buffer_, &at);
+}
+
+void UndoHistory::notify(bool could_undo, bool could_redo) {
+    GtkSourceUndoManager* manager = GTK_SOURCE_UNDO_MANAGER(manager_);
+    if (could_undo != can_undo()) gtk_source_undo_manager_can_undo_changed(manager);
+    if (could_redo != can_redo()) gtk_source_undo_manager_can_redo_changed(manager);
+}
+
+// ───── signals ─────
+
+void UndoHistory::s_on_insert_text(GtkTextBuffer*, GtkTextIter* at, gchar* text, gint len, gpointer ud) {
+    UndoHistory* self = static_cast<UndoHistory*>(ud);
+    if (self->applying_ || self->not_undoable_ > 0) return;
+    const size_t bytes = len < 0 ? std::strlen(text) : (size_t)len;
+    if (bytes) self->record(Step{ gtk_text_iter_get_offset(at), true, std::string(text, bytes) });
+}
+
+void UndoHistory::s_on_delete_range(GtkTextBuffer* buffer, GtkTextIter* start, GtkTextIter* end, gpointer ud) {
+    UndoHistory* self = static_cast<UndoHistory*>(ud);
+    if (self->applying_ || self->not_undoable_ > 0 || gtk_text_iter_equal(start, end)) return;
+    gchar* text = gtk_text_buffer_get_slice(buffer, start, end, TRUE);
+    self->record(Step{ gtk_text_iter_get_offset(start), false, text });
+    g_free(text);
+}
+
+void UndoHistory::s_on_begin_user_action(GtkTextBuffer*, gpointer ud) {
+    ++static_cast<UndoHistory*>(ud)->action_depth_;
+}
+
+void UndoHistory::s_on_end_user_action(GtkTextBuffer*, gpointer ud) {
+    UndoHistory* self = static_cast<UndoHistory*>(ud);
+    if (self->action_depth_ > 0 && --self->action_depth_ == 0) self->commit();
+}
@@ -0,0 +1,77 @@
+// undo_history.h — undo and redo that the documents of a window take turns with
+
+#pragma once
+
+#include <gtk/gtk.h>
+#include <gtksourceview/gtksource.h>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+// The buffer's undo manager. GtkSourceView's own keeps its history inside
+// the buffer and forgets it whenever the text is replaced, which a tab
+// switch does; this one hands the history out with take() when a document
+// goes to the background and gets it back with restore() when the same
+// text is shown again. Each user action is one undo step, and typing or
+// deleting character by character is joined into words. Positions are
+// character offsets. Text replaced inside a not-undoable action (a load)
+// clears the history, as GtkSourceView's does.
+class UndoHistory {
+public:
+    struct Step {
+        int offset;                          // characters
+        bool insert;                         // else a deletion
+        std::string text;
+    };
+    using Group = std::vector<Step>;         // one user action, in order
+
+    // One document's history while another is shown.
+    struct State {
+        std::deque<Group> undo;              // oldest first
+        std::vector<Group> redo;             // next redo last
+        size_t bytes = 0;                    // text held by both
+    };
+
+    explicit UndoHistory(GtkSourceBuffer* buffer);
+    ~UndoHistory();
+
+    UndoHistory(const UndoHistory&) = delete;
+    UndoHistory& operator=(const UndoHistory&) = delete;
+
+    // The history so far, leaving this one empty.
+    State take();
+    // A history taken earlier, for exactly the text now in the buffer.
+    void restore(State state);
+
+    size_t memory_bytes() const { return state_.bytes; }
+
+    // GtkSourceUndoManager
+    bool can_undo() const { return !state_.undo.empty(); }
+    bool can_redo() const { return !state_.redo.empty(); }
+    void undo();
+    void redo();
+    void begin_not_undoable();
+    void end_not_undoable();
+
+private:
+    GtkTextBuffer* buffer_ = nullptr;
+    GObject* manager_ = nullptr;
+    State state_;
+    Group open_;                             // the user action in progress
+    int action_depth_ = 0;
+    int not_undoable_ = 0;
+    bool applying_ = false;                  // our own undo and redo edits
+    bool can_join_ = false;                  // the last group may take the next character
+
+    void record(Step step);
+    void commit();
+    bool join(const Step& step);
+    void apply(const Group& group, bool backwards);
+    void notify(bool could_undo, bool could_redo);
+
+    static void s_on_insert_text(GtkTextBuffer*, GtkTextIter*, gchar*, gint, gpointer);
+    static void s_on_delete_range(GtkTextBuffer*, GtkTextIter*, GtkTextIter*, gpointer);
+    static void s_on_begin_user_action(GtkTextBuffer*, gpointer);
+    static void s_on_end_user_action(GtkTextBuffer*, gpointer);
+};